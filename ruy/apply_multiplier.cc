@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "ruy/apply_multiplier.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
@@ -72,6 +73,17 @@ std::int32_t MultiplyByQuantizedMultiplier(std::int32_t x,
                              right_shift);
 }
 
+std::int32_t MultiplyByFloatMultiplier(std::int32_t x, float multiplier) {
+  float scaled = static_cast<float>(x) * multiplier;
+  // See the comment in apply_multiplier.h about the saturation bounds.
+  scaled = std::min(scaled, 1073741824.f);
+  scaled = std::max(scaled, -1073741824.f);
+  // std::nearbyint rounds according to the current rounding mode, which is
+  // round-to-nearest-even by default, matching the SIMD conversions used by
+  // optimized code paths.
+  return static_cast<std::int32_t>(std::nearbyint(scaled));
+}
+
 }  // namespace detail
 
 }  // namespace ruy
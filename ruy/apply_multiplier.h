@@ -25,14 +25,15 @@ namespace ruy {
 
 // Applies the quantized multiplier to the `*accum` accumulator value, if
 // applicable, that is, if AccumScalar==int32 and DstScalar!=int32. Otherwise,
-// does nothing.
+// does nothing. `channel` is the index of the destination row or column,
+// depending on MulParams::channel_dimension, for the per-channel multipliers.
 //
 // This is slow, portable, 'reference' code. It should only be used in
 // ReferenceMul and in Path::kStandardCpp. There isn't a point in optimizing it,
 // either. Fast paths have that multiplier work done as part of the kernel,
 // typically written in assembly anyway.
 template <typename MulParamsType>
-void ApplyMultiplier(const MulParamsType& mul_params, int row,
+void ApplyMultiplier(const MulParamsType& mul_params, int channel,
                      typename MulParamsType::AccumScalar* accum);
 
 namespace detail {
@@ -61,6 +62,14 @@ std::int32_t MultiplyByQuantizedMultiplier(std::int32_t x,
                                            std::int32_t quantized_multiplier,
                                            int shift);
 
+// Returns x * multiplier computed in single-precision float, rounded to the
+// nearest int32, breaking ties to even, and saturated to [-2^30, 2^30]. That
+// leaves room to add a destination zero point without overflow, and as
+// destinations are at most 16-bit here, saturated values are then clamped
+// the same as with the int32 range. This is the behavior of the optimized code
+// paths too, so results are bit-exact across paths.
+std::int32_t MultiplyByFloatMultiplier(std::int32_t x, float multiplier);
+
 // Helper to apply a fixed-point multiplier.  Only 'applicable' if AccumScalar
 // is int32 (i.e. in all cases except floating-point) and if the destination is
 // not int32 (i.e. unless the user wants to get raw accumulators).
@@ -80,6 +89,8 @@ struct ApplyMultiplierImpl<MulParamsType, false> {
   static void Run(const MulParamsType& mul_params, int, AccumScalar*) {
     RUY_DCHECK_EQ(mul_params.multiplier_fixedpoint(), 0);
     RUY_DCHECK_EQ(mul_params.multiplier_exponent(), 0);
+    RUY_DCHECK_EQ(mul_params.multiplier_float(), 0);
+    RUY_DCHECK_EQ(mul_params.multiplier_float_perchannel(), nullptr);
   }
 };
 
@@ -87,13 +98,21 @@ template <typename MulParamsType>
 struct ApplyMultiplierImpl<MulParamsType, true> {
   using AccumScalar = typename MulParamsType::AccumScalar;
   using DstScalar = typename MulParamsType::DstScalar;
-  static void Run(const MulParamsType& mul_params, int row,
+  static void Run(const MulParamsType& mul_params, int channel,
                   AccumScalar* accum) {
+    if (mul_params.multiplier_float_perchannel() ||
+        mul_params.multiplier_float() != 0) {
+      float m = mul_params.multiplier_float_perchannel()
+                    ? mul_params.multiplier_float_perchannel()[channel]
+                    : mul_params.multiplier_float();
+      *accum = MultiplyByFloatMultiplier(*accum, m);
+      return;
+    }
     AccumScalar m = mul_params.multiplier_fixedpoint_perchannel()
-                        ? mul_params.multiplier_fixedpoint_perchannel()[row]
+                        ? mul_params.multiplier_fixedpoint_perchannel()[channel]
                         : mul_params.multiplier_fixedpoint();
     int e = mul_params.multiplier_exponent_perchannel()
-                ? mul_params.multiplier_exponent_perchannel()[row]
+                ? mul_params.multiplier_exponent_perchannel()[channel]
                 : mul_params.multiplier_exponent();
     *accum = MultiplyByQuantizedMultiplier(*accum, m, e);
   }
@@ -102,9 +121,9 @@ struct ApplyMultiplierImpl<MulParamsType, true> {
 }  // namespace detail
 
 template <typename MulParamsType>
-void ApplyMultiplier(const MulParamsType& mul_params, int row,
+void ApplyMultiplier(const MulParamsType& mul_params, int channel,
                      typename MulParamsType::AccumScalar* accum) {
-  detail::ApplyMultiplierImpl<MulParamsType>::Run(mul_params, row, accum);
+  detail::ApplyMultiplierImpl<MulParamsType>::Run(mul_params, channel, accum);
 }
 
 }  // namespace ruy
@@ -58,7 +58,7 @@ def ruy_copts_avx512():
 
 def ruy_copts_avx2():
     return select({
-        "//ruy:x86_64": ["-mavx2", "-mfma"],
+        "//ruy:x86_64": ["-mavx2", "-mfma", "-mf16c"],
         "//conditions:default": [],
     })
 
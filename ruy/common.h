@@ -59,7 +59,9 @@ void* ToVoidPtr(T* p) {
 
 template <typename Scalar>
 Scalar SymmetricZeroPoint() {
-  if (std::is_floating_point<Scalar>::value) {
+  // Not just std::is_floating_point, to include the 8-bit floating-point types
+  // of float8.h.
+  if (!std::numeric_limits<Scalar>::is_integer) {
     return 0;
   }
   if (std::is_signed<Scalar>::value) {
@@ -24,6 +24,8 @@ limitations under the License.
 
 namespace ruy {
 
+constexpr int Context::kAutoMaxNumThreads;
+
 Context::Context() : impl_(new CtxImpl) {}
 Context::~Context() { delete impl_; }
 
@@ -44,6 +46,18 @@ void Context::set_max_num_threads(int value) {
   mutable_ctx()->set_max_num_threads(value);
 }
 
+void Context::Warmup(int num_threads) { mutable_ctx()->Warmup(num_threads); }
+
+void* Context::AllocateArena(std::ptrdiff_t num_bytes) {
+  return mutable_ctx()->AllocateArena(num_bytes);
+}
+
+void Context::PrefetchPacked(const void* src_data) {
+  mutable_ctx()->PrefetchPacked(src_data);
+}
+
+void Context::BumpPackedEpoch() { mutable_ctx()->BumpPackedEpoch(); }
+
 void Context::ClearPrepackedCache() { mutable_ctx()->ClearPrepackedCache(); }
 
 }  // namespace ruy
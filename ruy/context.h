@@ -18,6 +18,7 @@ limitations under the License.
 #ifndef RUY_RUY_CONTEXT_H_
 #define RUY_RUY_CONTEXT_H_
 
+#include <cstddef>
 #include <cstdint>
 
 namespace ruy {
@@ -25,6 +26,8 @@ namespace ruy {
 class Ctx;
 class CtxImpl;
 class ThreadPool;
+template <typename Scalar>
+class Matrix;
 enum class Path : std::uint8_t;
 enum class Tuning;
 
@@ -43,9 +46,49 @@ class Context final {
   void set_explicit_tuning(Tuning value);
   const ThreadPool& thread_pool() const;
   ThreadPool* mutable_thread_pool();
+  // The maximum number of threads to use, including the calling thread.
+  // The default is 1. With kAutoMaxNumThreads, this is the number of CPUs
+  // available to this process, see AvailableCpuCount, which accounts for
+  // affinity masks and container CPU quotas. That is refreshed every second or
+  // so, and max_num_threads() then returns the current value.
   int max_num_threads() const;
   void set_max_num_threads(int value);
-
+  static constexpr int kAutoMaxNumThreads = 0;
+
+  // Eagerly does the one-time work that the first multi-threaded Mul would
+  // otherwise do: creating threads and their resources (allocators, tuning),
+  // touching their stacks, and detecting the CPU features. `num_threads`
+  // includes the calling thread; values <= 0 mean max_num_threads().
+  void Warmup(int num_threads = 0);
+
+  // Returns a buffer of at least `num_bytes` bytes, aligned to 64 bytes, for
+  // the arena of intermediate destinations planned by PlanArena. It is owned
+  // by this Context, and valid until the next call to AllocateArena. Calling
+  // this again with the same size, e.g. once per inference, returns the same
+  // buffer without allocating.
+  void* AllocateArena(std::ptrdiff_t num_bytes);
+
+  // Hints that a Mul following the next one will use the packed form of
+  // `matrix`, which must already be cached (see Matrix::set_cache_policy),
+  // e.g. as the weights of the next layer. The threads of the next Mul that
+  // are done with their share of its blocks, instead of idling until the
+  // other threads are done, then prefetch the start of that packed matrix into
+  // the shared cache. This has no effect if the next Mul is single-threaded.
+  template <typename Scalar>
+  void PrefetchPacked(const Matrix<Scalar>& matrix) {
+    PrefetchPacked(static_cast<const void*>(matrix.data()));
+  }
+  // Same, given the data pointer of the matrix.
+  void PrefetchPacked(const void* src_data);
+
+  // Starts a new epoch for matrices with CachePolicy::kCacheWithinEpoch:
+  // their packed forms are reused by the Muls of an epoch, e.g. when the same
+  // activations are multiplied by several weight matrices, and are repacked
+  // in the next epoch. Call this whenever such data may have changed, e.g.
+  // before each inference.
+  void BumpPackedEpoch();
+
+  // Clears the packed forms cached for all CachePolicy values.
   void ClearPrepackedCache();
 
  private:
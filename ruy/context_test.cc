@@ -15,9 +15,14 @@ limitations under the License.
 
 #include "ruy/context.h"
 
+#include <cstdint>
+#include <cstring>
+
+#include "ruy/cpu_count.h"
 #include "ruy/gtest_wrapper.h"
 #include "ruy/path.h"
 #include "ruy/prepacked_cache.h"
+#include "ruy/thread_pool.h"
 #include "ruy/tune.h"
 
 namespace ruy {
@@ -36,6 +41,36 @@ TEST(ContextTest, ContextClassSanity) {
   EXPECT_EQ(context.max_num_threads(), 2);
 }
 
+TEST(ContextTest, AutoMaxNumThreads) {
+  Context context;
+  context.set_max_num_threads(Context::kAutoMaxNumThreads);
+  EXPECT_EQ(context.max_num_threads(), AvailableCpuCount());
+  context.set_max_num_threads(3);
+  EXPECT_EQ(context.max_num_threads(), 3);
+}
+
+TEST(ContextTest, Warmup) {
+  Context context;
+  context.Warmup(4);
+  EXPECT_EQ(context.thread_pool().thread_count(), 3);
+  context.set_max_num_threads(2);
+  context.Warmup();
+  EXPECT_EQ(context.thread_pool().thread_count(), 3);
+}
+
+TEST(ContextTest, AllocateArena) {
+  Context context;
+  void* arena = context.AllocateArena(1000);
+  EXPECT_NE(arena, nullptr);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(arena) % 64, 0);
+  std::memset(arena, 0, 1000);
+  arena = context.AllocateArena(100000);
+  std::memset(arena, 0, 100000);
+  // Once large enough, the same buffer is returned.
+  EXPECT_EQ(context.AllocateArena(100000), arena);
+  EXPECT_EQ(context.AllocateArena(5000), arena);
+}
+
 }  // namespace
 }  // namespace ruy
 
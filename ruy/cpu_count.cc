@@ -0,0 +1,196 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ruy/cpu_count.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace ruy {
+
+namespace detail {
+
+int CpuCountFromCgroupV2CpuMax(const std::string& cpu_max) {
+  std::istringstream stream(cpu_max);
+  std::string max;
+  long long period = 0;
+  if (!(stream >> max >> period) || max == "max" || period <= 0) {
+    return 0;
+  }
+  return CpuCountFromCgroupV1Quota(std::atoll(max.c_str()), period);
+}
+
+int CpuCountFromCgroupV1Quota(long long quota_us, long long period_us) {
+  if (quota_us <= 0 || period_us <= 0) {
+    return 0;
+  }
+  return static_cast<int>((quota_us + period_us - 1) / period_us);
+}
+
+bool FindCgroupPath(const std::string& proc_self_cgroup,
+                    const std::string& controller, std::string* path) {
+  // Each line is "$ID:$CONTROLLERS:$PATH", where $CONTROLLERS is a
+  // comma-separated list for cgroup v1, and empty for cgroup v2.
+  std::istringstream stream(proc_self_cgroup);
+  std::string line;
+  while (std::getline(stream, line)) {
+    const std::size_t first_colon = line.find(':');
+    const std::size_t second_colon = line.find(':', first_colon + 1);
+    if (first_colon == std::string::npos ||
+        second_colon == std::string::npos) {
+      continue;
+    }
+    const std::string controllers =
+        line.substr(first_colon + 1, second_colon - first_colon - 1);
+    bool match = controllers.empty() && controller.empty();
+    std::istringstream controllers_stream(controllers);
+    std::string c;
+    while (!controller.empty() && std::getline(controllers_stream, c, ',')) {
+      match |= c == controller;
+    }
+    if (match) {
+      *path = line.substr(second_colon + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace detail
+
+namespace {
+
+#ifdef __linux__
+
+bool ReadFile(const std::string& filename, std::string* contents) {
+  FILE* file = fopen(filename.c_str(), "r");
+  if (!file) {
+    return false;
+  }
+  contents->clear();
+  char buf[256];
+  std::size_t size;
+  while ((size = fread(buf, 1, sizeof(buf), file)) > 0) {
+    contents->append(buf, size);
+  }
+  fclose(file);
+  return true;
+}
+
+int CpuCountFromAffinity() {
+  // Sized for the number of configured CPUs, which may exceed CPU_SETSIZE.
+  const int max_cpus =
+      std::max<int>(CPU_SETSIZE, std::thread::hardware_concurrency());
+  cpu_set_t* set = CPU_ALLOC(max_cpus);
+  if (!set) {
+    return 0;
+  }
+  const std::size_t set_size = CPU_ALLOC_SIZE(max_cpus);
+  int count = 0;
+  if (sched_getaffinity(0, set_size, set) == 0) {
+    count = CPU_COUNT_S(set_size, set);
+  }
+  CPU_FREE(set);
+  return count;
+}
+
+// Returns the smallest CPU quota of the given cgroup directory and its
+// ancestors up to the root of the hierarchy, which is mounted at `mount`, or
+// 0 if there is no quota.
+template <typename ReadQuotaFn>
+int CpuCountFromCgroupHierarchy(const std::string& mount, std::string path,
+                                const ReadQuotaFn& read_quota) {
+  int result = 0;
+  while (true) {
+    const int count = read_quota(mount + path);
+    if (count > 0) {
+      result = result ? std::min(result, count) : count;
+    }
+    if (path.empty() || path == "/") {
+      return result;
+    }
+    path = path.substr(0, path.find_last_of('/'));
+  }
+}
+
+int CpuCountFromCgroups() {
+  std::string proc_self_cgroup;
+  if (!ReadFile("/proc/self/cgroup", &proc_self_cgroup)) {
+    return 0;
+  }
+  std::string path;
+  int result = 0;
+  if (detail::FindCgroupPath(proc_self_cgroup, "", &path)) {
+    result = CpuCountFromCgroupHierarchy(
+        "/sys/fs/cgroup", path, [](const std::string& dir) {
+          std::string cpu_max;
+          return ReadFile(dir + "/cpu.max", &cpu_max)
+                     ? detail::CpuCountFromCgroupV2CpuMax(cpu_max)
+                     : 0;
+        });
+  }
+  // Hybrid setups have both a cgroup v2 hierarchy, without controllers, and
+  // the cgroup v1 cpu controller.
+  if (!result && detail::FindCgroupPath(proc_self_cgroup, "cpu", &path)) {
+    // The cpu controller is usually mounted together with cpuacct.
+    for (const char* mount :
+         {"/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpu"}) {
+      result = CpuCountFromCgroupHierarchy(
+          mount, path, [](const std::string& dir) {
+            std::string quota;
+            std::string period;
+            if (!ReadFile(dir + "/cpu.cfs_quota_us", &quota) ||
+                !ReadFile(dir + "/cpu.cfs_period_us", &period)) {
+              return 0;
+            }
+            return detail::CpuCountFromCgroupV1Quota(
+                std::atoll(quota.c_str()), std::atoll(period.c_str()));
+          });
+      if (result) {
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+#endif  // __linux__
+
+}  // namespace
+
+int AvailableCpuCount() {
+  int count = std::thread::hardware_concurrency();
+#ifdef __linux__
+  const int affinity_count = CpuCountFromAffinity();
+  if (affinity_count > 0) {
+    count = affinity_count;
+  }
+  const int cgroup_count = CpuCountFromCgroups();
+  if (cgroup_count > 0) {
+    count = std::min(count, cgroup_count);
+  }
+#endif
+  return std::max(count, 1);
+}
+
+}  // namespace ruy
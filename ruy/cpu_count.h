@@ -0,0 +1,55 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef RUY_RUY_CPU_COUNT_H_
+#define RUY_RUY_CPU_COUNT_H_
+
+#include <string>
+
+namespace ruy {
+
+// Returns the number of CPUs that this process can usefully keep busy: the
+// number of CPUs in its affinity mask, further limited by the CPU bandwidth
+// quota of its cgroup (cgroup v1 cpu.cfs_quota_us or cgroup v2 cpu.max), as
+// set by container runtimes, rounded up. This is what
+// Context::kAutoMaxNumThreads uses. Always at least 1.
+//
+// This reads a few files under /proc and /sys, so callers should not call it
+// on every matrix multiplication. Outside of Linux, this falls back to
+// std::thread::hardware_concurrency().
+int AvailableCpuCount();
+
+namespace detail {
+
+// Helpers for AvailableCpuCount, exposed for testing.
+
+// Returns the number of CPUs allowed by a cgroup v2 cpu.max file with the
+// given contents ("$MAX $PERIOD"), rounded up, or 0 if there is no quota.
+int CpuCountFromCgroupV2CpuMax(const std::string& cpu_max);
+
+// Same for the cgroup v1 cpu.cfs_quota_us and cpu.cfs_period_us values.
+int CpuCountFromCgroupV1Quota(long long quota_us, long long period_us);
+
+// Finds the path of the cgroup of the given controller (e.g. "cpu"), or of the
+// cgroup v2 unified hierarchy if `controller` is empty, in the given contents
+// of /proc/self/cgroup.
+bool FindCgroupPath(const std::string& proc_self_cgroup,
+                    const std::string& controller, std::string* path);
+
+}  // namespace detail
+
+}  // namespace ruy
+
+#endif  // RUY_RUY_CPU_COUNT_H_
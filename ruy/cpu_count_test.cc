@@ -0,0 +1,68 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ruy/cpu_count.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "ruy/gtest_wrapper.h"
+
+namespace ruy {
+namespace {
+
+TEST(CpuCountTest, AvailableCpuCount) {
+  const int count = AvailableCpuCount();
+  EXPECT_GE(count, 1);
+  if (std::thread::hardware_concurrency() > 0) {
+    EXPECT_LE(count, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+}
+
+TEST(CpuCountTest, CgroupV2CpuMax) {
+  EXPECT_EQ(detail::CpuCountFromCgroupV2CpuMax("max 100000\n"), 0);
+  EXPECT_EQ(detail::CpuCountFromCgroupV2CpuMax("400000 100000\n"), 4);
+  EXPECT_EQ(detail::CpuCountFromCgroupV2CpuMax("150000 100000\n"), 2);
+  EXPECT_EQ(detail::CpuCountFromCgroupV2CpuMax("50000 100000\n"), 1);
+  EXPECT_EQ(detail::CpuCountFromCgroupV2CpuMax(""), 0);
+}
+
+TEST(CpuCountTest, CgroupV1Quota) {
+  EXPECT_EQ(detail::CpuCountFromCgroupV1Quota(-1, 100000), 0);
+  EXPECT_EQ(detail::CpuCountFromCgroupV1Quota(400000, 100000), 4);
+  EXPECT_EQ(detail::CpuCountFromCgroupV1Quota(250000, 100000), 3);
+}
+
+TEST(CpuCountTest, FindCgroupPath) {
+  const std::string hybrid =
+      "12:cpuset:/\n"
+      "4:cpu,cpuacct:/docker/abc\n"
+      "0::/user.slice\n";
+  std::string path;
+  EXPECT_TRUE(detail::FindCgroupPath(hybrid, "cpu", &path));
+  EXPECT_EQ(path, "/docker/abc");
+  EXPECT_TRUE(detail::FindCgroupPath(hybrid, "", &path));
+  EXPECT_EQ(path, "/user.slice");
+  EXPECT_FALSE(detail::FindCgroupPath(hybrid, "memory", &path));
+  EXPECT_FALSE(detail::FindCgroupPath("0::/\n", "cpu", &path));
+}
+
+}  // namespace
+}  // namespace ruy
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -15,15 +15,24 @@ limitations under the License.
 
 #include "ruy/ctx.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <functional>
+#include <vector>
 
+#include "ruy/allocator.h"
 #include "ruy/check_macros.h"
+#include "ruy/cpu_count.h"
 #include "ruy/cpuinfo.h"
 #include "ruy/ctx_impl.h"
 #include "ruy/have_built_path_for.h"
 #include "ruy/path.h"
 #include "ruy/platform.h"
 #include "ruy/prepacked_cache.h"
+#include "ruy/thread_pool.h"
+#include "ruy/time.h"
+#include "ruy/tune.h"
 
 namespace ruy {
 
@@ -31,17 +40,55 @@ const CtxImpl& Ctx::impl() const { return static_cast<const CtxImpl&>(*this); }
 CtxImpl* Ctx::mutable_impl() { return static_cast<CtxImpl*>(this); }
 
 Path Ctx::last_used_path() const { return impl().last_used_path_; }
+Path Ctx::last_trmul_path() const { return impl().last_trmul_path_; }
+void Ctx::set_last_trmul_path(Path value) {
+  mutable_impl()->last_trmul_path_ = value;
+}
 Tuning Ctx::explicit_tuning() const { return impl().explicit_tuning_; }
 void Ctx::set_explicit_tuning(Tuning value) {
   mutable_impl()->explicit_tuning_ = value;
 }
 const ThreadPool& Ctx::thread_pool() const { return impl().thread_pool_; }
 ThreadPool* Ctx::mutable_thread_pool() { return &mutable_impl()->thread_pool_; }
-int Ctx::max_num_threads() const { return impl().max_num_threads_; }
+int Ctx::max_num_threads() const {
+  const CtxImpl& impl = this->impl();
+  if (impl.max_num_threads_ > 0) {
+    return impl.max_num_threads_;
+  }
+  // Affinity masks and cgroup quotas can change while the process runs, e.g.
+  // when a container is resized, but they don't need to be re-read for every
+  // matrix multiplication.
+  const TimePoint now = CoarseNow();
+  if (!impl.auto_max_num_threads_ ||
+      now - impl.auto_max_num_threads_time_ > DurationFromSeconds(1)) {
+    impl.auto_max_num_threads_ = AvailableCpuCount();
+    impl.auto_max_num_threads_time_ = now;
+  }
+  return impl.auto_max_num_threads_;
+}
 void Ctx::set_max_num_threads(int value) {
   mutable_impl()->max_num_threads_ = value;
 }
 
+float Ctx::straggler_rate() const {
+  const CtxImpl& impl = this->impl();
+  if (impl.straggler_rate_ == 0) {
+    return 0;
+  }
+  // Halves every second, so that the thread count recovers once contention
+  // is gone, even if no multi-threaded TrMul runs in the meantime.
+  const float seconds = ToFloatSeconds(CoarseNow() - impl.straggler_rate_time_);
+  return impl.straggler_rate_ * std::exp2(-seconds);
+}
+void Ctx::UpdateStragglerRate(bool straggled, float weight) {
+  RUY_DCHECK_GT(weight, 0);
+  RUY_DCHECK_LE(weight, 1);
+  const float rate = straggler_rate() * (1 - weight) + (straggled ? weight : 0);
+  // Flushes to 0 so that straggler_rate() stays cheap without contention.
+  mutable_impl()->straggler_rate_ = rate < 1e-3f ? 0 : rate;
+  mutable_impl()->straggler_rate_time_ = CoarseNow();
+}
+
 void Ctx::SetRuntimeEnabledPaths(Path paths) {
   mutable_impl()->runtime_enabled_paths_ = paths | kNonArchPaths;
 }
@@ -131,6 +178,16 @@ Path Ctx::SelectPath(Path compiled_paths) {
 
 void Ctx::EnsureThreadSpecificResources(int thread_count) {
   auto& resources = mutable_impl()->thread_specific_resources_;
+  ThreadPool* thread_pool = mutable_thread_pool();
+  if (thread_pool->ReapIdleThreads(thread_count - 1)) {
+    // Frees the resources of the destroyed threads. Entry 0 is the main
+    // thread's.
+    const std::size_t needed_count =
+        std::max(thread_count, thread_pool->thread_count() + 1);
+    if (resources.size() > needed_count) {
+      resources.resize(needed_count);
+    }
+  }
   while (thread_count > static_cast<int>(resources.size())) {
     resources.emplace_back(new ThreadSpecificResource);
   }
@@ -163,6 +220,13 @@ PrepackedCache* Ctx::GetPrepackedCache() {
   return impl().prepacked_cache_.get();
 }
 
+EpochPackedCache* Ctx::GetEpochPackedCache() {
+  if (!impl().epoch_packed_cache_) {
+    mutable_impl()->epoch_packed_cache_.reset(new EpochPackedCache);
+  }
+  return impl().epoch_packed_cache_.get();
+}
+
 Tuning Ctx::GetMainThreadTuning() {
   EnsureThreadSpecificResources(1);
   TuningResolver* tuning_resolver = GetThreadSpecificTuningResolver(0);
@@ -170,6 +234,83 @@ Tuning Ctx::GetMainThreadTuning() {
   return tuning_resolver->Resolve();
 }
 
-void Ctx::ClearPrepackedCache() { mutable_impl()->prepacked_cache_ = nullptr; }
+void* Ctx::AllocateArena(std::ptrdiff_t num_bytes) {
+  if (!impl().arena_allocator_) {
+    mutable_impl()->arena_allocator_.reset(new Allocator);
+  }
+  Allocator* allocator = impl().arena_allocator_.get();
+  // Frees the previous arena. If the allocator's buffer is too small, the
+  // first AllocateBytes gets a separate block, which the second FreeAll
+  // replaces with a buffer large enough, that later calls will return again.
+  allocator->FreeAll();
+  allocator->AllocateBytes(num_bytes);
+  allocator->FreeAll();
+  return allocator->AllocateBytes(num_bytes);
+}
+
+void Ctx::PrefetchPacked(const void* src_data) {
+  mutable_impl()->packed_to_prefetch_src_data_ = src_data;
+}
+
+const PEMat* Ctx::TakePackedToPrefetch() {
+  const void* src_data = impl().packed_to_prefetch_src_data_;
+  mutable_impl()->packed_to_prefetch_src_data_ = nullptr;
+  if (!src_data || !impl().prepacked_cache_) {
+    return nullptr;
+  }
+  return impl().prepacked_cache_->Find(src_data);
+}
+
+namespace {
+
+// Run by each thread, including the main thread, in Ctx::Warmup.
+struct WarmupTask final : Task {
+  void Run() override {
+    // Stack pages are faulted in on first use. Kernels don't use much stack,
+    // but the rest of the first Mul on this thread would otherwise pay for it.
+    volatile char stack_bytes[16 * 1024];
+    for (std::size_t i = 0; i < sizeof(stack_bytes); i += 64) {
+      stack_bytes[i] = 0;
+    }
+    // On CPUs where tuning is auto-detected, this runs a small calibration
+    // benchmark on this thread, whose result is then cached.
+    tuning_resolver->SetTuning(tuning);
+    tuning_resolver->Resolve();
+    // Gets the first system allocation out of the way.
+    allocator->AllocateBytes(1024);
+    allocator->FreeAll();
+  }
+  Tuning tuning = Tuning::kAuto;
+  TuningResolver* tuning_resolver = nullptr;
+  Allocator* allocator = nullptr;
+};
+
+}  // namespace
+
+void Ctx::Warmup(int num_threads) {
+  const int thread_count = num_threads > 0 ? num_threads : max_num_threads();
+  GetRuntimeEnabledPaths();
+  GetMainAllocator();
+  EnsureThreadSpecificResources(thread_count);
+  std::vector<WarmupTask> tasks(thread_count);
+  for (int i = 0; i < thread_count; i++) {
+    tasks[i].tuning = explicit_tuning();
+    tasks[i].tuning_resolver = GetThreadSpecificTuningResolver(i);
+    tasks[i].allocator = GetThreadSpecificAllocator(i);
+  }
+  // Creates the threads, and waits for them to be ready.
+  mutable_thread_pool()->Execute(thread_count, tasks.data());
+}
+
+void Ctx::BumpPackedEpoch() {
+  if (impl().epoch_packed_cache_) {
+    mutable_impl()->epoch_packed_cache_->BumpEpoch();
+  }
+}
+
+void Ctx::ClearPrepackedCache() {
+  mutable_impl()->prepacked_cache_ = nullptr;
+  mutable_impl()->epoch_packed_cache_ = nullptr;
+}
 
 }  // namespace ruy
@@ -19,6 +19,7 @@ limitations under the License.
 #ifndef RUY_RUY_CTX_H_
 #define RUY_RUY_CTX_H_
 
+#include <cstddef>
 #include <cstdint>
 
 namespace ruy {
@@ -27,8 +28,10 @@ class CtxImpl;
 class ThreadPool;
 class Allocator;
 class TuningResolver;
+class EpochPackedCache;
 class PrepackedCache;
 class CpuInfo;
+struct PEMat;
 enum class Path : std::uint8_t;
 enum class Tuning;
 
@@ -42,10 +45,15 @@ enum class Tuning;
 class Ctx /* not final, subclassed by CtxImpl */ {
  public:
   Path last_used_path() const;
+  // The Path whose kernel the last TrMul ran. This differs from
+  // last_used_path() when PopulateTrMulParams fell back to Path::kStandardCpp.
+  Path last_trmul_path() const;
+  void set_last_trmul_path(Path value);
   Tuning explicit_tuning() const;
   void set_explicit_tuning(Tuning value);
   const ThreadPool& thread_pool() const;
   ThreadPool* mutable_thread_pool();
+  // See Context::max_num_threads. Values <= 0 mean kAutoMaxNumThreads.
   int max_num_threads() const;
   void set_max_num_threads(int value);
   CpuInfo* mutable_cpuinfo();
@@ -73,7 +81,26 @@ class Ctx /* not final, subclassed by CtxImpl */ {
   Allocator* GetThreadSpecificAllocator(int thread_index) const;
   Allocator* GetMainAllocator();
   PrepackedCache* GetPrepackedCache();
+  EpochPackedCache* GetEpochPackedCache();
   Tuning GetMainThreadTuning();
+  // Fraction, decaying over time, of recent multi-threaded TrMuls in which
+  // some thread started late, see TrMulTask. Used to reduce the thread count.
+  float straggler_rate() const;
+  // Folds the outcome of a multi-threaded TrMul into straggler_rate(), with
+  // the given weight in (0, 1].
+  void UpdateStragglerRate(bool straggled, float weight);
+  // See Context::Warmup.
+  void Warmup(int num_threads);
+  // See Context::AllocateArena.
+  void* AllocateArena(std::ptrdiff_t num_bytes);
+  // See Context::PrefetchPacked. Records `src_data` for the next TrMul.
+  void PrefetchPacked(const void* src_data);
+  // Returns the cached packed matrix to prefetch during the current TrMul, if
+  // any, and clears the request. Called once the current TrMul has done its
+  // own lookups in the PrepackedCache, as these may eject entries.
+  const PEMat* TakePackedToPrefetch();
+  // See Context::BumpPackedEpoch.
+  void BumpPackedEpoch();
   void ClearPrepackedCache();
 
  private:
@@ -29,6 +29,7 @@ limitations under the License.
 #include "ruy/path.h"
 #include "ruy/prepacked_cache.h"
 #include "ruy/thread_pool.h"
+#include "ruy/time.h"
 #include "ruy/tune.h"
 
 namespace ruy {
@@ -58,15 +59,30 @@ class CtxImpl final : public Ctx {
 
   // Single Path bit indicating which Path was used last.
   Path last_used_path_ = Path::kNone;
+  // See Ctx::last_trmul_path.
+  Path last_trmul_path_ = Path::kNone;
   Tuning explicit_tuning_ = Tuning::kAuto;
   ThreadPool thread_pool_;
   int max_num_threads_ = 1;
+  // Cached result of AvailableCpuCount, for Context::kAutoMaxNumThreads, and
+  // when it was last refreshed. 0 if not yet computed.
+  mutable int auto_max_num_threads_ = 0;
+  mutable TimePoint auto_max_num_threads_time_;
+  // See Ctx::straggler_rate. The value as of the last update, and its time.
+  float straggler_rate_ = 0;
+  TimePoint straggler_rate_time_;
   // Allocator for main thread work before invoking the threadpool.
   // Our simple Allocator does not allow reserving/allocating more blocks
   // while it's already in committed state, so the main thread needs both
   // this allocator, and its per-thread allocator.
   std::unique_ptr<Allocator> main_allocator_;
+  // Allocator for Context::AllocateArena, which holds one allocation at a
+  // time, across Muls.
+  std::unique_ptr<Allocator> arena_allocator_;
   std::unique_ptr<PrepackedCache> prepacked_cache_;
+  std::unique_ptr<EpochPackedCache> epoch_packed_cache_;
+  // See Ctx::PrefetchPacked. Null if there is no request.
+  const void* packed_to_prefetch_src_data_ = nullptr;
   // Set of Paths enabled at runtime. By default, that is based on runtime
   // detection, but may be overridden. The initial value kNone
   // means that detection has not yet been performed.
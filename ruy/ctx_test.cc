@@ -67,6 +67,23 @@ TEST(ContextInternalTest, ThreadSpecificResources) {
   }
 }
 
+TEST(ContextInternalTest, StragglerRate) {
+  CtxImpl ctx;
+  EXPECT_EQ(ctx.straggler_rate(), 0);
+  ctx.UpdateStragglerRate(false, 0.5f);
+  EXPECT_EQ(ctx.straggler_rate(), 0);
+  ctx.UpdateStragglerRate(true, 0.5f);
+  const float rate = ctx.straggler_rate();
+  EXPECT_GT(rate, 0.4f);
+  EXPECT_LE(rate, 0.5f);
+  ctx.UpdateStragglerRate(true, 0.5f);
+  EXPECT_GT(ctx.straggler_rate(), rate);
+  for (int i = 0; i < 20; i++) {
+    ctx.UpdateStragglerRate(false, 0.5f);
+  }
+  EXPECT_EQ(ctx.straggler_rate(), 0);
+}
+
 }  // namespace
 }  // namespace ruy
 
@@ -31,13 +31,16 @@ limitations under the License.
 #define RUY_RUY_DISPATCH_H_
 
 #include <algorithm>
+#include <complex>
 #include <cstdint>
 #include <limits>  // IWYU pragma: keep
 #include <type_traits>
 
+#include "ruy/allocator.h"
 #include "ruy/check_macros.h"
 #include "ruy/common.h"
 #include "ruy/ctx.h"
+#include "ruy/float8.h"
 #include "ruy/kernel.h"
 #include "ruy/kernel_common.h"
 #include "ruy/mat.h"
@@ -51,6 +54,7 @@ limitations under the License.
 #include "ruy/profiler/instrumentation.h"
 #include "ruy/side_pair.h"
 #include "ruy/size_util.h"
+#include "ruy/strassen.h"
 #include "ruy/trmul.h"
 #include "ruy/trmul_params.h"
 
@@ -77,7 +81,7 @@ bool IsSymmetricZeroPoint(Scalar zero_point) {
 
 template <typename MulParamsType, typename Scalar>
 void CheckZeroPoint(Scalar zero_point) {
-  if (std::is_floating_point<Scalar>::value ||
+  if (!std::numeric_limits<Scalar>::is_integer ||
       MulParamsType::kZeroPointSupport == ZeroPointSupport::kSymmetric) {
     RUY_DCHECK(IsSymmetricZeroPoint(zero_point));
   }
@@ -106,11 +110,93 @@ void EnforceZeroPointSupport(LhsScalar lhs_zero_point, RhsScalar rhs_zero_point,
              rhs_zero_point != std::numeric_limits<RhsScalar>::lowest());
 }
 
+template <typename MulParamsType, typename LhsScalar>
+void EnforcePerChannelZeroPointSupport(const MulParamsType& mul_params) {
+  if (!mul_params.lhs_zero_point_perchannel()) {
+    return;
+  }
+  // Per-channel zero points are an asymmetric quantization feature, so they
+  // don't make sense for floating-point, nor with kSymmetric.
+  RUY_DCHECK(std::numeric_limits<LhsScalar>::is_integer);
+  RUY_DCHECK(MulParamsType::kZeroPointSupport == ZeroPointSupport::kGeneral);
+}
+
+template <typename MulParamsType, typename LhsScalar, typename RhsScalar,
+          typename DstScalar>
+void EnforceDynamicQuantizationSupport(const MulParamsType& mul_params) {
+  static constexpr bool kIsDynamicQuantization =
+      IsDynamicQuantization<LhsScalar, RhsScalar>::value;
+  static_assert(!kIsDynamicQuantization ||
+                    (std::is_same<typename MulParamsType::AccumScalar,
+                                  std::int32_t>::value &&
+                     std::is_floating_point<DstScalar>::value),
+                "Dynamic quantization requires int32 accumulators and a "
+                "floating-point destination");
+  if (!kIsDynamicQuantization) {
+    RUY_DCHECK_EQ(mul_params.lhs_group_scales(), nullptr);
+    return;
+  }
+  // The accumulators are dequantized by multiplying them by the LHS scale
+  // (multiplier_float, multiplier_float_perchannel or lhs_group_scales) and by
+  // the per-column RHS scale. A bias would have to be in the units of the
+  // latter, which the caller doesn't know, so it isn't supported.
+  if (mul_params.lhs_group_scales()) {
+    RUY_DCHECK_GT(mul_params.lhs_group_size(), 0);
+    RUY_DCHECK_EQ(mul_params.multiplier_float(), 0);
+    RUY_DCHECK_EQ(mul_params.multiplier_float_perchannel(), nullptr);
+  } else {
+    RUY_DCHECK(mul_params.multiplier_float_perchannel() ||
+               mul_params.multiplier_float() != 0);
+  }
+  RUY_DCHECK_EQ(mul_params.bias(), nullptr);
+  RUY_DCHECK(mul_params.channel_dimension() == ChannelDimension::kRow);
+}
+
+template <typename MulParamsType, typename LhsScalar, typename RhsScalar,
+          typename DstScalar>
+void EnforceFloat8Support(const MulParamsType& mul_params) {
+  static_assert(!IsFloat8<LhsScalar>::value ||
+                    (std::is_same<RhsScalar, float>::value &&
+                     std::is_same<typename MulParamsType::AccumScalar,
+                                  float>::value &&
+                     std::is_same<DstScalar, float>::value),
+                "An 8-bit floating-point LHS requires a float RHS, float "
+                "accumulators and a float destination");
+  if (!IsFloat8<LhsScalar>::value) {
+    return;
+  }
+  // The Path::kStandardCpp kernel applies the LHS scale (multiplier_float or
+  // multiplier_float_perchannel) itself, but RunZeroRhsKernel doesn't.
+  RUY_DCHECK(!mul_params.skip_zero_rhs_slices());
+  RUY_DCHECK(mul_params.channel_dimension() == ChannelDimension::kRow);
+}
+
+// 8-bit floating-point LHS matrices, and dynamic quantization with a LHS
+// wider than 8 bits, are currently only implemented by Path::kStandardCpp.
+// Restricting the paths at compile time, rather than falling back at runtime
+// as PopulateTrMulParams does, avoids instantiating optimized kernels for type
+// combinations that they don't handle.
+template <typename LhsScalar, typename RhsScalar>
+struct RequiresStandardCpp
+    : std::integral_constant<
+          bool, (IsDynamicQuantization<LhsScalar, RhsScalar>::value &&
+                 sizeof(LhsScalar) != 1) ||
+                    IsFloat8<LhsScalar>::value> {};
+
 template <typename MulParamsType, typename DstScalar>
 void EnforceDstSpecSupport(const MulParamsType& mul_params,
                            DstScalar dst_zero_point) {
   static_assert(
       std::is_same<typename MulParamsType::DstScalar, DstScalar>::value, "");
+  // The float multiplier is an alternative to the fixed-point multiplier, the
+  // two can't be used together.
+  if (mul_params.multiplier_float_perchannel() ||
+      mul_params.multiplier_float() != 0) {
+    RUY_DCHECK_EQ(mul_params.multiplier_fixedpoint(), 0);
+    RUY_DCHECK_EQ(mul_params.multiplier_exponent(), 0);
+    RUY_DCHECK_EQ(mul_params.multiplier_fixedpoint_perchannel(), nullptr);
+    RUY_DCHECK_EQ(mul_params.multiplier_exponent_perchannel(), nullptr);
+  }
   if (!std::is_same<typename MulParamsType::DstScalar, std::int32_t>::value)
     return;
 
@@ -125,6 +211,8 @@ void EnforceDstSpecSupport(const MulParamsType& mul_params,
   RUY_DCHECK_EQ(mul_params.multiplier_exponent(), 0);
   RUY_DCHECK_EQ(mul_params.multiplier_fixedpoint_perchannel(), nullptr);
   RUY_DCHECK_EQ(mul_params.multiplier_exponent_perchannel(), nullptr);
+  RUY_DCHECK_EQ(mul_params.multiplier_float(), 0);
+  RUY_DCHECK_EQ(mul_params.multiplier_float_perchannel(), nullptr);
 }
 
 inline bool IsColMajorTrMul(const TrMulParams& params) {
@@ -152,27 +240,85 @@ inline void CreatePackedLayout(const MatLayout& src, const Type& scalar,
 template <typename Scalar, typename PackedScalar>
 void CreatePackedMatrix(Side side, const KernelLayout& kernel_layout,
                         TrMulParams* params) {
-  // Ruy always uses 32-bit signed accumulators for quantized
-  // matrix multiplication, so we would like to always use std::int32_t
-  // unconditionally for SumsType.
-  // However, for floating point types, we still need a reasonable type here to
-  // avoid tripping assertions elsewhere in the code.
-  using SumsType =
-      typename std::conditional<std::is_floating_point<Scalar>::value, Scalar,
-                                std::int32_t>::type;
+  // See PMat::SumsType. This depends on the packed type, not on the source
+  // type, as the two differ with dynamic quantization.
+  using SumsType = typename PMat<PackedScalar>::SumsType;
 
   const EMat& src = params->src[side];
   PEMat* packed = &params->packed[side];
   packed->data_type = Type::Create<PackedScalar>();
   packed->sums_type = Type::Create<SumsType>();
+  if (std::is_floating_point<Scalar>::value &&
+      !std::is_floating_point<PackedScalar>::value) {
+    // Dynamic quantization: the packed matrix also needs per-column scales.
+    packed->scales_type = Type::Create<float>();
+  }
   CreatePackedLayout(src.layout, packed->data_type, kernel_layout,
                      &packed->layout);
   packed->zero_point = Pack<PackedScalar, Scalar>(src.zero_point);
 }
 
+// Only GatedMul with floating-point types has a gated kernel, see
+// RunGatedKernel.
+template <Path ThePath, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType,
+          bool kSupported = std::is_floating_point<LhsScalar>::value &&
+                            std::is_floating_point<RhsScalar>::value &&
+                            std::is_floating_point<
+                                typename MulParamsType::AccumScalar>::value>
+struct GatedKernelPopulator {
+  static void Populate(TrMulParams* params) {
+    RUY_DCHECK(!params->is_gated());
+  }
+};
+
+template <Path ThePath, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType>
+struct GatedKernelPopulator<ThePath, LhsScalar, RhsScalar, DstScalar,
+                            MulParamsType, true> {
+  static void Populate(TrMulParams* params) {
+    if (params->is_gated()) {
+      params->run_gated_kernel =
+          &RunGatedKernel<ThePath, LhsScalar, RhsScalar, DstScalar,
+                          MulParamsType>;
+    }
+  }
+};
+
+// Selects the kernel of ThePath for the given packed types. With dynamic
+// quantization on the optimized paths, that is their 8-bit kernel, computing
+// int32 accumulators for RunDynamicQuantizationKernel to dequantize. The RHS
+// is then packed by Path::kStandardCpp, as the packing code of the optimized
+// paths only takes 8-bit sources.
+template <Path ThePath, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType, bool kDequantize>
+struct KernelSelector {
+  using KernelType =
+      Kernel<ThePath, LhsScalar, RhsScalar, DstScalar, MulParamsType>;
+  static constexpr Path kRhsPackPath = ThePath;
+  static RunKernelFn* RunKernelFunction() {
+    return &RunKernel<ThePath, LhsScalar, RhsScalar, DstScalar,
+                      MulParamsType>;
+  }
+};
+
+template <Path ThePath, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType>
+struct KernelSelector<ThePath, LhsScalar, RhsScalar, DstScalar, MulParamsType,
+                      true> {
+  using KernelType = Kernel<ThePath, std::int8_t, std::int8_t, std::int32_t,
+                            MulParams<std::int32_t, std::int32_t>>;
+  static constexpr Path kRhsPackPath = Path::kStandardCpp;
+  static RunKernelFn* RunKernelFunction() {
+    return &RunDynamicQuantizationKernel<ThePath, DstScalar, MulParamsType>;
+  }
+};
+
 template <Path ThePath, typename LhsScalar, typename RhsScalar,
           typename DstScalar, typename MulParamsType>
 void PopulateTrMulParams(TrMulParams* params) {
+  static constexpr bool kIsDynamicQuantization =
+      IsDynamicQuantization<LhsScalar, RhsScalar>::value;
   // The optimized code paths don't handle the full generality of Ruy's API.
   // Fall back to Path::kStandardCpp if necessary.
   bool fallback_to_standard_cpp = false;
@@ -182,6 +328,24 @@ void PopulateTrMulParams(TrMulParams* params) {
     if (!IsColMajorTrMul(*params)) {
       fallback_to_standard_cpp = true;
     }
+    const auto* mul_params =
+        static_cast<const MulParamsType*>(params->mul_params);
+    // Group-wise LHS scales are only implemented by Path::kStandardCpp.
+    if (mul_params->lhs_group_scales()) {
+      fallback_to_standard_cpp = true;
+    }
+#if RUY_PLATFORM_ARM
+    // The NEON asm kernels don't implement per-channel LHS zero points, float
+    // multipliers, nor ChannelDimension::kCol. With dynamic quantization, the
+    // float multipliers are applied by RunDynamicQuantizationKernel instead.
+    if (mul_params->lhs_zero_point_perchannel() ||
+        (!kIsDynamicQuantization &&
+         (mul_params->multiplier_float_perchannel() ||
+          mul_params->multiplier_float() != 0)) ||
+        mul_params->channel_dimension() == ChannelDimension::kCol) {
+      fallback_to_standard_cpp = true;
+    }
+#endif
   }
 
   if (fallback_to_standard_cpp) {
@@ -191,11 +355,16 @@ void PopulateTrMulParams(TrMulParams* params) {
   }
 
   using PackedLhsScalar = PackedType<ThePath, LhsScalar>;
-  using PackedRhsScalar = PackedType<ThePath, RhsScalar>;
-  using Kernel = Kernel<ThePath, PackedLhsScalar, PackedRhsScalar, DstScalar,
-                        MulParamsType>;
-  using LhsKernelLayout = typename Kernel::LhsLayout;
-  using RhsKernelLayout = typename Kernel::RhsLayout;
+  // With dynamic quantization, the float RHS gets packed as int8.
+  using PackedRhsScalar =
+      typename std::conditional<kIsDynamicQuantization, std::int8_t,
+                                PackedType<ThePath, RhsScalar>>::type;
+  using Selector =
+      KernelSelector<ThePath, PackedLhsScalar, PackedRhsScalar, DstScalar,
+                     MulParamsType,
+                     kIsDynamicQuantization && ThePath != Path::kStandardCpp>;
+  using LhsKernelLayout = typename Selector::KernelType::LhsLayout;
+  using RhsKernelLayout = typename Selector::KernelType::RhsLayout;
 
   params->path = ThePath;
 
@@ -208,10 +377,12 @@ void PopulateTrMulParams(TrMulParams* params) {
       Side::kRhs, ToKernelLayout<RhsKernelLayout>(), params);
   params->run_pack[Side::kLhs] =
       &RunPack<ThePath, LhsKernelLayout, LhsScalar, PackedLhsScalar>;
-  params->run_pack[Side::kRhs] =
-      &RunPack<ThePath, RhsKernelLayout, RhsScalar, PackedRhsScalar>;
-  params->run_kernel = &RunKernel<ThePath, PackedLhsScalar, PackedRhsScalar,
-                                  DstScalar, MulParamsType>;
+  params->run_pack[Side::kRhs] = &RunPack<Selector::kRhsPackPath,
+                                          RhsKernelLayout, RhsScalar,
+                                          PackedRhsScalar>;
+  params->run_kernel = Selector::RunKernelFunction();
+  GatedKernelPopulator<ThePath, PackedLhsScalar, PackedRhsScalar, DstScalar,
+                       MulParamsType>::Populate(params);
 }
 
 // PopulateTrMulParamsAllCompiledPaths calls into one of multiple
@@ -317,6 +488,77 @@ void PopulateTrMulParamsAllCompiledPaths(Path the_path, TrMulParams* params) {
                              MulParamsType>::Search(the_path, params);
 }
 
+// Replaces the packed matrices, packing functions and kernel set up by
+// PopulateTrMulParams by those of MulParams::bit_packing.
+template <int kBitPlanes, typename DstScalar, typename MulParamsType>
+void PopulateBitPackedTrMulParams(TrMulParams* params) {
+  RUY_DCHECK(!params->is_gated());
+  for (Side side : {Side::kLhs, Side::kRhs}) {
+    const EMat& src = params->src[side];
+    RUY_DCHECK_EQ(src.zero_point, 0);
+    PEMat* packed = &params->packed[side];
+    *packed = PEMat();
+    packed->data_type = Type::Create<std::uint64_t>();
+    packed->sums_type = Type::Create<std::int32_t>();
+    packed->layout.rows = kBitPlanes * NumBitPackedWords(src.layout.rows);
+    packed->layout.cols = src.layout.cols;
+    packed->layout.stride = packed->layout.rows;
+    // The PrepackedCache tells packed forms of the same source apart by their
+    // layouts. No other packed matrix has a row-major kernel layout of size 1.
+    packed->layout.kernel.order = Order::kRowMajor;
+    params->run_pack[side] = &RunBitPack<kBitPlanes>;
+  }
+  params->run_kernel =
+      &RunBitPackedKernel<kBitPlanes, DstScalar, MulParamsType>;
+}
+
+// Only int8 LHS and RHS with int32 accumulators support bit packing.
+template <typename LhsScalar, typename RhsScalar, typename DstScalar,
+          typename MulParamsType,
+          bool kSupported =
+              std::is_same<LhsScalar, std::int8_t>::value &&
+              std::is_same<RhsScalar, std::int8_t>::value &&
+              std::is_same<typename MulParamsType::AccumScalar,
+                           std::int32_t>::value>
+struct BitPackingPopulator {
+  static void Populate(const MulParamsType& mul_params, TrMulParams*) {
+    RUY_DCHECK(mul_params.bit_packing() == BitPacking::kNone);
+  }
+};
+
+template <typename LhsScalar, typename RhsScalar, typename DstScalar,
+          typename MulParamsType>
+struct BitPackingPopulator<LhsScalar, RhsScalar, DstScalar, MulParamsType,
+                           true> {
+  static void Populate(const MulParamsType& mul_params, TrMulParams* params) {
+    if (mul_params.bit_packing() == BitPacking::kNone) {
+      return;
+    }
+    RUY_DCHECK(!mul_params.skip_zero_rhs_slices());
+    RUY_DCHECK(!mul_params.lhs_zero_point_perchannel());
+    if (mul_params.bit_packing() == BitPacking::kBinary) {
+      PopulateBitPackedTrMulParams<1, DstScalar, MulParamsType>(params);
+    } else {
+      PopulateBitPackedTrMulParams<2, DstScalar, MulParamsType>(params);
+    }
+  }
+};
+
+template <typename DstScalar, typename MulParamsType>
+void PopulateDstReductions(const MulParamsType& mul_params,
+                           TrMulParams* params) {
+  if (!HasDstReductions(mul_params)) {
+    return;
+  }
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  params->dst_reduction_partials_bytes = DstReductionPartialsBytes<AccumScalar>(
+      params->dst.layout.rows, params->dst.layout.cols);
+  params->init_dst_reduction_partials = &InitDstReductionPartials<AccumScalar>;
+  params->reduce_dst_block = &ReduceDstBlock<DstScalar, MulParamsType>;
+  params->merge_dst_reduction_partials =
+      &MergeDstReductionPartials<MulParamsType>;
+}
+
 template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
           typename DstScalar, typename MulParamsType>
 void CreateTrMulParams(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
@@ -332,6 +574,19 @@ void CreateTrMulParams(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
   PopulateTrMulParamsAllCompiledPaths<CompiledPaths, LhsScalar, RhsScalar,
                                       DstScalar, MulParamsType>(the_path,
                                                                 params);
+  BitPackingPopulator<LhsScalar, RhsScalar, DstScalar,
+                      MulParamsType>::Populate(mul_params, params);
+  PopulateDstReductions<DstScalar>(mul_params, params);
+  params->selected_indices[Side::kLhs] = mul_params.lhs_row_indices();
+  params->selected_indices[Side::kRhs] = mul_params.rhs_col_indices();
+  params->dst_mask = mul_params.dst_mask();
+  if (mul_params.skip_zero_rhs_slices() && !params->is_gated()) {
+    params->run_zero_rhs_kernel = &RunZeroRhsKernel<DstScalar, MulParamsType>;
+  }
+  RUY_DCHECK(params->dst_mask.type == DstMaskType::kNone ||
+             !HasDstReductions(mul_params));
+  RUY_DCHECK(params->dst_mask.type != DstMaskType::kCustom ||
+             params->dst_mask.block_predicate);
 }
 
 // Returns true if the operand on the given side should use caching of the
@@ -343,6 +598,10 @@ void CreateTrMulParams(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
 // a large fraction of the overall work, so a heuristic would typically
 // decide in favor of caching, if permitted at all by the cache_policy.
 inline bool ShouldCache(const TrMulParams& params, Side side) {
+  if (side == Side::kLhs && params.is_gated()) {
+    // The gate is packed along with the LHS, and isn't cached.
+    return false;
+  }
   const CachePolicy cache_policy = params.src[side].cache_policy;
   // The width that matters is that of the other side, it is what determines
   // the amortization of the packing work done on the present side.
@@ -353,6 +612,7 @@ inline bool ShouldCache(const TrMulParams& params, Side side) {
     case CachePolicy::kNeverCache:
       return false;
     case CachePolicy::kAlwaysCache:
+    case CachePolicy::kCacheWithinEpoch:
       return true;
     case CachePolicy::kCacheIfLargeSpeedup:
       // The condition (other_width <= other_kernel_width) means that the kernel
@@ -374,8 +634,12 @@ inline bool ShouldCache(const TrMulParams& params, Side side) {
 inline void HandlePrepackedCaching(TrMulParams* params, Ctx* ctx) {
   for (Side side : {Side::kLhs, Side::kRhs}) {
     if (ShouldCache(*params, side)) {
-      auto* cache = ctx->GetPrepackedCache();
-      auto action = cache->Get(params->src[side].data, &params->packed[side]);
+      const void* src_data = params->src[side].data;
+      PEMat* packed = &params->packed[side];
+      const auto action =
+          params->src[side].cache_policy == CachePolicy::kCacheWithinEpoch
+              ? ctx->GetEpochPackedCache()->Get(src_data, packed)
+              : ctx->GetPrepackedCache()->Get(src_data, packed);
       if (action == PrepackedCache::Action::kInsertedNewEntry) {
         params->RunPack(side, ctx->GetMainThreadTuning(), 0,
                         params->packed[side].layout.cols);
@@ -385,6 +649,223 @@ inline void HandlePrepackedCaching(TrMulParams* params, Ctx* ctx) {
   }
 }
 
+// Returns a buffer, allocated from `allocator`, of the values of `src` at the
+// given indices, or nullptr if `src` is nullptr.
+template <typename T>
+const T* GatherSelected(const T* src, const int* indices, int count,
+                        Allocator* allocator) {
+  if (!src) {
+    return nullptr;
+  }
+  T* result;
+  allocator->Allocate(count, &result);
+  for (int i = 0; i < count; i++) {
+    result[i] = src[indices[i]];
+  }
+  return result;
+}
+
+// Replaces the bias and per-channel multipliers in `mul_params` by their values
+// at the given indices, see GatherSelectedParams.
+template <typename MulParamsType>
+void GatherSelectedChannelParams(const int* indices, int count,
+                                 Allocator* allocator,
+                                 MulParamsType* mul_params) {
+  mul_params->set_bias(
+      GatherSelected(mul_params->bias(), indices, count, allocator));
+  mul_params->set_multiplier_fixedpoint_perchannel(
+      GatherSelected(mul_params->multiplier_fixedpoint_perchannel(), indices,
+                     count, allocator));
+  mul_params->set_multiplier_exponent_perchannel(
+      GatherSelected(mul_params->multiplier_exponent_perchannel(), indices,
+                     count, allocator));
+  mul_params->set_multiplier_float_perchannel(
+      GatherSelected(mul_params->multiplier_float_perchannel(), indices,
+                     count, allocator));
+}
+
+// With MulParams::lhs_row_indices and rhs_col_indices, the per-channel
+// parameters are given for all rows of the LHS (or columns of the RHS, with
+// ChannelDimension::kCol), while kernels index them by destination row (or
+// column). This replaces them in `mul_params` by the values of the selected
+// rows and columns, in buffers that live until the end of TrMul.
+template <typename MulParamsType>
+void GatherSelectedParams(int lhs_rows, int depth, int dst_rows, int dst_cols,
+                          Allocator* allocator, MulParamsType* mul_params) {
+  const bool channel_is_col =
+      mul_params->channel_dimension() == ChannelDimension::kCol;
+  if (channel_is_col && mul_params->rhs_col_indices()) {
+    GatherSelectedChannelParams(mul_params->rhs_col_indices(), dst_cols,
+                                allocator, mul_params);
+  }
+  const int* indices = mul_params->lhs_row_indices();
+  if (!indices) {
+    return;
+  }
+  if (!channel_is_col) {
+    GatherSelectedChannelParams(indices, dst_rows, allocator, mul_params);
+  }
+  mul_params->set_lhs_zero_point_perchannel(
+      GatherSelected(mul_params->lhs_zero_point_perchannel(), indices,
+                     dst_rows, allocator));
+  if (mul_params->lhs_group_scales()) {
+    // Group scales are stored group by group, see MulParams.
+    const int group_size = mul_params->lhs_group_size();
+    const int num_groups = (depth + group_size - 1) / group_size;
+    float* group_scales;
+    allocator->Allocate(num_groups * dst_rows, &group_scales);
+    for (int g = 0; g < num_groups; g++) {
+      for (int i = 0; i < dst_rows; i++) {
+        group_scales[g * dst_rows + i] =
+            mul_params->lhs_group_scales()[g * lhs_rows + indices[i]];
+      }
+    }
+    mul_params->set_lhs_group_scales(group_scales);
+  }
+}
+
+// Returns true if a Mul with a row-major destination may be computed as the
+// transposed Mul, dst^T = rhs^T * lhs^T, whose destination is column-major and
+// can thus be handled by the optimized kernels. The bias and per-channel
+// multipliers then switch to the other ChannelDimension. That is only possible
+// with no per-channel LHS zero points, which would become per-column RHS zero
+// points, no custom DstMask, whose block predicate isn't aware of the
+// transposition, and no skip_zero_rhs_slices, which is about the RHS
+// specifically. Dynamic quantization and 8-bit floating-point LHS matrices,
+// which aren't symmetric in LHS and RHS, are excluded at compile time in
+// DispatchMul.
+template <typename MulParamsType>
+bool CanSwapOperands(const MulParamsType& mul_params) {
+  return !mul_params.lhs_zero_point_perchannel() &&
+         !mul_params.lhs_group_scales() &&
+         mul_params.dst_mask().type != DstMaskType::kCustom &&
+         !mul_params.skip_zero_rhs_slices();
+}
+
+template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType>
+void DispatchMul(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
+                 const MulParamsType& mul_params, Ctx* ctx,
+                 Mat<DstScalar>* dst);
+
+template <bool CanSwap>
+struct SwapOperandsDispatcher {
+  // Returns true if the Mul was dispatched with swapped operands, in which
+  // case it is done.
+  template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
+            typename DstScalar, typename MulParamsType>
+  static bool Dispatch(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
+                       const MulParamsType& mul_params, Ctx* ctx,
+                       Mat<DstScalar>* dst) {
+    if (!IsRowMajor(dst->layout) || !CanSwapOperands(mul_params)) {
+      return false;
+    }
+    Mat<RhsScalar> swapped_lhs(rhs);
+    Transpose(&swapped_lhs);
+    Mat<LhsScalar> swapped_rhs(lhs);
+    Transpose(&swapped_rhs);
+    Mat<DstScalar> swapped_dst(*dst);
+    Transpose(&swapped_dst);
+    // Rows of the destination become columns, and vice versa.
+    MulParamsType swapped_mul_params(mul_params);
+    *swapped_mul_params.mutable_row_reductions() = mul_params.col_reductions();
+    *swapped_mul_params.mutable_col_reductions() = mul_params.row_reductions();
+    swapped_mul_params.set_lhs_row_indices(mul_params.rhs_col_indices());
+    swapped_mul_params.set_rhs_col_indices(mul_params.lhs_row_indices());
+    swapped_mul_params.set_channel_dimension(
+        mul_params.channel_dimension() == ChannelDimension::kRow
+            ? ChannelDimension::kCol
+            : ChannelDimension::kRow);
+    // Transposing the destination turns a lower-triangular mask into an
+    // upper-triangular one with the opposite diagonal offset, and vice versa.
+    DstMask* mask = swapped_mul_params.mutable_dst_mask();
+    if (mask->type == DstMaskType::kLowerTriangular) {
+      mask->type = DstMaskType::kUpperTriangular;
+    } else if (mask->type == DstMaskType::kUpperTriangular) {
+      mask->type = DstMaskType::kLowerTriangular;
+    }
+    mask->diagonal_offset = -mask->diagonal_offset;
+    DispatchMul<CompiledPaths>(swapped_lhs, swapped_rhs, swapped_mul_params,
+                               ctx, &swapped_dst);
+    return true;
+  }
+};
+
+template <>
+struct SwapOperandsDispatcher<false> {
+  template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
+            typename DstScalar, typename MulParamsType>
+  static bool Dispatch(const Mat<LhsScalar>&, const Mat<RhsScalar>&,
+                       const MulParamsType&, Ctx*, Mat<DstScalar>*) {
+    return false;
+  }
+};
+
+// Strassen's algorithm only applies to floating-point types, with the same
+// type for LHS, RHS, accumulators and destination.
+template <typename LhsScalar, typename RhsScalar, typename DstScalar,
+          typename MulParamsType>
+struct IsStrassenSupported {
+  static constexpr bool value =
+      std::is_floating_point<LhsScalar>::value &&
+      std::is_same<LhsScalar, RhsScalar>::value &&
+      std::is_same<LhsScalar, DstScalar>::value &&
+      std::is_same<LhsScalar, typename MulParamsType::AccumScalar>::value;
+};
+
+template <bool IsSupported>
+struct StrassenDispatcher {
+  // Returns true if the Mul was dispatched to StrassenMul, in which case it is
+  // done. The leaf products are plain Muls, without bias nor clamping, which
+  // are applied at the end.
+  template <Path CompiledPaths, typename Scalar, typename MulParamsType>
+  static bool Dispatch(const Mat<Scalar>& lhs, const Mat<Scalar>& rhs,
+                       const MulParamsType& mul_params, Ctx* ctx,
+                       Mat<Scalar>* dst) {
+    const int cutoff = mul_params.strassen_cutoff();
+    if (cutoff <= 0 ||
+        NumStrassenLevels(lhs.layout.rows, lhs.layout.cols, rhs.layout.cols,
+                          cutoff) == 0 ||
+        HasDstReductions(mul_params) || mul_params.lhs_row_indices() ||
+        mul_params.rhs_col_indices()) {
+      return false;
+    }
+    const MulParamsType leaf_mul_params;
+    const auto leaf_mul = [&](const Mat<Scalar>& leaf_lhs,
+                              const Mat<Scalar>& leaf_rhs,
+                              Mat<Scalar>* leaf_dst) {
+      DispatchMul<CompiledPaths>(leaf_lhs, leaf_rhs, leaf_mul_params, ctx,
+                                 leaf_dst);
+    };
+    StrassenMul(lhs, rhs, cutoff, leaf_mul, dst);
+    const bool channel_is_col =
+        mul_params.channel_dimension() == ChannelDimension::kCol;
+    for (int col = 0; col < dst->layout.cols; col++) {
+      for (int row = 0; row < dst->layout.rows; row++) {
+        Scalar* val = ElementPtr(dst, row, col);
+        if (mul_params.bias()) {
+          *val += mul_params.bias()[channel_is_col ? col : row];
+        }
+        *val = std::min<Scalar>(*val, mul_params.clamp_max());
+        *val = std::max<Scalar>(*val, mul_params.clamp_min());
+      }
+    }
+    return true;
+  }
+};
+
+template <>
+struct StrassenDispatcher<false> {
+  template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
+            typename DstScalar, typename MulParamsType>
+  static bool Dispatch(const Mat<LhsScalar>&, const Mat<RhsScalar>&,
+                       const MulParamsType& mul_params, Ctx*,
+                       Mat<DstScalar>*) {
+    RUY_DCHECK_EQ(mul_params.strassen_cutoff(), 0);
+    return false;
+  }
+};
+
 template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
           typename DstScalar, typename MulParamsType>
 void DispatchMul(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
@@ -402,8 +883,35 @@ void DispatchMul(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
   EnforceLayoutSupport<MulParamsType>(lhs.layout, rhs.layout, dst->layout);
   EnforceZeroPointSupport<MulParamsType>(lhs.zero_point, rhs.zero_point,
                                          dst->zero_point);
+  EnforcePerChannelZeroPointSupport<MulParamsType, LhsScalar>(mul_params);
+  EnforceDynamicQuantizationSupport<MulParamsType, LhsScalar, RhsScalar,
+                                    DstScalar>(mul_params);
+  EnforceFloat8Support<MulParamsType, LhsScalar, RhsScalar, DstScalar>(
+      mul_params);
   EnforceDstSpecSupport<MulParamsType>(mul_params, dst->zero_point);
 
+  using Strassen = StrassenDispatcher<IsStrassenSupported<
+      LhsScalar, RhsScalar, DstScalar, MulParamsType>::value>;
+  if (Strassen::template Dispatch<CompiledPaths>(lhs, rhs, mul_params, ctx,
+                                                 dst)) {
+    return;
+  }
+
+  // The optimized kernels only write column-major destinations. Dynamic
+  // quantization and 8-bit floating-point LHS matrices aren't swapped, as they
+  // aren't symmetric in LHS and RHS.
+  using SwapDispatcher = SwapOperandsDispatcher<
+      !IsDynamicQuantization<LhsScalar, RhsScalar>::value &&
+      !IsFloat8<LhsScalar>::value>;
+  if (SwapDispatcher::template Dispatch<CompiledPaths>(lhs, rhs, mul_params,
+                                                       ctx, dst)) {
+    return;
+  }
+
+  static constexpr Path kPaths =
+      RequiresStandardCpp<LhsScalar, RhsScalar>::value ? Path::kStandardCpp
+                                                       : CompiledPaths;
+
   // This should be a constant, for a given machine and CompiledPaths.
   // There is a back door to override it for testing, but in production it will
   // always be the "best" Path, i.e. the one with the newest SIMD instructions
@@ -411,15 +919,277 @@ void DispatchMul(const Mat<LhsScalar>& lhs, const Mat<RhsScalar>& rhs,
   //
   // Unfortunately, it is not a *static* constant, since it depends on runtime
   // detection of the available SIMD instructions.
-  const Path the_path = ctx->SelectPath(CompiledPaths);
+  const Path the_path = ctx->SelectPath(kPaths);
 
   // As described in the comment at the top of this file, Ruy internally
   // converts Mul into TrMul. We handle that here.
   Mat<LhsScalar> transposed_lhs(lhs);
   Transpose(&transposed_lhs);
+  const MulParamsType* trmul_mul_params = &mul_params;
+  MulParamsType selected_mul_params;
+  if (mul_params.lhs_row_indices() || mul_params.rhs_col_indices()) {
+    selected_mul_params = mul_params;
+    GatherSelectedParams(lhs.layout.rows, lhs.layout.cols, dst->layout.rows,
+                         dst->layout.cols, ctx->GetMainAllocator(),
+                         &selected_mul_params);
+    trmul_mul_params = &selected_mul_params;
+  }
+  TrMulParams params;
+  CreateTrMulParams<kPaths>(transposed_lhs, rhs, *trmul_mul_params, dst,
+                            the_path, &params);
+  HandlePrepackedCaching(&params, ctx);
+  TrMul(&params, ctx);
+}
+
+template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType>
+void DispatchGatedMul(const Mat<LhsScalar>& gate, const Mat<LhsScalar>& lhs,
+                      const Mat<RhsScalar>& rhs,
+                      const MulParamsType& mul_params, Ctx* ctx,
+                      Mat<DstScalar>* dst) {
+  static_assert(
+      std::is_floating_point<typename MulParamsType::AccumScalar>::value,
+      "GatedMul only supports floating-point types");
+
+  profiler::ScopeLabel mul_label("GatedMul");
+  profiler::ScopeLabel shape_specific_label("matmul shape: %dx%dx%d",
+                                            lhs.layout.rows, lhs.layout.cols,
+                                            rhs.layout.cols);
+
+  RUY_DCHECK_EQ(gate.layout.rows, lhs.layout.rows);
+  RUY_DCHECK_EQ(gate.layout.cols, lhs.layout.cols);
+  // A bias would be ambiguous between the two products.
+  RUY_DCHECK_EQ(mul_params.bias(), nullptr);
+  RUY_DCHECK(mul_params.channel_dimension() == ChannelDimension::kRow);
+  RUY_DCHECK_EQ(mul_params.lhs_row_indices(), nullptr);
+  RUY_DCHECK_EQ(mul_params.rhs_col_indices(), nullptr);
+  EnforceLayoutSupport<MulParamsType>(lhs.layout, rhs.layout, dst->layout);
+  EnforceLayoutSupport<MulParamsType>(gate.layout, rhs.layout, dst->layout);
+  EnforceZeroPointSupport<MulParamsType>(lhs.zero_point, rhs.zero_point,
+                                         dst->zero_point);
+  CheckZeroPoint<MulParamsType>(gate.zero_point);
+  EnforceDstSpecSupport<MulParamsType>(mul_params, dst->zero_point);
+
+  const Path the_path = ctx->SelectPath(CompiledPaths);
+
+  // Same as in DispatchMul, with the gate transposed and packed just like the
+  // LHS. Setting params.gate makes PopulateTrMulParams set up the gated kernel
+  // of the selected path, see RunGatedKernel.
+  Mat<LhsScalar> transposed_lhs(lhs);
+  Transpose(&transposed_lhs);
+  Mat<LhsScalar> transposed_gate(gate);
+  Transpose(&transposed_gate);
   TrMulParams params;
+  params.gate = EraseType(transposed_gate);
   CreateTrMulParams<CompiledPaths>(transposed_lhs, rhs, mul_params, dst,
                                    the_path, &params);
+  params.packed_gate = params.packed[Side::kLhs];
+  HandlePrepackedCaching(&params, ctx);
+  TrMul(&params, ctx);
+}
+
+template <Path CompiledPaths, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType>
+void DispatchGroupedMul(int num_groups, const Mat<LhsScalar>* lhs,
+                        const Mat<RhsScalar>& rhs, const int* group_offsets,
+                        const int* rhs_col_indices,
+                        const MulParamsType* mul_params, Ctx* ctx,
+                        Mat<DstScalar>* dst) {
+  static_assert(CompiledPaths != Path::kNone, "Must compile at least one Path");
+  static_assert((CompiledPaths & ~kAllPaths) == Path::kNone,
+                "CompiledPaths must be a subset of ruy::kAllPaths");
+
+  profiler::ScopeLabel mul_label("GroupedMul");
+  profiler::ScopeLabel shape_specific_label(
+      "matmul shape: %dx%dx%d, %d groups", dst->layout.rows, rhs.layout.rows,
+      dst->layout.cols, num_groups);
+
+  RUY_DCHECK_EQ(group_offsets[0], 0);
+  RUY_DCHECK_EQ(group_offsets[num_groups], dst->layout.cols);
+
+  // Same as in DispatchMul.
+  static constexpr Path kPaths =
+      RequiresStandardCpp<LhsScalar, RhsScalar>::value ? Path::kStandardCpp
+                                                       : CompiledPaths;
+  const Path the_path = ctx->SelectPath(kPaths);
+
+  // Each non-empty group is a TrMul whose destination is a block of
+  // consecutive columns of dst, and whose RHS is made of the selected columns
+  // of rhs, see TrMulParams::selected_indices.
+  TrMulParams* params;
+  ctx->GetMainAllocator()->Allocate(num_groups, &params);
+  int num_trmuls = 0;
+  for (int g = 0; g < num_groups; g++) {
+    const int group_cols = group_offsets[g + 1] - group_offsets[g];
+    RUY_DCHECK_GE(group_cols, 0);
+    if (group_cols == 0) {
+      continue;
+    }
+    RUY_DCHECK_EQ(lhs[g].layout.rows, dst->layout.rows);
+    RUY_DCHECK_EQ(mul_params[g].lhs_row_indices(), nullptr);
+    RUY_DCHECK_EQ(mul_params[g].rhs_col_indices(), nullptr);
+    Mat<DstScalar> group_dst(*dst);
+    group_dst.layout.cols = group_cols;
+    group_dst.data.set(ElementPtr(dst, 0, group_offsets[g]));
+    EnforceLayoutSupport<MulParamsType>(lhs[g].layout, rhs.layout,
+                                        group_dst.layout);
+    EnforceZeroPointSupport<MulParamsType>(lhs[g].zero_point, rhs.zero_point,
+                                           dst->zero_point);
+    EnforcePerChannelZeroPointSupport<MulParamsType, LhsScalar>(
+        mul_params[g]);
+    EnforceDynamicQuantizationSupport<MulParamsType, LhsScalar, RhsScalar,
+                                      DstScalar>(mul_params[g]);
+    EnforceFloat8Support<MulParamsType, LhsScalar, RhsScalar, DstScalar>(
+        mul_params[g]);
+    EnforceDstSpecSupport<MulParamsType>(mul_params[g], dst->zero_point);
+
+    Mat<LhsScalar> transposed_lhs(lhs[g]);
+    Transpose(&transposed_lhs);
+    TrMulParams* group_params = new (params + num_trmuls++) TrMulParams;
+    CreateTrMulParams<kPaths>(transposed_lhs, rhs, mul_params[g], &group_dst,
+                              the_path, group_params);
+    group_params->selected_indices[Side::kRhs] =
+        rhs_col_indices + group_offsets[g];
+    HandlePrepackedCaching(group_params, ctx);
+  }
+  if (num_trmuls > 0) {
+    GroupedTrMul(params, num_trmuls, ctx);
+  } else {
+    ctx->GetMainAllocator()->FreeAll();
+  }
+}
+
+template <Path CompiledPaths, typename LhsScalar, typename Scalar,
+          typename MulParamsType>
+void DispatchChainedMul(int num_muls, const Mat<LhsScalar>* lhs,
+                        const Mat<Scalar>& rhs, const MulParamsType* mul_params,
+                        Ctx* ctx, Mat<Scalar>* dst) {
+  static_assert(CompiledPaths != Path::kNone, "Must compile at least one Path");
+  static_assert((CompiledPaths & ~kAllPaths) == Path::kNone,
+                "CompiledPaths must be a subset of ruy::kAllPaths");
+
+  profiler::ScopeLabel mul_label("ChainedMul");
+  profiler::ScopeLabel shape_specific_label("%d muls, %d cols", num_muls,
+                                            rhs.layout.cols);
+
+  // Same as in DispatchMul.
+  static constexpr Path kPaths =
+      RequiresStandardCpp<LhsScalar, Scalar>::value ? Path::kStandardCpp
+                                                    : CompiledPaths;
+  const Path the_path = ctx->SelectPath(kPaths);
+
+  TrMulParams* params;
+  ctx->GetMainAllocator()->Allocate(num_muls, &params);
+  for (int i = 0; i < num_muls; i++) {
+    // The RHS of each Mul but the first is the destination of the previous
+    // one, which isn't computed yet, so its packed form can't be cached.
+    Mat<Scalar> mul_rhs = i == 0 ? rhs : dst[i - 1];
+    if (i > 0) {
+      mul_rhs.cache_policy = CachePolicy::kNeverCache;
+    }
+    RUY_DCHECK_EQ(lhs[i].layout.cols, mul_rhs.layout.rows);
+    RUY_DCHECK_EQ(dst[i].layout.cols, rhs.layout.cols);
+    RUY_DCHECK_EQ(mul_params[i].lhs_row_indices(), nullptr);
+    RUY_DCHECK_EQ(mul_params[i].rhs_col_indices(), nullptr);
+    RUY_DCHECK(mul_params[i].dst_mask().type == DstMaskType::kNone);
+    EnforceLayoutSupport<MulParamsType>(lhs[i].layout, mul_rhs.layout,
+                                        dst[i].layout);
+    EnforceZeroPointSupport<MulParamsType>(lhs[i].zero_point,
+                                           mul_rhs.zero_point,
+                                           dst[i].zero_point);
+    EnforcePerChannelZeroPointSupport<MulParamsType, LhsScalar>(
+        mul_params[i]);
+    EnforceDynamicQuantizationSupport<MulParamsType, LhsScalar, Scalar,
+                                      Scalar>(mul_params[i]);
+    EnforceFloat8Support<MulParamsType, LhsScalar, Scalar, Scalar>(
+        mul_params[i]);
+    EnforceDstSpecSupport<MulParamsType>(mul_params[i], dst[i].zero_point);
+
+    Mat<LhsScalar> transposed_lhs(lhs[i]);
+    Transpose(&transposed_lhs);
+    TrMulParams* mul_trmul_params = new (params + i) TrMulParams;
+    CreateTrMulParams<kPaths>(transposed_lhs, mul_rhs, mul_params[i], dst + i,
+                              the_path, mul_trmul_params);
+    HandlePrepackedCaching(mul_trmul_params, ctx);
+  }
+  ChainedTrMul(params, num_muls, ctx);
+}
+
+// Returns a Mat<Scalar> for the expanded real form of a complex matrix, see
+// RunComplexPack, with twice as many rows and, if `expand_cols`, twice as many
+// columns. It is column-major so that PopulateTrMulParams selects optimized
+// paths, which is only relevant to RunComplexPack, since it reads the complex
+// matrix.
+template <typename Scalar>
+Mat<Scalar> ComplexAsRealMat(const Mat<std::complex<Scalar>>& src,
+                             bool expand_cols) {
+  Mat<Scalar> real;
+  real.data.set(reinterpret_cast<const Scalar*>(src.data.get()));
+  real.layout.rows = 2 * src.layout.rows;
+  real.layout.cols = expand_cols ? 2 * src.layout.cols : src.layout.cols;
+  real.layout.stride = real.layout.rows;
+  real.layout.order = Order::kColMajor;
+  real.cache_policy = src.cache_policy;
+  return real;
+}
+
+template <Path CompiledPaths, typename Scalar>
+void DispatchComplexMul(const Mat<std::complex<Scalar>>& lhs,
+                        const Mat<std::complex<Scalar>>& rhs,
+                        const std::complex<Scalar>* bias, Ctx* ctx,
+                        Mat<std::complex<Scalar>>* dst) {
+  static_assert(std::is_floating_point<Scalar>::value,
+                "ComplexMul only supports floating-point types");
+  RUY_DCHECK_EQ(lhs.layout.cols, rhs.layout.rows);
+  RUY_DCHECK_EQ(lhs.layout.rows, dst->layout.rows);
+  RUY_DCHECK_EQ(rhs.layout.cols, dst->layout.cols);
+
+  // A row-major destination is handled as the transposed product,
+  // dst^T = rhs^T * lhs^T, as in SwapOperandsDispatcher.
+  if (IsRowMajor(dst->layout)) {
+    RUY_DCHECK_EQ(bias, nullptr);
+    Mat<std::complex<Scalar>> swapped_lhs(rhs);
+    Transpose(&swapped_lhs);
+    Mat<std::complex<Scalar>> swapped_rhs(lhs);
+    Transpose(&swapped_rhs);
+    Mat<std::complex<Scalar>> swapped_dst(*dst);
+    Transpose(&swapped_dst);
+    DispatchComplexMul<CompiledPaths>(swapped_lhs, swapped_rhs, bias, ctx,
+                                      &swapped_dst);
+    return;
+  }
+
+  profiler::ScopeLabel mul_label("ComplexMul");
+  profiler::ScopeLabel shape_specific_label("matmul shape: %dx%dx%d",
+                                            lhs.layout.rows, lhs.layout.cols,
+                                            rhs.layout.cols);
+
+  // The complex bias, dst and rhs, if column-major, are already laid out as
+  // their expanded real forms, with real and imaginary parts alternating along
+  // columns. The dst is used as such, while both LHS and RHS are read from
+  // their complex forms by RunComplexPack.
+  MulParams<Scalar, Scalar> mul_params;
+  mul_params.set_bias(reinterpret_cast<const Scalar*>(bias));
+  Mat<Scalar> real_dst;
+  real_dst.data.set(reinterpret_cast<Scalar*>(dst->data.get()));
+  real_dst.layout.rows = 2 * dst->layout.rows;
+  real_dst.layout.cols = dst->layout.cols;
+  real_dst.layout.stride = 2 * dst->layout.stride;
+  real_dst.layout.order = Order::kColMajor;
+
+  Mat<std::complex<Scalar>> transposed_lhs(lhs);
+  Transpose(&transposed_lhs);
+  const Path the_path = ctx->SelectPath(CompiledPaths);
+  TrMulParams params;
+  CreateTrMulParams<CompiledPaths>(ComplexAsRealMat(transposed_lhs, true),
+                                   ComplexAsRealMat(rhs, false), mul_params,
+                                   &real_dst, the_path, &params);
+  params.src[Side::kLhs].layout.stride = transposed_lhs.layout.stride;
+  params.src[Side::kLhs].layout.order = transposed_lhs.layout.order;
+  params.src[Side::kRhs].layout.stride = rhs.layout.stride;
+  params.src[Side::kRhs].layout.order = rhs.layout.order;
+  params.run_pack[Side::kLhs] = &RunComplexPack<Scalar, Side::kLhs>;
+  params.run_pack[Side::kRhs] = &RunComplexPack<Scalar, Side::kRhs>;
   HandlePrepackedCaching(&params, ctx);
   TrMul(&params, ctx);
 }
@@ -0,0 +1,181 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// 16-bit floating-point types, for the destination of float matrix
+// multiplications, as in MulParams<float, BFloat16>. Accumulation and the
+// epilogue (bias, clamping) are done in float, and values are converted,
+// rounding to nearest even, as they are stored.
+//
+// Half is the IEEE-754 binary16 format (5 exponent bits, 10 mantissa bits)
+// and BFloat16 is the upper half of a float (8 exponent bits, 7 mantissa
+// bits). Both follow IEEE-754 for subnormals, infinities and NaNs.
+
+#ifndef RUY_RUY_FLOAT16_H_
+#define RUY_RUY_FLOAT16_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace ruy {
+
+namespace detail {
+
+template <int kExponentBits>
+struct Float16Format {
+  static_assert(kExponentBits == 5 || kExponentBits == 8,
+                "Only the binary16 and bfloat16 formats are supported");
+  static constexpr int kMantissaBits = 15 - kExponentBits;
+  static constexpr int kBias = (1 << (kExponentBits - 1)) - 1;
+  static constexpr int kMaxExponent = (1 << kExponentBits) - 1;
+  // Number of low mantissa bits of a float that are dropped.
+  static constexpr int kShift = 23 - kMantissaBits;
+};
+
+template <int kExponentBits>
+float Float16BitsToFloat(std::uint16_t bits) {
+  using Format = Float16Format<kExponentBits>;
+  const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000) << 16;
+  const int exponent = (bits >> Format::kMantissaBits) & Format::kMaxExponent;
+  const std::uint32_t mantissa = bits & ((1 << Format::kMantissaBits) - 1);
+  std::uint32_t float_bits;
+  if (exponent == 0) {
+    // Zero or subnormal: mantissa * 2^(1 - bias - mantissa bits), which is
+    // exact in float.
+    const float magnitude =
+        std::ldexp(static_cast<float>(mantissa),
+                   1 - Format::kBias - Format::kMantissaBits);
+    std::memcpy(&float_bits, &magnitude, sizeof(float_bits));
+  } else {
+    const std::uint32_t float_exponent = exponent == Format::kMaxExponent
+                                             ? 255
+                                             : exponent - Format::kBias + 127;
+    float_bits = float_exponent << 23 | mantissa << Format::kShift;
+  }
+  float_bits |= sign;
+  float result;
+  std::memcpy(&result, &float_bits, sizeof(result));
+  return result;
+}
+
+// Rounds to nearest, ties to even. Values beyond the largest finite magnitude
+// round to infinity, as in IEEE-754, and NaNs stay (quiet) NaNs.
+template <int kExponentBits>
+std::uint16_t FloatToFloat16Bits(float value) {
+  using Format = Float16Format<kExponentBits>;
+  std::uint32_t float_bits;
+  std::memcpy(&float_bits, &value, sizeof(float_bits));
+  const std::uint16_t sign = (float_bits >> 16) & 0x8000;
+  std::uint32_t magnitude_bits = float_bits & 0x7fffffff;
+  const std::uint16_t infinity_bits = Format::kMaxExponent
+                                      << Format::kMantissaBits;
+  if (magnitude_bits > 0x7f800000) {
+    // NaN: keep the upper mantissa bits, and set the quiet bit.
+    return sign | infinity_bits | (1 << (Format::kMantissaBits - 1)) |
+           ((magnitude_bits & 0x7fffff) >> Format::kShift);
+  }
+  // The smallest float magnitude that rounds to infinity: the largest finite
+  // magnitude plus half of its quantum.
+  const std::uint32_t overflow_bits =
+      static_cast<std::uint32_t>(127 + Format::kBias) << 23 |
+      ((1u << (Format::kMantissaBits + 1)) - 1) << (Format::kShift - 1);
+  if (magnitude_bits >= overflow_bits) {
+    return sign | infinity_bits;
+  }
+  const std::uint32_t min_normal_bits =
+      static_cast<std::uint32_t>(128 - Format::kBias) << 23;
+  if (magnitude_bits < min_normal_bits) {
+    // Zero or subnormal result, in units of the subnormal quantum.
+    const float units = std::nearbyint(
+        std::ldexp(std::abs(value), Format::kBias - 1 + Format::kMantissaBits));
+    return sign | static_cast<std::uint16_t>(units);
+  }
+  magnitude_bits -= static_cast<std::uint32_t>(127 - Format::kBias) << 23;
+  // Adding just under half of the quantum, plus the lowest kept bit, rounds
+  // to nearest even. A carry out of the mantissa increments the exponent.
+  magnitude_bits += (1u << (Format::kShift - 1)) - 1 +
+                    ((magnitude_bits >> Format::kShift) & 1);
+  return sign | static_cast<std::uint16_t>(magnitude_bits >> Format::kShift);
+}
+
+}  // namespace detail
+
+template <int kExponentBits>
+class Float16 final {
+ public:
+  Float16() = default;
+  // Implicit, like the conversions between built-in floating-point types, and
+  // so that Matrix::zero_point can be initialized to 0.
+  Float16(float value)
+      : bits_(detail::FloatToFloat16Bits<kExponentBits>(value)) {}
+  operator float() const {
+    return detail::Float16BitsToFloat<kExponentBits>(bits_);
+  }
+
+  static Float16 FromBits(std::uint16_t bits) {
+    Float16 result;
+    result.bits_ = bits;
+    return result;
+  }
+  std::uint16_t bits() const { return bits_; }
+
+ private:
+  std::uint16_t bits_ = 0;
+};
+
+using Half = Float16<5>;
+using BFloat16 = Float16<8>;
+
+template <typename Scalar>
+struct IsFloat16 : std::false_type {};
+
+template <int kExponentBits>
+struct IsFloat16<Float16<kExponentBits>> : std::true_type {};
+
+}  // namespace ruy
+
+namespace std {
+
+template <int kExponentBits>
+class numeric_limits<ruy::Float16<kExponentBits>> {
+  using Type = ruy::Float16<kExponentBits>;
+  using Format = ruy::detail::Float16Format<kExponentBits>;
+
+ public:
+  static constexpr bool is_specialized = true;
+  static constexpr bool is_signed = true;
+  static constexpr bool is_integer = false;
+  static constexpr bool is_exact = false;
+  static constexpr bool has_infinity = true;
+  static constexpr bool has_quiet_NaN = true;
+  static Type min() { return Type::FromBits(1 << Format::kMantissaBits); }
+  static Type max() {
+    return Type::FromBits((Format::kMaxExponent << Format::kMantissaBits) - 1);
+  }
+  static Type lowest() { return Type::FromBits(0x8000 | max().bits()); }
+  static Type infinity() {
+    return Type::FromBits(Format::kMaxExponent << Format::kMantissaBits);
+  }
+  static Type quiet_NaN() {
+    return Type::FromBits(Format::kMaxExponent << Format::kMantissaBits |
+                          1 << (Format::kMantissaBits - 1));
+  }
+};
+
+}  // namespace std
+
+#endif  // RUY_RUY_FLOAT16_H_
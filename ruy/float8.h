@@ -0,0 +1,170 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// 8-bit floating-point types, for LHS matrices (typically weights) multiplied
+// by a float RHS into a float destination. Their packed form stays 8-bit, also
+// in the PrepackedCache, and the kernel widens values to float as it loads
+// them. The scale of the LHS, if any, is given by MulParams::multiplier_float
+// or multiplier_float_perchannel.
+//
+// Float8E4M3 and Float8E5M2 are the two formats of the OCP 8-bit
+// floating-point specification: 1 sign bit, then 4 exponent bits and 3
+// mantissa bits, or 5 exponent bits and 2 mantissa bits. E5M2 follows IEEE-754
+// for infinities and NaNs, while E4M3 has no infinities and only one NaN
+// encoding per sign (all other bits set), extending its range to 448.
+
+#ifndef RUY_RUY_FLOAT8_H_
+#define RUY_RUY_FLOAT8_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace ruy {
+
+namespace detail {
+
+template <int kExponentBits>
+struct Float8Format {
+  static_assert(kExponentBits == 4 || kExponentBits == 5,
+                "Only the E4M3 and E5M2 formats are supported");
+  static constexpr int kMantissaBits = 7 - kExponentBits;
+  static constexpr int kBias = (1 << (kExponentBits - 1)) - 1;
+  static constexpr int kMaxExponent = (1 << kExponentBits) - 1;
+  static constexpr bool kHasInfinity = kExponentBits == 5;
+  // The largest finite magnitude: 448 for E4M3, 57344 for E5M2.
+  static constexpr int kMaxFiniteBits = kHasInfinity ? 0x7b : 0x7e;
+};
+
+// Widens by bit manipulation, without any table lookup.
+template <int kExponentBits>
+float Float8BitsToFloat(std::uint8_t bits) {
+  using Format = Float8Format<kExponentBits>;
+  const int exponent = (bits >> Format::kMantissaBits) & Format::kMaxExponent;
+  const int mantissa = bits & ((1 << Format::kMantissaBits) - 1);
+  float magnitude;
+  if (exponent == 0) {
+    // Subnormal: mantissa * 2^(1 - bias - mantissa bits).
+    magnitude = static_cast<float>(mantissa) /
+                (1 << (Format::kBias + Format::kMantissaBits - 1));
+  } else if (exponent == Format::kMaxExponent &&
+             (Format::kHasInfinity ||
+              mantissa == (1 << Format::kMantissaBits) - 1)) {
+    magnitude = Format::kHasInfinity && mantissa == 0
+                    ? std::numeric_limits<float>::infinity()
+                    : std::numeric_limits<float>::quiet_NaN();
+  } else {
+    const std::uint32_t float_bits =
+        static_cast<std::uint32_t>(exponent - Format::kBias + 127) << 23 |
+        static_cast<std::uint32_t>(mantissa) << (23 - Format::kMantissaBits);
+    std::memcpy(&magnitude, &float_bits, sizeof(magnitude));
+  }
+  return (bits & 0x80) ? -magnitude : magnitude;
+}
+
+// Rounds to nearest, ties to even, saturating to the largest finite magnitude
+// (also for infinities), as is usual when quantizing weights to 8-bit floats.
+template <int kExponentBits>
+std::uint8_t FloatToFloat8Bits(float value) {
+  using Format = Float8Format<kExponentBits>;
+  const int sign = std::signbit(value) ? 0x80 : 0;
+  if (std::isnan(value)) {
+    return sign | 0x7f;
+  }
+  const float magnitude = std::abs(value);
+  if (std::isinf(magnitude)) {
+    return sign | Format::kMaxFiniteBits;
+  }
+  if (magnitude == 0) {
+    return sign;
+  }
+  int exponent;
+  std::frexp(magnitude, &exponent);
+  // The exponent of the leading bit, clamped to the smallest normal exponent,
+  // as subnormal values have the same quantum as the smallest normal ones.
+  const int leading_exponent = std::max(exponent - 1, 1 - Format::kBias);
+  // The value in units of its quantum, including the implicit leading bit of
+  // normal values, so that rounding up to the next power of two carries into
+  // the exponent field.
+  const int units = static_cast<int>(std::nearbyint(
+      std::ldexp(magnitude, Format::kMantissaBits - leading_exponent)));
+  const int bits =
+      ((leading_exponent + Format::kBias - 1) << Format::kMantissaBits) +
+      units;
+  const int max_finite_bits = Format::kMaxFiniteBits;
+  return sign | std::min(bits, max_finite_bits);
+}
+
+}  // namespace detail
+
+template <int kExponentBits>
+class Float8 final {
+ public:
+  Float8() = default;
+  // Implicit, like the conversions between built-in floating-point types, and
+  // so that Matrix::zero_point can be initialized to 0.
+  Float8(float value)
+      : bits_(detail::FloatToFloat8Bits<kExponentBits>(value)) {}
+  operator float() const {
+    return detail::Float8BitsToFloat<kExponentBits>(bits_);
+  }
+
+  static Float8 FromBits(std::uint8_t bits) {
+    Float8 result;
+    result.bits_ = bits;
+    return result;
+  }
+  std::uint8_t bits() const { return bits_; }
+
+ private:
+  std::uint8_t bits_ = 0;
+};
+
+using Float8E4M3 = Float8<4>;
+using Float8E5M2 = Float8<5>;
+
+template <typename Scalar>
+struct IsFloat8 : std::false_type {};
+
+template <int kExponentBits>
+struct IsFloat8<Float8<kExponentBits>> : std::true_type {};
+
+}  // namespace ruy
+
+namespace std {
+
+template <int kExponentBits>
+class numeric_limits<ruy::Float8<kExponentBits>> {
+  using Type = ruy::Float8<kExponentBits>;
+  using Format = ruy::detail::Float8Format<kExponentBits>;
+
+ public:
+  static constexpr bool is_specialized = true;
+  static constexpr bool is_signed = true;
+  static constexpr bool is_integer = false;
+  static constexpr bool is_exact = false;
+  static constexpr bool has_infinity = Format::kHasInfinity;
+  static constexpr bool has_quiet_NaN = true;
+  static Type min() { return Type::FromBits(1 << Format::kMantissaBits); }
+  static Type max() { return Type::FromBits(Format::kMaxFiniteBits); }
+  static Type lowest() { return Type::FromBits(0x80 | Format::kMaxFiniteBits); }
+};
+
+}  // namespace std
+
+#endif  // RUY_RUY_FLOAT8_H_
@@ -20,6 +20,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "ruy/common.h"
+#include "ruy/float16.h"
 #include "ruy/kernel_common.h"
 #include "ruy/mat.h"
 #include "ruy/matrix.h"
@@ -149,6 +150,34 @@ struct Kernel<Path::kNeon, float, float, float, MulParams<float, float>> {
     }
   }
 };
+
+void StoreFloat16BlockNeon(const float* block, int rows, int cols, Half* dst,
+                           int dst_stride);
+void StoreFloat16BlockNeon(const float* block, int rows, int cols,
+                           BFloat16* dst, int dst_stride);
+
+// The float kernel, for 16-bit floating-point destinations. See
+// RunFloatKernelWithFloat16Dst.
+template <int kExponentBits>
+struct Kernel<Path::kNeon, float, float, Float16<kExponentBits>,
+              MulParams<float, Float16<kExponentBits>>> {
+  using DstScalar = Float16<kExponentBits>;
+  Tuning tuning = Tuning::kAuto;
+  using LhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 8>;
+  using RhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 8>;
+  explicit Kernel(Tuning tuning_) : tuning(tuning_) {}
+  void Run(const PMat<float>& lhs, const PMat<float>& rhs,
+           const MulParams<float, DstScalar>& mul_params, int start_row,
+           int start_col, int end_row, int end_col,
+           Mat<DstScalar>* dst) const {
+    RunFloatKernelWithFloat16Dst(lhs, rhs, mul_params, start_row, start_col,
+                                 end_row, end_col, dst,
+                                 tuning == Tuning::kInOrder
+                                     ? &KernelFloatNeonInOrder
+                                     : &KernelFloatNeonOutOfOrder,
+                                 &StoreFloat16BlockNeon);
+  }
+};
 #endif
 
 #if RUY_PLATFORM_NEON_32
@@ -14,13 +14,19 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
+#include <cstring>
 
 #include "ruy/common.h"
+#include "ruy/float16.h"
 #include "ruy/kernel.h"
 #include "ruy/opt_set.h"
 #include "ruy/platform.h"
 #include "ruy/profiler/instrumentation.h"
 
+#if RUY_PLATFORM_NEON_64 && RUY_OPT(ASM)
+#include <arm_neon.h>
+#endif
+
 namespace ruy {
 
 #if RUY_PLATFORM_NEON_64 && RUY_OPT(ASM)
@@ -7830,6 +7836,64 @@ void KernelFloatNeonDotprodInOrder(const KernelParamsFloat<8, 8>& params) {
 #undef RUY_OFFSET_RHS_BASE_PTR
 #undef RUY_OFFSET_DST_BASE_PTR
 
+namespace {
+
+// Converts 4 floats to binary16, rounding to nearest even (the default FPCR
+// rounding mode).
+inline uint16x4_t ConvertToHalf(const float32x4_t v) {
+  return vreinterpret_u16_f16(vcvt_f16_f32(v));
+}
+
+// Converts 4 floats to bfloat16, rounding to nearest even. Same as
+// detail::FloatToFloat16Bits<8>: adding 0x7fff plus the lowest kept bit
+// rounds to nearest even, and NaNs just get their quiet bit set.
+inline uint16x4_t ConvertToBFloat16(const float32x4_t v) {
+  const uint32x4_t bits = vreinterpretq_u32_f32(v);
+  const uint32x4_t lowest_kept_bit =
+      vandq_u32(vshrq_n_u32(bits, 16), vdupq_n_u32(1));
+  const uint32x4_t rounded =
+      vaddq_u32(bits, vaddq_u32(lowest_kept_bit, vdupq_n_u32(0x7fff)));
+  const uint32x4_t quiet_nan = vorrq_u32(bits, vdupq_n_u32(0x400000));
+  const uint32x4_t is_not_nan = vceqq_f32(v, v);
+  return vshrn_n_u32(vbslq_u32(is_not_nan, rounded, quiet_nan), 16);
+}
+
+template <typename DstScalar, typename ConvertFn>
+void StoreFloat16BlockNeonImpl(const float* block, int rows, int cols,
+                               DstScalar* dst, int dst_stride,
+                               ConvertFn convert) {
+  RUY_DCHECK_LE(rows, 8);
+  RUY_DCHECK_LE(cols, 8);
+  for (int col = 0; col < cols; col++) {
+    const float* block_ptr = block + 8 * col;
+    const uint16x8_t converted =
+        vcombine_u16(convert(vld1q_f32(block_ptr)),
+                     convert(vld1q_f32(block_ptr + 4)));
+    DstScalar* dst_ptr = dst + col * dst_stride;
+    if (rows == 8) {
+      vst1q_u16(reinterpret_cast<std::uint16_t*>(dst_ptr), converted);
+    } else {
+      std::uint16_t buf[8];
+      vst1q_u16(buf, converted);
+      std::memcpy(dst_ptr, buf, rows * sizeof(std::uint16_t));
+    }
+  }
+}
+
+}  // namespace
+
+void StoreFloat16BlockNeon(const float* block, int rows, int cols, Half* dst,
+                           int dst_stride) {
+  StoreFloat16BlockNeonImpl(block, rows, cols, dst, dst_stride,
+                            ConvertToHalf);
+}
+
+void StoreFloat16BlockNeon(const float* block, int rows, int cols,
+                           BFloat16* dst, int dst_stride) {
+  StoreFloat16BlockNeonImpl(block, rows, cols, dst, dst_stride,
+                            ConvertToBFloat16);
+}
+
 #endif  // RUY_PLATFORM_NEON_64 && RUY_OPT(ASM)
 
 }  // namespace ruy
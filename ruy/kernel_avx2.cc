@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstring>
 
 #include "ruy/check_macros.h"
+#include "ruy/float16.h"
 #include "ruy/kernel.h"
 #include "ruy/opt_set.h"
 #include "ruy/platform.h"
@@ -51,6 +52,16 @@ void KernelFloatAvx2SingleCol(const KernelParamsFloat<8, 8>&) {
   RUY_DCHECK(false);
 }
 
+void StoreFloat16BlockAvx2(const float*, int, int, Half*, int) {
+  // CPU-ID-based checks should disable the path that would reach this point.
+  RUY_DCHECK(false);
+}
+
+void StoreFloat16BlockAvx2(const float*, int, int, BFloat16*, int) {
+  // CPU-ID-based checks should disable the path that would reach this point.
+  RUY_DCHECK(false);
+}
+
 #else  // RUY_PLATFORM_AVX2 && RUY_OPT(ASM)
 
 static constexpr int kAvx8bitBlockSize = 8;
@@ -388,6 +399,48 @@ inline void mm256_n_storeu_ps(float* dst, int residual_rows, const __m256 v) {
     dst[i] = intrin_utils::mm256_get1_ps(v, i);
   }
 }
+
+// Multiplies int32 accumulators by float multipliers, rounding to nearest with
+// ties to even (the default MXCSR rounding mode). Bit-exact with
+// ruy::detail::MultiplyByFloatMultiplier.
+// Transposes the 8x8 block of int32 values whose columns are v0, ..., v7.
+inline void mm256_transpose8x8_epi32(__m256i* v0, __m256i* v1, __m256i* v2,
+                                     __m256i* v3, __m256i* v4, __m256i* v5,
+                                     __m256i* v6, __m256i* v7) {
+  const __m256i t0 = _mm256_unpacklo_epi32(*v0, *v1);
+  const __m256i t1 = _mm256_unpackhi_epi32(*v0, *v1);
+  const __m256i t2 = _mm256_unpacklo_epi32(*v2, *v3);
+  const __m256i t3 = _mm256_unpackhi_epi32(*v2, *v3);
+  const __m256i t4 = _mm256_unpacklo_epi32(*v4, *v5);
+  const __m256i t5 = _mm256_unpackhi_epi32(*v4, *v5);
+  const __m256i t6 = _mm256_unpacklo_epi32(*v6, *v7);
+  const __m256i t7 = _mm256_unpackhi_epi32(*v6, *v7);
+  const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+  const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+  const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+  const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+  const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+  const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+  const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+  const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+  *v0 = _mm256_permute2x128_si256(u0, u4, 0x20);
+  *v1 = _mm256_permute2x128_si256(u1, u5, 0x20);
+  *v2 = _mm256_permute2x128_si256(u2, u6, 0x20);
+  *v3 = _mm256_permute2x128_si256(u3, u7, 0x20);
+  *v4 = _mm256_permute2x128_si256(u0, u4, 0x31);
+  *v5 = _mm256_permute2x128_si256(u1, u5, 0x31);
+  *v6 = _mm256_permute2x128_si256(u2, u6, 0x31);
+  *v7 = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+inline __m256i mm256_scale_epi32(const __m256i accum, const __m256 multiplier) {
+  __m256 scaled = _mm256_mul_ps(_mm256_cvtepi32_ps(accum), multiplier);
+  // Saturate to [-2^30, 2^30], so that adding the destination zero point
+  // can't overflow.
+  scaled = _mm256_min_ps(scaled, _mm256_set1_ps(1073741824.f));
+  scaled = _mm256_max_ps(scaled, _mm256_set1_ps(-1073741824.f));
+  return _mm256_cvtps_epi32(scaled);
+}
 }  // namespace intrin_utils
 }  // namespace
 
@@ -412,15 +465,20 @@ void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
     RUY_DCHECK(false);
   }
 
-  int bias_ptr_block_increment =
-      params.flags & RUY_ASM_FLAG_HAS_BIAS ? kAvx8bitBlockSize : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias and per-channel
+  // multipliers vary along columns instead of rows.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? kAvx8bitBlockSize : 0;
 
   const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
   void* dst_col_ptr = params.dst_base_ptr;
-  const std::int32_t* bias_col_ptr = params.bias;
-  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
-    bias_col_ptr += params.start_row;
-  }
+  const std::int32_t* bias_col_ptr =
+      has_row_bias ? params.bias + params.start_row : params.zero_data;
 
   for (int col = params.start_col; col <= params.last_col;
        col += kAvx8bitBlockSize) {
@@ -429,14 +487,27 @@ void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
     const std::int32_t* bias_ptr = bias_col_ptr;
 
     const std::int32_t lhs_zero_point = params.lhs_zero_point;
-    const bool has_rhs_sums_offsets =
+    const bool has_rhs_sums =
         (params.flags & RUY_ASM_FLAG_HAS_RHS_SUMS) && lhs_zero_point;
+    // A per-column bias is folded into the offsets subtracted from each
+    // column.
+    const bool has_rhs_sums_offsets = has_rhs_sums || has_col_bias;
     std::int32_t rhs_sums_offsets[8];
     if (has_rhs_sums_offsets) {
-      const __m256i rhs_sums_offset_v = _mm256_mullo_epi32(
-          _mm256_set1_epi32(lhs_zero_point),
-          _mm256_loadu_si256(
-              reinterpret_cast<__m256i const*>(&params.rhs_sums[col])));
+      __m256i rhs_sums_offset_v = _mm256_setzero_si256();
+      if (has_rhs_sums) {
+        rhs_sums_offset_v = _mm256_mullo_epi32(
+            _mm256_set1_epi32(lhs_zero_point),
+            _mm256_loadu_si256(
+                reinterpret_cast<__m256i const*>(&params.rhs_sums[col])));
+      }
+      if (has_col_bias) {
+        rhs_sums_offset_v = _mm256_sub_epi32(
+            rhs_sums_offset_v,
+            intrin_utils::mm256_n_loadu_epi32(
+                std::min(params.dst_cols - col, kAvx8bitBlockSize),
+                &params.bias[col]));
+      }
       _mm256_storeu_si256(reinterpret_cast<__m256i*>(rhs_sums_offsets),
                           rhs_sums_offset_v);
     }
@@ -481,6 +552,22 @@ void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
                                               _mm256_set1_epi32(prod_zp_depth));
       }
 
+      // Per-channel LHS zero points. The part of the correction that does not
+      // depend on the column is folded into initial_accum_data here, the rest
+      // is applied to each column below.
+      const bool has_lhs_zero_point_perchannel =
+          params.flags & RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL;
+      __m256i lhs_zero_point_perchannel_v = _mm256_setzero_si256();
+      if (has_lhs_zero_point_perchannel) {
+        lhs_zero_point_perchannel_v = intrin_utils::mm256_n_loadu_epi32(
+            residual_rows, &params.lhs_zero_point_perchannel[row]);
+        const std::int32_t rhs_zp_depth = rhs_zero_point * params.depth;
+        initial_accum_data = _mm256_add_epi32(
+            initial_accum_data,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_zp_depth)));
+      }
+
       // Adjustments differing across columns.
       if (has_rhs_sums_offsets) {
         accum_data_v0 = _mm256_sub_epi32(
@@ -509,6 +596,41 @@ void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
         accum_data_v6 = initial_accum_data;
         accum_data_v7 = initial_accum_data;
       }
+      if (has_lhs_zero_point_perchannel) {
+        const std::int32_t* rhs_sums = params.rhs_sums + col;
+        accum_data_v0 = _mm256_sub_epi32(
+            accum_data_v0,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[0])));
+        accum_data_v1 = _mm256_sub_epi32(
+            accum_data_v1,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[1])));
+        accum_data_v2 = _mm256_sub_epi32(
+            accum_data_v2,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[2])));
+        accum_data_v3 = _mm256_sub_epi32(
+            accum_data_v3,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[3])));
+        accum_data_v4 = _mm256_sub_epi32(
+            accum_data_v4,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[4])));
+        accum_data_v5 = _mm256_sub_epi32(
+            accum_data_v5,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[5])));
+        accum_data_v6 = _mm256_sub_epi32(
+            accum_data_v6,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[6])));
+        accum_data_v7 = _mm256_sub_epi32(
+            accum_data_v7,
+            _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm256_set1_epi32(rhs_sums[7])));
+      }
 
       const std::int8_t* lhs_ptr = lhs_col_ptr;
       const std::int8_t* rhs_ptr = rhs_col_ptr;
@@ -675,15 +797,63 @@ void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
         rhs_ptr += kAvx8bitBlockSize * kAvx8bitInnerSize;
       }
 
-      if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
+      // The multipliers are applied along the lanes of each register. To
+      // apply per-column multipliers, the block is transposed around this.
+      const bool transpose_for_multiplier =
+          channel_dimension_is_col &&
+          (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL);
+      const int channel = transpose_for_multiplier ? col : row;
+      const int residual_channels =
+          transpose_for_multiplier ? residual_cols : residual_rows;
+      if (transpose_for_multiplier) {
+        intrin_utils::mm256_transpose8x8_epi32(
+            &accum_data_v0, &accum_data_v1, &accum_data_v2, &accum_data_v3,
+            &accum_data_v4, &accum_data_v5, &accum_data_v6, &accum_data_v7);
+      }
+      if (params.dst_type_id != DstTypeId<std::int32_t>::kValue &&
+          (params.flags & RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT)) {
+        __m256 multiplier_v;
+        if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
+          multiplier_v = intrin_utils::mm256_n_loadu_ps(
+              residual_channels, &params.multiplier_float[channel]);
+        } else {
+          // This array has size LhsCols, and is pre-filled.
+          multiplier_v = _mm256_set1_ps(params.multiplier_float[0]);
+        }
+        const __m256i dst_zero_point = _mm256_set1_epi32(params.dst_zero_point);
+        accum_data_v0 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v0, multiplier_v),
+            dst_zero_point);
+        accum_data_v1 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v1, multiplier_v),
+            dst_zero_point);
+        accum_data_v2 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v2, multiplier_v),
+            dst_zero_point);
+        accum_data_v3 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v3, multiplier_v),
+            dst_zero_point);
+        accum_data_v4 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v4, multiplier_v),
+            dst_zero_point);
+        accum_data_v5 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v5, multiplier_v),
+            dst_zero_point);
+        accum_data_v6 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v6, multiplier_v),
+            dst_zero_point);
+        accum_data_v7 = _mm256_add_epi32(
+            intrin_utils::mm256_scale_epi32(accum_data_v7, multiplier_v),
+            dst_zero_point);
+      } else if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
         __m256i m_vector;
         __m256i e_vector;
         // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
         if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
           m_vector = intrin_utils::mm256_n_loadu_epi32(
-              residual_rows, &params.multiplier_fixedpoint[row]);
+              residual_channels, &params.multiplier_fixedpoint[channel]);
           e_vector = intrin_utils::mm256_n_loadu_epi32(
-              residual_rows, &params.multiplier_exponent[row]);
+              residual_channels, &params.multiplier_exponent[channel]);
         } else {
           // These arrays have size LhsCols, and are pre-filled.
           m_vector = _mm256_set1_epi32(params.multiplier_fixedpoint[0]);
@@ -990,6 +1160,11 @@ void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params) {
           accum_data_v7 = _mm256_sub_epi32(results, post_scaling_offset);
         }
       }
+      if (transpose_for_multiplier) {
+        intrin_utils::mm256_transpose8x8_epi32(
+            &accum_data_v0, &accum_data_v1, &accum_data_v2, &accum_data_v3,
+            &accum_data_v4, &accum_data_v5, &accum_data_v6, &accum_data_v7);
+      }
       const __m256i clamp_max_v = _mm256_set1_epi32(params.clamp_max);
       const __m256i clamp_min_v = _mm256_set1_epi32(params.clamp_min);
       const bool store_full_block = (residual_rows == kAvx8bitBlockSize) &&
@@ -1200,15 +1375,22 @@ void Kernel8bitAvx2SingleCol(const KernelParams8bit<8, 8>& params) {
       2, 3, 6, 7, 10, 11, 14, 15   //
   };
 
-  int bias_ptr_block_increment =
-      params.flags & RUY_ASM_FLAG_HAS_BIAS ? kAvx8bitBlockSize : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias and per-channel
+  // multipliers are those of the single column, at index 0.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  const bool has_row_multipliers =
+      (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) && !channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? kAvx8bitBlockSize : 0;
 
   const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
   void* dst_col_ptr = params.dst_base_ptr;
-  const std::int32_t* bias_col_ptr = params.bias;
-  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
-    bias_col_ptr += params.start_row;
-  }
+  const std::int32_t* bias_col_ptr =
+      has_row_bias ? params.bias + params.start_row : params.zero_data;
 
   const std::int8_t* lhs_col_ptr = params.lhs_base_ptr;
   void* dst_ptr = dst_col_ptr;
@@ -1239,7 +1421,9 @@ void Kernel8bitAvx2SingleCol(const KernelParams8bit<8, 8>& params) {
 
     // Initialize with bias.
     __m256i initial_accum_data =
-        intrin_utils::mm256_n_loadu_epi32(residual_rows, bias_ptr);
+        has_col_bias
+            ? _mm256_set1_epi32(params.bias[0])
+            : intrin_utils::mm256_n_loadu_epi32(residual_rows, bias_ptr);
     bias_ptr += bias_ptr_block_increment;
 
     // Adjustments common across columns.
@@ -1258,6 +1442,22 @@ void Kernel8bitAvx2SingleCol(const KernelParams8bit<8, 8>& params) {
                                             _mm256_set1_epi32(prod_zp_depth));
     }
 
+    // Per-channel LHS zero points. The part of the correction that does not
+    // depend on the column is folded into initial_accum_data here, the rest
+    // is applied to each column below.
+    const bool has_lhs_zero_point_perchannel =
+        params.flags & RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL;
+    __m256i lhs_zero_point_perchannel_v = _mm256_setzero_si256();
+    if (has_lhs_zero_point_perchannel) {
+      lhs_zero_point_perchannel_v = intrin_utils::mm256_n_loadu_epi32(
+          residual_rows, &params.lhs_zero_point_perchannel[row]);
+      const std::int32_t rhs_zp_depth = rhs_zero_point * params.depth;
+      initial_accum_data = _mm256_add_epi32(
+          initial_accum_data,
+          _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                             _mm256_set1_epi32(rhs_zp_depth)));
+    }
+
     // Adjustments differing across columns.
     if (has_rhs_sums_offsets) {
       accum_data_v0 = _mm256_sub_epi32(initial_accum_data,
@@ -1265,6 +1465,13 @@ void Kernel8bitAvx2SingleCol(const KernelParams8bit<8, 8>& params) {
     } else {
       accum_data_v0 = initial_accum_data;
     }
+    if (has_lhs_zero_point_perchannel) {
+      const std::int32_t* rhs_sums = params.rhs_sums;
+      accum_data_v0 = _mm256_sub_epi32(
+          accum_data_v0,
+          _mm256_mullo_epi32(lhs_zero_point_perchannel_v,
+                             _mm256_set1_epi32(rhs_sums[0])));
+    }
 
     const std::int8_t* lhs_ptr = lhs_col_ptr;
     const std::int8_t* rhs_ptr = rhs_col_ptr;
@@ -1314,17 +1521,33 @@ void Kernel8bitAvx2SingleCol(const KernelParams8bit<8, 8>& params) {
       rhs_ptr += kAvx8bitBlockSize * kAvx8bitInnerSize;
     }
 
-    if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
+    if (params.dst_type_id != DstTypeId<std::int32_t>::kValue &&
+        (params.flags & RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT)) {
+      __m256 multiplier_v;
+      if (has_row_multipliers) {
+        multiplier_v = intrin_utils::mm256_n_loadu_ps(
+            residual_rows, &params.multiplier_float[row]);
+      } else {
+        // This array has size LhsCols, and is pre-filled, or holds the
+        // per-column multiplier.
+        multiplier_v = _mm256_set1_ps(params.multiplier_float[0]);
+      }
+      const __m256i dst_zero_point = _mm256_set1_epi32(params.dst_zero_point);
+      accum_data_v0 = _mm256_add_epi32(
+          intrin_utils::mm256_scale_epi32(accum_data_v0, multiplier_v),
+          dst_zero_point);
+    } else if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
       __m256i m_vector;
       __m256i e_vector;
       // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
-      if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
+      if (has_row_multipliers) {
         m_vector = intrin_utils::mm256_n_loadu_epi32(
             residual_rows, &params.multiplier_fixedpoint[row]);
         e_vector = intrin_utils::mm256_n_loadu_epi32(
             residual_rows, &params.multiplier_exponent[row]);
       } else {
-        // These arrays have size LhsCols, and are pre-filled.
+        // These arrays have size LhsCols, and are pre-filled, or hold the
+        // per-column multiplier.
         m_vector = _mm256_set1_epi32(params.multiplier_fixedpoint[0]);
         e_vector = _mm256_set1_epi32(params.multiplier_exponent[0]);
       }
@@ -1461,8 +1684,15 @@ void KernelFloatAvx2(const KernelParamsFloat<8, 8>& params) {
   const std::int64_t lhs_stride = params.lhs_stride >> 2;
   const std::int64_t dst_stride = params.dst_stride >> 2;
   const std::int64_t rhs_stride = params.rhs_stride >> 2;
-  //
-  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 1 : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias varies along columns
+  // instead of rows.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? 1 : 0;
   // AVX2 float block size = 8.
   const int end_row = std::min(params.dst_rows, params.last_row + 8);
   const int end_col = std::min(params.dst_cols, params.last_col + 8);
@@ -1473,7 +1703,8 @@ void KernelFloatAvx2(const KernelParamsFloat<8, 8>& params) {
       params.dst_base_ptr - params.start_col * dst_stride - params.start_row;
   const float* adj_lhs_col_ptr =
       params.lhs_base_ptr - params.start_row * lhs_stride;
-  const float* bias_col_ptr = params.bias;
+  const float* bias_col_ptr =
+      channel_dimension_is_col ? params.zero_data : params.bias;
 
   const __m256 clamp_max_v = _mm256_set1_ps(params.clamp_max);
   const __m256 clamp_min_v = _mm256_set1_ps(params.clamp_min);
@@ -1494,11 +1725,16 @@ void KernelFloatAvx2(const KernelParamsFloat<8, 8>& params) {
       const float* bias_ptr = bias_col_ptr + row * bias_ptr_block_increment;
 
       // Initialize with bias.
-      const __m256 initial_accum_data =
-          intrin_utils::mm256_n_loadu_ps(residual_rows, bias_ptr);
-
-      for (int j = 0; j < 8; ++j) {
-        accum_data_v[j] = initial_accum_data;
+      if (has_col_bias) {
+        for (int j = 0; j < 8; ++j) {
+          accum_data_v[j] = _mm256_set1_ps(params.bias[col + j]);
+        }
+      } else {
+        const __m256 initial_accum_data =
+            intrin_utils::mm256_n_loadu_ps(residual_rows, bias_ptr);
+        for (int j = 0; j < 8; ++j) {
+          accum_data_v[j] = initial_accum_data;
+        }
       }
 
       const float* lhs_ptr = lhs_col_ptr;
@@ -1558,11 +1794,17 @@ void KernelFloatAvx2(const KernelParamsFloat<8, 8>& params) {
       const float* bias_ptr = bias_col_ptr + row * bias_ptr_block_increment;
 
       // Initialize with bias.
-      const __m256 initial_accum_data =
-          intrin_utils::mm256_n_loadu_ps(residual_rows, bias_ptr);
-
-      for (int j = 0; j < 8; ++j) {
-        accum_data_v[j] = initial_accum_data;
+      if (has_col_bias) {
+        for (int j = 0; j < 8; ++j) {
+          accum_data_v[j] =
+              _mm256_set1_ps(j < residual_cols ? params.bias[col + j] : 0);
+        }
+      } else {
+        const __m256 initial_accum_data =
+            intrin_utils::mm256_n_loadu_ps(residual_rows, bias_ptr);
+        for (int j = 0; j < 8; ++j) {
+          accum_data_v[j] = initial_accum_data;
+        }
       }
 
       const float* lhs_ptr = lhs_col_ptr;
@@ -1600,15 +1842,23 @@ void KernelFloatAvx2SingleCol(const KernelParamsFloat<8, 8>& params) {
 
   // As parameters are defined, we need to scale by sizeof(float).
   const std::int64_t lhs_stride = params.lhs_stride >> 2;
-  //
-  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 1 : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias is that of the single
+  // column, at index 0.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? 1 : 0;
   // AVX2 float block size = 8.
   const int end_row = std::min(params.dst_rows, params.last_row + 8);
 
   float* adj_dst_col_ptr = params.dst_base_ptr - params.start_row;
   const float* adj_lhs_col_ptr =
       params.lhs_base_ptr - params.start_row * lhs_stride;
-  const float* bias_col_ptr = params.bias;
+  const float* bias_col_ptr =
+      channel_dimension_is_col ? params.zero_data : params.bias;
 
   const __m256 clamp_max_v = _mm256_set1_ps(params.clamp_max);
   const __m256 clamp_min_v = _mm256_set1_ps(params.clamp_min);
@@ -1625,7 +1875,8 @@ void KernelFloatAvx2SingleCol(const KernelParamsFloat<8, 8>& params) {
     const float* bias_ptr = bias_col_ptr + row * bias_ptr_block_increment;
 
     // Initialize with bias.
-    accum_data_v = _mm256_loadu_ps(bias_ptr);
+    accum_data_v = has_col_bias ? _mm256_set1_ps(params.bias[0])
+                                : _mm256_loadu_ps(bias_ptr);
 
     const float* lhs_ptr = lhs_col_ptr;
     const float* rhs_ptr = rhs_col_ptr;
@@ -1676,7 +1927,9 @@ void KernelFloatAvx2SingleCol(const KernelParamsFloat<8, 8>& params) {
     const float* bias_ptr = bias_col_ptr + row * bias_ptr_block_increment;
 
     // Initialize with bias.
-    accum_data_v = intrin_utils::mm256_n_loadu_ps(residual_rows, bias_ptr);
+    accum_data_v =
+        has_col_bias ? _mm256_set1_ps(params.bias[0])
+                     : intrin_utils::mm256_n_loadu_ps(residual_rows, bias_ptr);
 
     const float* lhs_ptr = lhs_col_ptr;
     const float* rhs_ptr = rhs_col_ptr;
@@ -1696,6 +1949,65 @@ void KernelFloatAvx2SingleCol(const KernelParamsFloat<8, 8>& params) {
   }  // End handling of residual rows.
 }
 
+namespace {
+
+// Converts 8 floats to binary16, rounding to nearest even (F16C).
+inline __m128i mm256_cvtps_half(const __m256 v) {
+  return _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+}
+
+// Converts 8 floats to bfloat16, rounding to nearest even. Same as
+// detail::FloatToFloat16Bits<8>: adding 0x7fff plus the lowest kept bit
+// rounds to nearest even, and NaNs just get their quiet bit set.
+inline __m128i mm256_cvtps_bfloat16(const __m256 v) {
+  const __m256i bits = _mm256_castps_si256(v);
+  const __m256i lowest_kept_bit =
+      _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+  const __m256i rounded = _mm256_add_epi32(
+      bits, _mm256_add_epi32(lowest_kept_bit, _mm256_set1_epi32(0x7fff)));
+  const __m256i quiet_nan = _mm256_or_si256(bits, _mm256_set1_epi32(0x400000));
+  const __m256i is_nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+  const __m256i result =
+      _mm256_srli_epi32(_mm256_blendv_epi8(rounded, quiet_nan, is_nan), 16);
+  // packus works within 128-bit lanes, so gather the 64-bit halves that hold
+  // the results of both lanes.
+  return _mm256_castsi256_si128(_mm256_permute4x64_epi64(
+      _mm256_packus_epi32(result, result), 0x08));
+}
+
+template <typename DstScalar, typename ConvertFn>
+void StoreFloat16BlockAvx2Impl(const float* block, int rows, int cols,
+                               DstScalar* dst, int dst_stride,
+                               ConvertFn convert) {
+  RUY_DCHECK_LE(rows, 8);
+  RUY_DCHECK_LE(cols, 8);
+  for (int col = 0; col < cols; col++) {
+    const __m128i converted = convert(_mm256_loadu_ps(block + 8 * col));
+    DstScalar* dst_ptr = dst + col * dst_stride;
+    if (rows == 8) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), converted);
+    } else {
+      std::uint16_t buf[8];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), converted);
+      std::memcpy(dst_ptr, buf, rows * sizeof(std::uint16_t));
+    }
+  }
+}
+
+}  // namespace
+
+void StoreFloat16BlockAvx2(const float* block, int rows, int cols, Half* dst,
+                           int dst_stride) {
+  StoreFloat16BlockAvx2Impl(block, rows, cols, dst, dst_stride,
+                            mm256_cvtps_half);
+}
+
+void StoreFloat16BlockAvx2(const float* block, int rows, int cols,
+                           BFloat16* dst, int dst_stride) {
+  StoreFloat16BlockAvx2Impl(block, rows, cols, dst, dst_stride,
+                            mm256_cvtps_bfloat16);
+}
+
 #endif  //  RUY_PLATFORM_AVX2 && RUY_OPT(ASM)
 
 }  // namespace ruy
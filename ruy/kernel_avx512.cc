@@ -17,6 +17,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "ruy/check_macros.h"
+#include "ruy/float16.h"
 #include "ruy/kernel.h"
 #include "ruy/opt_set.h"
 #include "ruy/platform.h"
@@ -50,8 +51,69 @@ void KernelFloatAvx512SingleCol(const KernelParamsFloat<16, 16>&) {
   RUY_DCHECK(false);
 }
 
+void StoreFloat16BlockAvx512(const float*, int, int, Half*, int) {
+  // CPU-ID-based checks should disable the path that would reach this point.
+  RUY_DCHECK(false);
+}
+
+void StoreFloat16BlockAvx512(const float*, int, int, BFloat16*, int) {
+  // CPU-ID-based checks should disable the path that would reach this point.
+  RUY_DCHECK(false);
+}
+
 #else  // RUY_PLATFORM_AVX512 && RUY_OPT(ASM)
 
+namespace {
+
+// Multiplies int32 accumulators by float multipliers, rounding to nearest with
+// ties to even (the default MXCSR rounding mode). Bit-exact with
+// ruy::detail::MultiplyByFloatMultiplier.
+inline __m512i mm512_scale_epi32(const __m512i accum, const __m512 multiplier) {
+  __m512 scaled = _mm512_mul_ps(_mm512_cvtepi32_ps(accum), multiplier);
+  // Saturate to [-2^30, 2^30], so that adding the destination zero point
+  // can't overflow.
+  scaled = _mm512_min_ps(scaled, _mm512_set1_ps(1073741824.f));
+  scaled = _mm512_max_ps(scaled, _mm512_set1_ps(-1073741824.f));
+  return _mm512_cvtps_epi32(scaled);
+}
+
+// Transposes the 16x16 block of int32 values whose columns are v0, ..., vf.
+inline void mm512_transpose16x16_epi32(__m512i* v0, __m512i* v1, __m512i* v2,
+                                       __m512i* v3, __m512i* v4, __m512i* v5,
+                                       __m512i* v6, __m512i* v7, __m512i* v8,
+                                       __m512i* v9, __m512i* va, __m512i* vb,
+                                       __m512i* vc, __m512i* vd, __m512i* ve,
+                                       __m512i* vf) {
+  __m512i* v[16] = {v0, v1, v2, v3, v4, v5, v6, v7,
+                    v8, v9, va, vb, vc, vd, ve, vf};
+  __m512i t[16];
+  for (int i = 0; i < 16; i += 2) {
+    t[i] = _mm512_unpacklo_epi32(*v[i], *v[i + 1]);
+    t[i + 1] = _mm512_unpackhi_epi32(*v[i], *v[i + 1]);
+  }
+  // In each 128-bit lane l, u[g + e] holds element 4 * l + e of columns g to
+  // g + 3.
+  __m512i u[16];
+  for (int g = 0; g < 16; g += 4) {
+    u[g] = _mm512_unpacklo_epi64(t[g], t[g + 2]);
+    u[g + 1] = _mm512_unpackhi_epi64(t[g], t[g + 2]);
+    u[g + 2] = _mm512_unpacklo_epi64(t[g + 1], t[g + 3]);
+    u[g + 3] = _mm512_unpackhi_epi64(t[g + 1], t[g + 3]);
+  }
+  for (int e = 0; e < 4; e++) {
+    const __m512i x0 = _mm512_shuffle_i32x4(u[e], u[4 + e], 0x88);
+    const __m512i x1 = _mm512_shuffle_i32x4(u[e], u[4 + e], 0xdd);
+    const __m512i y0 = _mm512_shuffle_i32x4(u[8 + e], u[12 + e], 0x88);
+    const __m512i y1 = _mm512_shuffle_i32x4(u[8 + e], u[12 + e], 0xdd);
+    *v[e] = _mm512_shuffle_i32x4(x0, y0, 0x88);
+    *v[4 + e] = _mm512_shuffle_i32x4(x1, y1, 0x88);
+    *v[8 + e] = _mm512_shuffle_i32x4(x0, y0, 0xdd);
+    *v[12 + e] = _mm512_shuffle_i32x4(x1, y1, 0xdd);
+  }
+}
+
+}  // namespace
+
 void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
   profiler::ScopeLabel label("Kernel kAvx512 8-bit");
 
@@ -67,14 +129,20 @@ void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
     RUY_DCHECK(false);
   }
 
-  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 16 : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias and per-channel
+  // multipliers vary along columns instead of rows.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? 16 : 0;
 
   const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
   void* dst_col_ptr = params.dst_base_ptr;
-  const std::int32_t* bias_col_ptr = params.bias;
-  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
-    bias_col_ptr += params.start_row;
-  }
+  const std::int32_t* bias_col_ptr =
+      has_row_bias ? params.bias + params.start_row : params.zero_data;
 
   for (int col = params.start_col; col <= params.last_col; col += 16) {
     const std::int8_t* lhs_col_ptr = params.lhs_base_ptr;
@@ -82,13 +150,28 @@ void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
     const std::int32_t* bias_ptr = bias_col_ptr;
 
     const std::int32_t lhs_zero_point = params.lhs_zero_point;
-    const bool has_rhs_sums_offsets =
+    const bool has_rhs_sums =
         (params.flags & RUY_ASM_FLAG_HAS_RHS_SUMS) && lhs_zero_point;
+    // A per-column bias is folded into the offsets subtracted from each
+    // column.
+    const bool has_rhs_sums_offsets = has_rhs_sums || has_col_bias;
     std::int32_t rhs_sums_offsets[16];
     if (has_rhs_sums_offsets) {
-      const __m512i rhs_sums_offset_v =
-          _mm512_mullo_epi32(_mm512_set1_epi32(lhs_zero_point),
-                             _mm512_loadu_si512(&params.rhs_sums[col]));
+      __m512i rhs_sums_offset_v = _mm512_setzero_si512();
+      if (has_rhs_sums) {
+        rhs_sums_offset_v =
+            _mm512_mullo_epi32(_mm512_set1_epi32(lhs_zero_point),
+                               _mm512_loadu_si512(&params.rhs_sums[col]));
+      }
+      if (has_col_bias) {
+        const __mmask16 col_mask =
+            (static_cast<std::uint32_t>(1)
+             << std::min(params.dst_cols - col, 16)) -
+            1;
+        rhs_sums_offset_v = _mm512_sub_epi32(
+            rhs_sums_offset_v,
+            _mm512_maskz_loadu_epi32(col_mask, &params.bias[col]));
+      }
       _mm512_storeu_si512(reinterpret_cast<__m512i*>(rhs_sums_offsets),
                           rhs_sums_offset_v);
     }
@@ -135,6 +218,22 @@ void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
                                               _mm512_set1_epi32(prod_zp_depth));
       }
 
+      // Per-channel LHS zero points. The part of the correction that does not
+      // depend on the column is folded into initial_accum_data here, the rest
+      // is applied to each column below.
+      const bool has_lhs_zero_point_perchannel =
+          params.flags & RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL;
+      __m512i lhs_zero_point_perchannel_v = _mm512_setzero_si512();
+      if (has_lhs_zero_point_perchannel) {
+        lhs_zero_point_perchannel_v = _mm512_maskz_loadu_epi32(
+            row_mask, &params.lhs_zero_point_perchannel[row]);
+        const std::int32_t rhs_zp_depth = rhs_zero_point * params.depth;
+        initial_accum_data = _mm512_add_epi32(
+            initial_accum_data,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_zp_depth)));
+      }
+
       // Adjustments differing across columns.
       if (has_rhs_sums_offsets) {
         accum_data_v0 = _mm512_sub_epi32(
@@ -187,6 +286,73 @@ void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
         accum_data_ve = initial_accum_data;
         accum_data_vf = initial_accum_data;
       }
+      if (has_lhs_zero_point_perchannel) {
+        const std::int32_t* rhs_sums = params.rhs_sums + col;
+        accum_data_v0 = _mm512_sub_epi32(
+            accum_data_v0,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[0])));
+        accum_data_v1 = _mm512_sub_epi32(
+            accum_data_v1,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[1])));
+        accum_data_v2 = _mm512_sub_epi32(
+            accum_data_v2,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[2])));
+        accum_data_v3 = _mm512_sub_epi32(
+            accum_data_v3,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[3])));
+        accum_data_v4 = _mm512_sub_epi32(
+            accum_data_v4,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[4])));
+        accum_data_v5 = _mm512_sub_epi32(
+            accum_data_v5,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[5])));
+        accum_data_v6 = _mm512_sub_epi32(
+            accum_data_v6,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[6])));
+        accum_data_v7 = _mm512_sub_epi32(
+            accum_data_v7,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[7])));
+        accum_data_v8 = _mm512_sub_epi32(
+            accum_data_v8,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[8])));
+        accum_data_v9 = _mm512_sub_epi32(
+            accum_data_v9,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[9])));
+        accum_data_va = _mm512_sub_epi32(
+            accum_data_va,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[10])));
+        accum_data_vb = _mm512_sub_epi32(
+            accum_data_vb,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[11])));
+        accum_data_vc = _mm512_sub_epi32(
+            accum_data_vc,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[12])));
+        accum_data_vd = _mm512_sub_epi32(
+            accum_data_vd,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[13])));
+        accum_data_ve = _mm512_sub_epi32(
+            accum_data_ve,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[14])));
+        accum_data_vf = _mm512_sub_epi32(
+            accum_data_vf,
+            _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                               _mm512_set1_epi32(rhs_sums[15])));
+      }
 
       const std::int8_t* lhs_ptr = lhs_col_ptr;
       const std::int8_t* rhs_ptr = rhs_col_ptr;
@@ -463,15 +629,75 @@ void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
         rhs_ptr += 16 * 4;
       }
 
-      if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
+      // The multipliers are applied along the lanes of each register. To
+      // apply per-column multipliers, the block is transposed around this.
+      const bool transpose_for_multiplier =
+          channel_dimension_is_col &&
+          (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL);
+      const int channel = transpose_for_multiplier ? col : row;
+      const __mmask16 channel_mask =
+          transpose_for_multiplier
+              ? (static_cast<std::uint32_t>(1) << residual_cols) - 1
+              : row_mask;
+      if (transpose_for_multiplier) {
+        mm512_transpose16x16_epi32(
+            &accum_data_v0, &accum_data_v1, &accum_data_v2, &accum_data_v3,
+            &accum_data_v4, &accum_data_v5, &accum_data_v6, &accum_data_v7,
+            &accum_data_v8, &accum_data_v9, &accum_data_va, &accum_data_vb,
+            &accum_data_vc, &accum_data_vd, &accum_data_ve, &accum_data_vf);
+      }
+      if (params.dst_type_id != DstTypeId<std::int32_t>::kValue &&
+          (params.flags & RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT)) {
+        __m512 multiplier_v;
+        if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
+          multiplier_v = _mm512_maskz_loadu_ps(
+              channel_mask, &params.multiplier_float[channel]);
+        } else {
+          // This array has size LhsCols, and is pre-filled.
+          multiplier_v = _mm512_set1_ps(params.multiplier_float[0]);
+        }
+        const __m512i dst_zero_point = _mm512_set1_epi32(params.dst_zero_point);
+        accum_data_v0 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v0, multiplier_v), dst_zero_point);
+        accum_data_v1 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v1, multiplier_v), dst_zero_point);
+        accum_data_v2 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v2, multiplier_v), dst_zero_point);
+        accum_data_v3 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v3, multiplier_v), dst_zero_point);
+        accum_data_v4 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v4, multiplier_v), dst_zero_point);
+        accum_data_v5 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v5, multiplier_v), dst_zero_point);
+        accum_data_v6 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v6, multiplier_v), dst_zero_point);
+        accum_data_v7 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v7, multiplier_v), dst_zero_point);
+        accum_data_v8 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v8, multiplier_v), dst_zero_point);
+        accum_data_v9 = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_v9, multiplier_v), dst_zero_point);
+        accum_data_va = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_va, multiplier_v), dst_zero_point);
+        accum_data_vb = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_vb, multiplier_v), dst_zero_point);
+        accum_data_vc = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_vc, multiplier_v), dst_zero_point);
+        accum_data_vd = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_vd, multiplier_v), dst_zero_point);
+        accum_data_ve = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_ve, multiplier_v), dst_zero_point);
+        accum_data_vf = _mm512_add_epi32(
+            mm512_scale_epi32(accum_data_vf, multiplier_v), dst_zero_point);
+      } else if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
         __m512i m_vector;
         __m512i e_vector;
         // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
         if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
           m_vector = _mm512_maskz_loadu_epi32(
-              row_mask, &params.multiplier_fixedpoint[row]);
-          e_vector = _mm512_maskz_loadu_epi32(row_mask,
-                                              &params.multiplier_exponent[row]);
+              channel_mask, &params.multiplier_fixedpoint[channel]);
+          e_vector = _mm512_maskz_loadu_epi32(
+              channel_mask, &params.multiplier_exponent[channel]);
         } else {
           // These arrays have size LhsCols, and are pre-filled.
           m_vector = _mm512_set1_epi32(params.multiplier_fixedpoint[0]);
@@ -929,6 +1155,13 @@ void Kernel8bitAvx512(const KernelParams8bit<16, 16>& params) {
           accum_data_vf = _mm512_add_epi32(accum_data_vf, dst_zero_point);
         }
       }
+      if (transpose_for_multiplier) {
+        mm512_transpose16x16_epi32(
+            &accum_data_v0, &accum_data_v1, &accum_data_v2, &accum_data_v3,
+            &accum_data_v4, &accum_data_v5, &accum_data_v6, &accum_data_v7,
+            &accum_data_v8, &accum_data_v9, &accum_data_va, &accum_data_vb,
+            &accum_data_vc, &accum_data_vd, &accum_data_ve, &accum_data_vf);
+      }
 
       const __m512i clamp_max_v = _mm512_set1_epi32(params.clamp_max);
       const __m512i clamp_min_v = _mm512_set1_epi32(params.clamp_min);
@@ -1059,14 +1292,22 @@ void Kernel8bitAvx512SingleCol(const KernelParams8bit<16, 16>& params) {
   RUY_DCHECK_EQ(params.last_col, 0);
   RUY_DCHECK_EQ(params.start_col, 0);
 
-  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 16 : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias and per-channel
+  // multipliers are those of the single column, at index 0.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  const bool has_row_multipliers =
+      (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) && !channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? 16 : 0;
 
   const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
   void* dst_col_ptr = params.dst_base_ptr;
-  const std::int32_t* bias_col_ptr = params.bias;
-  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
-    bias_col_ptr += params.start_row;
-  }
+  const std::int32_t* bias_col_ptr =
+      has_row_bias ? params.bias + params.start_row : params.zero_data;
 
   const std::int8_t* lhs_col_ptr = params.lhs_base_ptr;
   void* dst_ptr = dst_col_ptr;
@@ -1092,7 +1333,9 @@ void Kernel8bitAvx512SingleCol(const KernelParams8bit<16, 16>& params) {
     // Initialize with bias.
     const __mmask16 row_mask =
         (static_cast<std::uint32_t>(1) << residual_rows) - 1;
-    __m512i initial_accum_data = _mm512_maskz_loadu_epi32(row_mask, bias_ptr);
+    __m512i initial_accum_data =
+        has_col_bias ? _mm512_set1_epi32(params.bias[0])
+                     : _mm512_maskz_loadu_epi32(row_mask, bias_ptr);
     bias_ptr += bias_ptr_block_increment;
 
     const std::int32_t rhs_zero_point = params.rhs_zero_point;
@@ -1110,6 +1353,22 @@ void Kernel8bitAvx512SingleCol(const KernelParams8bit<16, 16>& params) {
                                             _mm512_set1_epi32(prod_zp_depth));
     }
 
+    // Per-channel LHS zero points. The part of the correction that does not
+    // depend on the column is folded into initial_accum_data here, the rest
+    // is applied to each column below.
+    const bool has_lhs_zero_point_perchannel =
+        params.flags & RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL;
+    __m512i lhs_zero_point_perchannel_v = _mm512_setzero_si512();
+    if (has_lhs_zero_point_perchannel) {
+      lhs_zero_point_perchannel_v = _mm512_maskz_loadu_epi32(
+          row_mask, &params.lhs_zero_point_perchannel[row]);
+      const std::int32_t rhs_zp_depth = rhs_zero_point * params.depth;
+      initial_accum_data = _mm512_add_epi32(
+          initial_accum_data,
+          _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                             _mm512_set1_epi32(rhs_zp_depth)));
+    }
+
     // Adjustments differing across columns.
     if (has_rhs_sums_offsets) {
       accum_data_v0 = _mm512_sub_epi32(initial_accum_data,
@@ -1117,6 +1376,13 @@ void Kernel8bitAvx512SingleCol(const KernelParams8bit<16, 16>& params) {
     } else {
       accum_data_v0 = initial_accum_data;
     }
+    if (has_lhs_zero_point_perchannel) {
+      const std::int32_t* rhs_sums = params.rhs_sums;
+      accum_data_v0 = _mm512_sub_epi32(
+          accum_data_v0,
+          _mm512_mullo_epi32(lhs_zero_point_perchannel_v,
+                             _mm512_set1_epi32(rhs_sums[0])));
+    }
 
     const std::int8_t* lhs_ptr = lhs_col_ptr;
     const std::int8_t* rhs_ptr = rhs_col_ptr;
@@ -1159,17 +1425,32 @@ void Kernel8bitAvx512SingleCol(const KernelParams8bit<16, 16>& params) {
       rhs_ptr += 16 * 4;
     }
 
-    if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
+    if (params.dst_type_id != DstTypeId<std::int32_t>::kValue &&
+        (params.flags & RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT)) {
+      __m512 multiplier_v;
+      if (has_row_multipliers) {
+        multiplier_v = _mm512_maskz_loadu_ps(row_mask,
+                                             &params.multiplier_float[row]);
+      } else {
+        // This array has size LhsCols, and is pre-filled, or holds the
+        // per-column multiplier.
+        multiplier_v = _mm512_set1_ps(params.multiplier_float[0]);
+      }
+      const __m512i dst_zero_point = _mm512_set1_epi32(params.dst_zero_point);
+      accum_data_v0 = _mm512_add_epi32(
+          mm512_scale_epi32(accum_data_v0, multiplier_v), dst_zero_point);
+    } else if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
       __m512i m_vector;
       __m512i e_vector;
       // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
-      if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
+      if (has_row_multipliers) {
         m_vector = _mm512_maskz_loadu_epi32(row_mask,
                                             &params.multiplier_fixedpoint[row]);
         e_vector = _mm512_maskz_loadu_epi32(row_mask,
                                             &params.multiplier_exponent[row]);
       } else {
-        // These arrays have size LhsCols, and are pre-filled.
+        // These arrays have size LhsCols, and are pre-filled, or hold the
+        // per-column multiplier.
         m_vector = _mm512_set1_epi32(params.multiplier_fixedpoint[0]);
         e_vector = _mm512_set1_epi32(params.multiplier_exponent[0]);
       }
@@ -1275,7 +1556,15 @@ void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
   const std::int64_t dst_stride = params.dst_stride >> 2;
   const std::int64_t rhs_stride = params.rhs_stride >> 2;
 
-  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 1 : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias varies along columns
+  // instead of rows.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? 1 : 0;
   const int end_row = std::min(params.dst_rows, params.last_row + 16);
   const int end_col = std::min(params.dst_cols, params.last_col + 16);
 
@@ -1285,7 +1574,8 @@ void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
       params.dst_base_ptr - params.start_col * dst_stride - params.start_row;
   const float* adj_lhs_col_ptr =
       params.lhs_base_ptr - params.start_row * lhs_stride;
-  const float* bias_col_ptr = params.bias;
+  const float* bias_col_ptr =
+      channel_dimension_is_col ? params.zero_data : params.bias;
 
   const __m512 clamp_max_v = _mm512_set1_ps(params.clamp_max);
   const __m512 clamp_min_v = _mm512_set1_ps(params.clamp_min);
@@ -1316,6 +1606,17 @@ void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
         __m512 accum_data_v5 = initial_accum_data;
         __m512 accum_data_v6 = initial_accum_data;
         __m512 accum_data_v7 = initial_accum_data;
+        if (has_col_bias) {
+          const float* col_bias = params.bias + col + 8 * mmm;
+          accum_data_v0 = _mm512_set1_ps(col_bias[0]);
+          accum_data_v1 = _mm512_set1_ps(col_bias[1]);
+          accum_data_v2 = _mm512_set1_ps(col_bias[2]);
+          accum_data_v3 = _mm512_set1_ps(col_bias[3]);
+          accum_data_v4 = _mm512_set1_ps(col_bias[4]);
+          accum_data_v5 = _mm512_set1_ps(col_bias[5]);
+          accum_data_v6 = _mm512_set1_ps(col_bias[6]);
+          accum_data_v7 = _mm512_set1_ps(col_bias[7]);
+        }
 
         const float* lhs_ptr = lhs_col_ptr;
         const float* rhs_ptr = rhs_col_ptr + 8 * mmm;
@@ -1425,6 +1726,17 @@ void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
         __m512 accum_data_v5 = initial_accum_data;
         __m512 accum_data_v6 = initial_accum_data;
         __m512 accum_data_v7 = initial_accum_data;
+        if (has_col_bias) {
+          const float* col_bias = params.bias + col + 8 * mmm;
+          accum_data_v0 = _mm512_set1_ps(col_bias[0]);
+          accum_data_v1 = _mm512_set1_ps(col_bias[1]);
+          accum_data_v2 = _mm512_set1_ps(col_bias[2]);
+          accum_data_v3 = _mm512_set1_ps(col_bias[3]);
+          accum_data_v4 = _mm512_set1_ps(col_bias[4]);
+          accum_data_v5 = _mm512_set1_ps(col_bias[5]);
+          accum_data_v6 = _mm512_set1_ps(col_bias[6]);
+          accum_data_v7 = _mm512_set1_ps(col_bias[7]);
+        }
 
         const float* lhs_ptr = lhs_col_ptr;
         const float* rhs_ptr = rhs_col_ptr + 8 * mmm;
@@ -1545,6 +1857,17 @@ void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
         __m512 accum_data_v5 = initial_accum_data;
         __m512 accum_data_v6 = initial_accum_data;
         __m512 accum_data_v7 = initial_accum_data;
+        if (has_col_bias) {
+          const float* col_bias = params.bias + col + 8 * mmm;
+          accum_data_v0 = _mm512_set1_ps(col_bias[0]);
+          accum_data_v1 = _mm512_set1_ps(col_bias[1]);
+          accum_data_v2 = _mm512_set1_ps(col_bias[2]);
+          accum_data_v3 = _mm512_set1_ps(col_bias[3]);
+          accum_data_v4 = _mm512_set1_ps(col_bias[4]);
+          accum_data_v5 = _mm512_set1_ps(col_bias[5]);
+          accum_data_v6 = _mm512_set1_ps(col_bias[6]);
+          accum_data_v7 = _mm512_set1_ps(col_bias[7]);
+        }
 
         const float* lhs_ptr = lhs_col_ptr;
         const float* rhs_ptr = rhs_col_ptr + 8 * mmm;
@@ -1676,6 +1999,11 @@ void KernelFloatAvx512(const KernelParamsFloat<16, 16>& params) {
         for (int j = 0; j < 8; ++j) {
           accum_data_v[j] = initial_accum_data;
         }
+        if (has_col_bias) {
+          for (int j = 0; j < std::min(end_col - col - 8 * mmm, 8); ++j) {
+            accum_data_v[j] = _mm512_set1_ps(params.bias[col + 8 * mmm + j]);
+          }
+        }
 
         const float* lhs_ptr = lhs_col_ptr;
         const float* rhs_ptr = rhs_col_ptr + 8 * mmm;
@@ -1733,13 +2061,22 @@ void KernelFloatAvx512SingleCol(const KernelParamsFloat<16, 16>& params) {
   // As parameters are defined, we need to scale by sizeof(float).
   const std::int64_t lhs_stride = params.lhs_stride >> 2;
 
-  int bias_ptr_block_increment = params.flags & RUY_ASM_FLAG_HAS_BIAS ? 1 : 0;
+  // With RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL, the bias is that of the single
+  // column, at index 0.
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? 1 : 0;
   const int end_row = std::min(params.dst_rows, params.last_row + 16);
 
   float* adj_dst_col_ptr = params.dst_base_ptr - params.start_row;
   const float* adj_lhs_col_ptr =
       params.lhs_base_ptr - params.start_row * lhs_stride;
-  const float* bias_col_ptr = params.bias;
+  const float* bias_col_ptr =
+      channel_dimension_is_col ? params.zero_data : params.bias;
 
   const __m512 clamp_max_v = _mm512_set1_ps(params.clamp_max);
   const __m512 clamp_min_v = _mm512_set1_ps(params.clamp_min);
@@ -1756,7 +2093,8 @@ void KernelFloatAvx512SingleCol(const KernelParamsFloat<16, 16>& params) {
     const float* bias_ptr = bias_col_ptr + row * bias_ptr_block_increment;
 
     // Initialize with bias.
-    accum_data_v = _mm512_loadu_ps(bias_ptr);
+    accum_data_v = has_col_bias ? _mm512_set1_ps(params.bias[0])
+                                : _mm512_loadu_ps(bias_ptr);
 
     const float* lhs_ptr = lhs_col_ptr;
     const float* rhs_ptr = rhs_col_ptr;
@@ -1787,7 +2125,8 @@ void KernelFloatAvx512SingleCol(const KernelParamsFloat<16, 16>& params) {
     // Initialize with bias.
     const __mmask16 row_mask =
         (static_cast<std::uint32_t>(1) << residual_rows) - 1;
-    accum_data_v = _mm512_maskz_loadu_ps(row_mask, bias_ptr);
+    accum_data_v = has_col_bias ? _mm512_set1_ps(params.bias[0])
+                                : _mm512_maskz_loadu_ps(row_mask, bias_ptr);
 
     const float* lhs_ptr = lhs_col_ptr;
     const float* rhs_ptr = rhs_col_ptr;
@@ -1807,6 +2146,55 @@ void KernelFloatAvx512SingleCol(const KernelParamsFloat<16, 16>& params) {
   }  // End handling of residual rows.
 }
 
+namespace {
+
+// Converts 16 floats to binary16, rounding to nearest even.
+inline __m256i mm512_cvtps_half(const __m512 v) {
+  return _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+// Converts 16 floats to bfloat16, rounding to nearest even. Same as
+// detail::FloatToFloat16Bits<8>: adding 0x7fff plus the lowest kept bit
+// rounds to nearest even, and NaNs just get their quiet bit set.
+inline __m256i mm512_cvtps_bfloat16(const __m512 v) {
+  const __m512i bits = _mm512_castps_si512(v);
+  const __m512i lowest_kept_bit =
+      _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+  const __m512i rounded = _mm512_add_epi32(
+      bits, _mm512_add_epi32(lowest_kept_bit, _mm512_set1_epi32(0x7fff)));
+  const __mmask16 is_nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+  const __m512i result = _mm512_mask_or_epi32(rounded, is_nan, bits,
+                                              _mm512_set1_epi32(0x400000));
+  return _mm512_cvtepi32_epi16(_mm512_srli_epi32(result, 16));
+}
+
+template <typename DstScalar, typename ConvertFn>
+void StoreFloat16BlockAvx512Impl(const float* block, int rows, int cols,
+                                 DstScalar* dst, int dst_stride,
+                                 ConvertFn convert) {
+  RUY_DCHECK_LE(rows, 16);
+  RUY_DCHECK_LE(cols, 16);
+  const __mmask16 row_mask = (static_cast<std::uint32_t>(1) << rows) - 1;
+  for (int col = 0; col < cols; col++) {
+    const __m256i converted = convert(_mm512_loadu_ps(block + 16 * col));
+    _mm256_mask_storeu_epi16(dst + col * dst_stride, row_mask, converted);
+  }
+}
+
+}  // namespace
+
+void StoreFloat16BlockAvx512(const float* block, int rows, int cols,
+                             Half* dst, int dst_stride) {
+  StoreFloat16BlockAvx512Impl(block, rows, cols, dst, dst_stride,
+                              mm512_cvtps_half);
+}
+
+void StoreFloat16BlockAvx512(const float* block, int rows, int cols,
+                             BFloat16* dst, int dst_stride) {
+  StoreFloat16BlockAvx512Impl(block, rows, cols, dst, dst_stride,
+                              mm512_cvtps_bfloat16);
+}
+
 #endif  //  RUY_PLATFORM_AVX512 && RUY_OPT(ASM)
 
 }  // namespace ruy
@@ -17,12 +17,16 @@ limitations under the License.
 #define RUY_RUY_KERNEL_COMMON_H_
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <limits>
 #include <type_traits>
 
 #include "ruy/apply_multiplier.h"
 #include "ruy/check_macros.h"
 #include "ruy/common.h"
+#include "ruy/float16.h"
+#include "ruy/float8.h"
 #include "ruy/mat.h"
 #include "ruy/matrix.h"
 #include "ruy/mul_params.h"
@@ -93,6 +97,449 @@ void RunKernel(Tuning tuning, const SidePair<PEMat>& src, void* mul_params,
       start[Side::kRhs], end[Side::kLhs], end[Side::kRhs], &mdst);
 }
 
+// Computes the destination block [start, end) of a TrMul whose packed RHS is
+// entirely equal to its zero_point on the columns of that block, see
+// MulParams::skip_zero_rhs_slices. All zero-point corrections then cancel out,
+// as in Path::kStandardCpp, leaving accumulators equal to the bias, to which
+// this applies the rest of the epilogue.
+template <typename DstScalar, typename MulParamsType>
+void RunZeroRhsKernel(void* mul_params, const SidePair<int>& start,
+                      const SidePair<int>& end, EMat* dst) {
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  const auto& params = *static_cast<const MulParamsType*>(mul_params);
+  Mat<DstScalar> mdst = UneraseType<DstScalar>(*dst);
+  const int end_row = std::min(end[Side::kLhs], mdst.layout.rows);
+  const int end_col = std::min(end[Side::kRhs], mdst.layout.cols);
+  const bool channel_is_col =
+      params.channel_dimension() == ChannelDimension::kCol;
+  for (int j = start[Side::kRhs]; j < end_col; j++) {
+    for (int i = start[Side::kLhs]; i < end_row; i++) {
+      if (std::is_integral<AccumScalar>::value &&
+          std::is_floating_point<DstScalar>::value) {
+        // Dynamic quantization, where there is no bias: the dequantized
+        // accumulators are 0.
+        float dst_val = std::min<float>(0, params.clamp_max());
+        dst_val = std::max<float>(dst_val, params.clamp_min());
+        *ElementPtr(&mdst, i, j) = static_cast<DstScalar>(dst_val);
+        continue;
+      }
+      const int channel = channel_is_col ? j : i;
+      AccumScalar accum = params.bias() ? params.bias()[channel] : 0;
+      ApplyMultiplier(params, channel, &accum);
+      accum += mdst.zero_point;
+      accum = std::min<AccumScalar>(accum, params.clamp_max());
+      accum = std::max<AccumScalar>(accum, params.clamp_min());
+      *ElementPtr(&mdst, i, j) = static_cast<DstScalar>(accum);
+    }
+  }
+}
+
+inline int PopCount64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Kernel for MulParams::bit_packing, on matrices packed by RunBitPack. For
+// binary values, a dot-product is the number of equal values minus the number
+// of different ones, i.e. depth - 2 * popcount(a ^ b). For ternary values, it
+// is the same restricted to the positions where both are nonzero. This is
+// portable C++, relying on the compiler to emit native population counts (such
+// as the popcnt or cnt instructions) where available.
+template <int kBitPlanes, typename DstScalar, typename MulParamsType>
+void RunBitPackedKernel(Tuning, const SidePair<PEMat>& src, void* mul_params,
+                        const SidePair<int>& start, const SidePair<int>& end,
+                        EMat* dst) {
+  profiler::ScopeLabel label("Kernel (bit-packed)");
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  const auto& params = *static_cast<const MulParamsType*>(mul_params);
+  const PEMat& lhs = src[Side::kLhs];
+  const PEMat& rhs = src[Side::kRhs];
+  const int num_words = lhs.layout.rows / kBitPlanes;
+  Mat<DstScalar> mdst = UneraseType<DstScalar>(*dst);
+  const int end_row = std::min(end[Side::kLhs], mdst.layout.rows);
+  const int end_col = std::min(end[Side::kRhs], mdst.layout.cols);
+  const bool channel_is_col =
+      params.channel_dimension() == ChannelDimension::kCol;
+  for (int j = start[Side::kRhs]; j < end_col; j++) {
+    const std::uint64_t* rhs_words =
+        static_cast<const std::uint64_t*>(rhs.data) + j * rhs.layout.stride;
+    for (int i = start[Side::kLhs]; i < end_row; i++) {
+      const std::uint64_t* lhs_words =
+          static_cast<const std::uint64_t*>(lhs.data) + i * lhs.layout.stride;
+      AccumScalar accum = 0;
+      if (kBitPlanes == 1) {
+        int num_different = 0;
+        for (int w = 0; w < num_words; w++) {
+          num_different += PopCount64(lhs_words[w] ^ rhs_words[w]);
+        }
+        accum = static_cast<const std::int32_t*>(lhs.sums)[i] -
+                2 * num_different;
+      } else {
+        for (int w = 0; w < num_words; w++) {
+          const std::uint64_t nonzero = lhs_words[w] & rhs_words[w];
+          const std::uint64_t negative =
+              nonzero & (lhs_words[num_words + w] ^ rhs_words[num_words + w]);
+          accum += PopCount64(nonzero) - 2 * PopCount64(negative);
+        }
+      }
+      const int channel = channel_is_col ? j : i;
+      if (params.bias()) {
+        accum += params.bias()[channel];
+      }
+      ApplyMultiplier(params, channel, &accum);
+      accum += mdst.zero_point;
+      accum = std::min<AccumScalar>(accum, params.clamp_max());
+      accum = std::max<AccumScalar>(accum, params.clamp_min());
+      *ElementPtr(&mdst, i, j) = static_cast<DstScalar>(accum);
+    }
+  }
+}
+
+template <typename Scalar>
+Scalar ApplyGateActivation(GateActivation activation, Scalar x) {
+  switch (activation) {
+    case GateActivation::kSigmoid:
+      return 1 / (1 + std::exp(-x));
+    case GateActivation::kSilu:
+      return x / (1 + std::exp(-x));
+    case GateActivation::kGelu: {
+      const Scalar kSqrtHalf = static_cast<Scalar>(0.70710678118654752440);
+      return x * (1 + std::erf(x * kSqrtHalf)) / 2;
+    }
+    case GateActivation::kRelu:
+      return std::max<Scalar>(x, 0);
+    default:
+      RUY_DCHECK(false);
+      return 0;
+  }
+}
+
+// Returns the view of the packed matrix `src` that starts at column `col`,
+// which must be a multiple of the kernel width.
+template <typename Scalar>
+PMat<Scalar> PackedColumnsFrom(const PMat<Scalar>& src, int col) {
+  RUY_DCHECK_EQ(col % src.layout.kernel.cols, 0);
+  PMat<Scalar> result = src;
+  result.data += Offset(src.layout, 0, col);
+  if (result.sums) {
+    result.sums += col;
+  }
+  if (result.scales) {
+    result.scales += col;
+  }
+  result.layout.cols -= col;
+  return result;
+}
+
+// Entry point for the kernel of GatedMul, for floating-point types. The block
+// is split into chunks of at most kChunkRows x kChunkCols destination values.
+// For each chunk, the kernel of ThePath computes the gate product and the LHS
+// product into local buffers, with default MulParams so that nothing is
+// clamped, then the gated product is written to the destination. Both products
+// thus share the packed RHS, and are never materialized beyond a chunk.
+template <Path ThePath, typename LhsScalar, typename RhsScalar,
+          typename DstScalar, typename MulParamsType>
+void RunGatedKernel(Tuning tuning, const SidePair<PEMat>& src,
+                    const PEMat& gate, void* mul_params_ptr,
+                    const SidePair<int>& start, const SidePair<int>& end,
+                    EMat* dst) {
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  static_assert(std::is_floating_point<AccumScalar>::value, "");
+  using ProductMulParams = MulParams<AccumScalar, AccumScalar>;
+  using ProductKernel =
+      Kernel<ThePath, LhsScalar, RhsScalar, AccumScalar, ProductMulParams>;
+  static constexpr int kLhsKernelWidth = ProductKernel::LhsLayout::kCols;
+  static constexpr int kRhsKernelWidth = ProductKernel::RhsLayout::kCols;
+  static constexpr int kChunkRows = 64;
+  static constexpr int kChunkCols = 16;
+  static_assert(kChunkRows % kLhsKernelWidth == 0, "");
+  static_assert(kChunkCols % kRhsKernelWidth == 0, "");
+  profiler::ScopeLabel label("Kernel (gated)");
+  const auto& mul_params = *static_cast<const MulParamsType*>(mul_params_ptr);
+  const ProductMulParams product_mul_params;
+  const PMat<LhsScalar> lhs = UneraseType<LhsScalar>(src[Side::kLhs]);
+  const PMat<LhsScalar> packed_gate = UneraseType<LhsScalar>(gate);
+  const PMat<RhsScalar> rhs = UneraseType<RhsScalar>(src[Side::kRhs]);
+  Mat<DstScalar> mdst = UneraseType<DstScalar>(*dst);
+  // See the comment in RunKernelTyped: end may be larger than dst dimensions.
+  const int clamped_end_row = std::min(end[Side::kLhs], mdst.layout.rows);
+  const int clamped_end_col = std::min(end[Side::kRhs], mdst.layout.cols);
+  AccumScalar gate_buf[kChunkRows * kChunkCols];
+  AccumScalar lhs_buf[kChunkRows * kChunkCols];
+  Mat<AccumScalar> gate_chunk;
+  Mat<AccumScalar> lhs_chunk;
+  gate_chunk.data.set(gate_buf);
+  lhs_chunk.data.set(lhs_buf);
+  for (int col = start[Side::kRhs]; col < clamped_end_col; col += kChunkCols) {
+    const int chunk_cols = std::min(kChunkCols, clamped_end_col - col);
+    const PMat<RhsScalar> rhs_chunk = PackedColumnsFrom(rhs, col);
+    for (int row = start[Side::kLhs]; row < clamped_end_row;
+         row += kChunkRows) {
+      const int chunk_rows = std::min(kChunkRows, clamped_end_row - row);
+      for (Mat<AccumScalar>* chunk : {&gate_chunk, &lhs_chunk}) {
+        chunk->layout.rows = chunk_rows;
+        chunk->layout.cols = chunk_cols;
+        chunk->layout.stride = kChunkRows;
+      }
+      const int kernel_end_row = round_up_pot(chunk_rows, kLhsKernelWidth);
+      const int kernel_end_col = round_up_pot(chunk_cols, kRhsKernelWidth);
+      RunKernelTyped<ThePath, LhsScalar, RhsScalar, AccumScalar,
+                     ProductMulParams>(
+          tuning, PackedColumnsFrom(packed_gate, row), rhs_chunk,
+          product_mul_params, 0, 0, kernel_end_row, kernel_end_col,
+          &gate_chunk);
+      RunKernelTyped<ThePath, LhsScalar, RhsScalar, AccumScalar,
+                     ProductMulParams>(
+          tuning, PackedColumnsFrom(lhs, row), rhs_chunk, product_mul_params,
+          0, 0, kernel_end_row, kernel_end_col, &lhs_chunk);
+      for (int j = 0; j < chunk_cols; j++) {
+        for (int i = 0; i < chunk_rows; i++) {
+          AccumScalar accum =
+              lhs_buf[i + j * kChunkRows] *
+              ApplyGateActivation(mul_params.gate_activation(),
+                                  gate_buf[i + j * kChunkRows]);
+          accum = std::min<AccumScalar>(accum, mul_params.clamp_max());
+          accum = std::max<AccumScalar>(accum, mul_params.clamp_min());
+          *ElementPtr(&mdst, row + i, col + j) = static_cast<DstScalar>(accum);
+        }
+      }
+    }
+  }
+}
+
+// Entry point for the kernels of the optimized paths with dynamic
+// quantization. Like RunGatedKernel, this goes through the block by chunks.
+// For each chunk, the 8-bit kernel of ThePath computes the raw int32
+// accumulators, zero points included, into a local buffer, which is then
+// dequantized to the destination as in the Path::kStandardCpp kernel.
+template <Path ThePath, typename DstScalar, typename MulParamsType>
+void RunDynamicQuantizationKernel(Tuning tuning, const SidePair<PEMat>& src,
+                                  void* mul_params_ptr,
+                                  const SidePair<int>& start,
+                                  const SidePair<int>& end, EMat* dst) {
+  static_assert(std::is_same<typename MulParamsType::AccumScalar,
+                             std::int32_t>::value,
+                "");
+  using AccumMulParams = MulParams<std::int32_t, std::int32_t>;
+  using AccumKernel = Kernel<ThePath, std::int8_t, std::int8_t, std::int32_t,
+                             AccumMulParams>;
+  static constexpr int kLhsKernelWidth = AccumKernel::LhsLayout::kCols;
+  static constexpr int kRhsKernelWidth = AccumKernel::RhsLayout::kCols;
+  static constexpr int kChunkRows = 64;
+  static constexpr int kChunkCols = 16;
+  static_assert(kChunkRows % kLhsKernelWidth == 0, "");
+  static_assert(kChunkCols % kRhsKernelWidth == 0, "");
+  profiler::ScopeLabel label("Kernel (dynamic quantization)");
+  const auto& mul_params = *static_cast<const MulParamsType*>(mul_params_ptr);
+  RUY_DCHECK(!mul_params.lhs_group_scales());
+  const PMat<std::int8_t> lhs = UneraseType<std::int8_t>(src[Side::kLhs]);
+  const PMat<std::int8_t> rhs = UneraseType<std::int8_t>(src[Side::kRhs]);
+  RUY_DCHECK(rhs.scales);
+  Mat<DstScalar> mdst = UneraseType<DstScalar>(*dst);
+  // See the comment in RunKernelTyped: end may be larger than dst dimensions.
+  const int clamped_end_row = std::min(end[Side::kLhs], mdst.layout.rows);
+  const int clamped_end_col = std::min(end[Side::kRhs], mdst.layout.cols);
+  std::int32_t accum_buf[kChunkRows * kChunkCols];
+  Mat<std::int32_t> accum_chunk;
+  accum_chunk.data.set(accum_buf);
+  accum_chunk.layout.stride = kChunkRows;
+  for (int col = start[Side::kRhs]; col < clamped_end_col; col += kChunkCols) {
+    const int chunk_cols = std::min(kChunkCols, clamped_end_col - col);
+    const PMat<std::int8_t> rhs_chunk = PackedColumnsFrom(rhs, col);
+    for (int row = start[Side::kLhs]; row < clamped_end_row;
+         row += kChunkRows) {
+      const int chunk_rows = std::min(kChunkRows, clamped_end_row - row);
+      accum_chunk.layout.rows = chunk_rows;
+      accum_chunk.layout.cols = chunk_cols;
+      // The kernel indexes the per-channel LHS zero points from the start of
+      // the chunk.
+      AccumMulParams accum_mul_params;
+      if (mul_params.lhs_zero_point_perchannel()) {
+        accum_mul_params.set_lhs_zero_point_perchannel(
+            mul_params.lhs_zero_point_perchannel() + row);
+      }
+      RunKernelTyped<ThePath, std::int8_t, std::int8_t, std::int32_t,
+                     AccumMulParams>(
+          tuning, PackedColumnsFrom(lhs, row), rhs_chunk, accum_mul_params, 0,
+          0, round_up_pot(chunk_rows, kLhsKernelWidth),
+          round_up_pot(chunk_cols, kRhsKernelWidth), &accum_chunk);
+      for (int j = 0; j < chunk_cols; j++) {
+        for (int i = 0; i < chunk_rows; i++) {
+          const float lhs_scale =
+              mul_params.multiplier_float_perchannel()
+                  ? mul_params.multiplier_float_perchannel()[row + i]
+                  : mul_params.multiplier_float();
+          float dst_val = static_cast<float>(accum_buf[i + j * kChunkRows]) *
+                          lhs_scale * rhs_chunk.scales[j];
+          dst_val = std::min<float>(dst_val, mul_params.clamp_max());
+          dst_val = std::max<float>(dst_val, mul_params.clamp_min());
+          *ElementPtr(&mdst, row + i, col + j) =
+              static_cast<DstScalar>(dst_val);
+        }
+      }
+    }
+  }
+}
+
+// Reductions of the destination values (see DstReductions) are computed on
+// each block right after the kernel has written it, while it is still in
+// cache, so this works the same regardless of the Path. Each thread
+// accumulates into its own buffer of partial reductions, laid out as
+// kNumDstReductions arrays of `rows` values, followed by kNumDstReductions
+// arrays of `cols` values, in the order of the DstReductions fields.
+// TrMul then merges these buffers into the user's buffers.
+constexpr int kDstReductionSum = 0;
+constexpr int kDstReductionSumOfSquares = 1;
+constexpr int kDstReductionMaximum = 2;
+constexpr int kDstReductionMinimum = 3;
+constexpr int kNumDstReductions = 4;
+
+template <typename AccumScalar>
+AccumScalar DstReductionIdentity(int reduction) {
+  using Limits = std::numeric_limits<AccumScalar>;
+  switch (reduction) {
+    case kDstReductionMaximum:
+      return Limits::has_infinity ? -Limits::infinity() : Limits::lowest();
+    case kDstReductionMinimum:
+      return Limits::has_infinity ? Limits::infinity() : Limits::max();
+    default:
+      return 0;
+  }
+}
+
+template <typename AccumScalar>
+void CombineDstReduction(int reduction, AccumScalar value, AccumScalar* dst) {
+  switch (reduction) {
+    case kDstReductionMaximum:
+      *dst = std::max(*dst, value);
+      break;
+    case kDstReductionMinimum:
+      *dst = std::min(*dst, value);
+      break;
+    default:
+      *dst += value;
+  }
+}
+
+// Returns the user buffers of the given DstReductions, in the order of the
+// partial reductions.
+template <typename AccumScalar>
+void GetDstReductionBuffers(const DstReductions<AccumScalar>& reductions,
+                            AccumScalar* buffers[kNumDstReductions]) {
+  buffers[kDstReductionSum] = reductions.sum;
+  buffers[kDstReductionSumOfSquares] = reductions.sum_of_squares;
+  buffers[kDstReductionMaximum] = reductions.maximum;
+  buffers[kDstReductionMinimum] = reductions.minimum;
+}
+
+template <typename MulParamsType>
+bool HasDstReductions(const MulParamsType& mul_params) {
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  AccumScalar* row_buffers[kNumDstReductions];
+  AccumScalar* col_buffers[kNumDstReductions];
+  GetDstReductionBuffers(mul_params.row_reductions(), row_buffers);
+  GetDstReductionBuffers(mul_params.col_reductions(), col_buffers);
+  for (int r = 0; r < kNumDstReductions; r++) {
+    if (row_buffers[r] || col_buffers[r]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename AccumScalar>
+int DstReductionPartialsBytes(int rows, int cols) {
+  return kNumDstReductions * (rows + cols) * sizeof(AccumScalar);
+}
+
+template <typename AccumScalar>
+void InitDstReductionPartials(int rows, int cols, void* partials_ptr) {
+  AccumScalar* partials = static_cast<AccumScalar*>(partials_ptr);
+  for (int r = 0; r < kNumDstReductions; r++) {
+    std::fill(partials + r * rows, partials + (r + 1) * rows,
+              DstReductionIdentity<AccumScalar>(r));
+  }
+  partials += kNumDstReductions * rows;
+  for (int r = 0; r < kNumDstReductions; r++) {
+    std::fill(partials + r * cols, partials + (r + 1) * cols,
+              DstReductionIdentity<AccumScalar>(r));
+  }
+}
+
+template <typename DstScalar, typename MulParamsType>
+void ReduceDstBlock(const EMat& dst, void* mul_params_ptr,
+                    const SidePair<int>& start, const SidePair<int>& end,
+                    void* partials_ptr) {
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  profiler::ScopeLabel label("ReduceDstBlock");
+  const auto& mul_params = *static_cast<const MulParamsType*>(mul_params_ptr);
+  const Mat<DstScalar> mdst = UneraseType<DstScalar>(dst);
+  const int rows = mdst.layout.rows;
+  const int cols = mdst.layout.cols;
+  AccumScalar* row_buffers[kNumDstReductions];
+  AccumScalar* col_buffers[kNumDstReductions];
+  GetDstReductionBuffers(mul_params.row_reductions(), row_buffers);
+  GetDstReductionBuffers(mul_params.col_reductions(), col_buffers);
+  AccumScalar* row_partials = static_cast<AccumScalar*>(partials_ptr);
+  AccumScalar* col_partials = row_partials + kNumDstReductions * rows;
+  // See the comment in RunKernelTyped: end may be larger than dst dimensions.
+  const int clamped_end_row = std::min(end[Side::kLhs], rows);
+  const int clamped_end_col = std::min(end[Side::kRhs], cols);
+  for (int j = start[Side::kRhs]; j < clamped_end_col; j++) {
+    for (int i = start[Side::kLhs]; i < clamped_end_row; i++) {
+      const AccumScalar val = Element(mdst, i, j);
+      for (int r = 0; r < kNumDstReductions; r++) {
+        const AccumScalar reduced =
+            r == kDstReductionSumOfSquares ? val * val : val;
+        if (row_buffers[r]) {
+          CombineDstReduction(r, reduced, &row_partials[r * rows + i]);
+        }
+        if (col_buffers[r]) {
+          CombineDstReduction(r, reduced, &col_partials[r * cols + j]);
+        }
+      }
+    }
+  }
+}
+
+template <typename MulParamsType>
+void MergeDstReductionPartials(void* mul_params_ptr, int rows, int cols,
+                               int num_partials, const void* partials_ptr) {
+  using AccumScalar = typename MulParamsType::AccumScalar;
+  const auto& mul_params = *static_cast<const MulParamsType*>(mul_params_ptr);
+  AccumScalar* buffers[kNumDstReductions];
+  const AccumScalar* partials = static_cast<const AccumScalar*>(partials_ptr);
+  const int partials_size = kNumDstReductions * (rows + cols);
+  for (Side side : {Side::kLhs, Side::kRhs}) {
+    const bool is_row = side == Side::kLhs;
+    const int size = is_row ? rows : cols;
+    const int offset = is_row ? 0 : kNumDstReductions * rows;
+    GetDstReductionBuffers(is_row ? mul_params.row_reductions()
+                                  : mul_params.col_reductions(),
+                           buffers);
+    for (int r = 0; r < kNumDstReductions; r++) {
+      if (!buffers[r]) {
+        continue;
+      }
+      std::fill(buffers[r], buffers[r] + size,
+                DstReductionIdentity<AccumScalar>(r));
+      for (int p = 0; p < num_partials; p++) {
+        const AccumScalar* src =
+            partials + p * partials_size + offset + r * size;
+        for (int i = 0; i < size; i++) {
+          CombineDstReduction(r, src[i], &buffers[r][i]);
+        }
+      }
+    }
+  }
+}
+
 template <typename LhsScalar, typename RhsScalar, typename DstScalar,
           typename MulParamsType>
 struct Kernel<Path::kStandardCpp, LhsScalar, RhsScalar, DstScalar,
@@ -122,17 +569,52 @@ struct Kernel<Path::kStandardCpp, LhsScalar, RhsScalar, DstScalar,
     RUY_DCHECK_LE(end_col - clamped_end_col, RhsLayout::kCols);
     profiler::ScopeLabel label("Kernel (Standard Cpp)");
     const int depth = lhs.layout.rows;
+    const bool channel_is_col =
+        mul_params.channel_dimension() == ChannelDimension::kCol;
     for (int i = start_row; i < clamped_end_row; i++) {
       for (int j = start_col; j < clamped_end_col; j++) {
         using AccumScalar = typename MulParamsType::AccumScalar;
+        const int channel = channel_is_col ? j : i;
+        if (mul_params.lhs_group_scales()) {
+          *ElementPtr(dst, i, j) =
+              static_cast<DstScalar>(GroupWiseDot(lhs, rhs, mul_params, i, j,
+                                                  depth, dst->layout.rows));
+          continue;
+        }
         AccumScalar accum = 0;
+        // Slices of zeros only contribute to accum if the RHS zero_point
+        // isn't 0, see MulParams::skip_zero_rhs_slices.
+        const bool skip_zero_slices = rhs.zero_slices && !rhs.zero_point;
+        const int slice_depth = ZeroSliceDepth(rhs.layout);
         for (int k = 0; k < depth; k++) {
+          if (skip_zero_slices && k % slice_depth == 0 &&
+              IsZeroSlice(rhs, j, k)) {
+            k += slice_depth - 1;
+            continue;
+          }
           AccumScalar lhs_val = Element(lhs, k, i);
           AccumScalar rhs_val = Element(rhs, k, j);
           accum += lhs_val * rhs_val;
         }
+        if (IsFloat8<LhsScalar>::value) {
+          // 8-bit floating-point LHS: the LHS scale, if any, applies before
+          // the bias, see float8.h.
+          if (mul_params.multiplier_float_perchannel() ||
+              mul_params.multiplier_float() != 0) {
+            accum *= mul_params.multiplier_float_perchannel()
+                         ? mul_params.multiplier_float_perchannel()[i]
+                         : mul_params.multiplier_float();
+          }
+          if (mul_params.bias()) {
+            accum += mul_params.bias()[i];
+          }
+          accum = std::min<AccumScalar>(accum, mul_params.clamp_max());
+          accum = std::max<AccumScalar>(accum, mul_params.clamp_min());
+          *ElementPtr(dst, i, j) = static_cast<DstScalar>(accum);
+          continue;
+        }
         if (mul_params.bias()) {
-          accum += mul_params.bias()[i];
+          accum += mul_params.bias()[channel];
         }
         if (lhs.zero_point) {
           accum -= lhs.zero_point * rhs.sums[j];
@@ -143,7 +625,26 @@ struct Kernel<Path::kStandardCpp, LhsScalar, RhsScalar, DstScalar,
         if (lhs.zero_point && rhs.zero_point) {
           accum += lhs.zero_point * rhs.zero_point * depth;
         }
-        ApplyMultiplier(mul_params, i, &accum);
+        if (mul_params.lhs_zero_point_perchannel()) {
+          // Same as the above two corrections, for the per-channel part of
+          // the LHS zero_point.
+          accum -= mul_params.lhs_zero_point_perchannel()[i] *
+                   (rhs.sums[j] - rhs.zero_point * depth);
+        }
+        if (rhs.scales) {
+          // Dynamic quantization: dequantize to the floating-point
+          // destination. See the float-to-int8 PackImpl.
+          const float lhs_scale =
+              mul_params.multiplier_float_perchannel()
+                  ? mul_params.multiplier_float_perchannel()[i]
+                  : mul_params.multiplier_float();
+          float dst_val = static_cast<float>(accum) * lhs_scale * rhs.scales[j];
+          dst_val = std::min<float>(dst_val, mul_params.clamp_max());
+          dst_val = std::max<float>(dst_val, mul_params.clamp_min());
+          *ElementPtr(dst, i, j) = static_cast<DstScalar>(dst_val);
+          continue;
+        }
+        ApplyMultiplier(mul_params, channel, &accum);
         accum += dst->zero_point;
         accum = std::min<AccumScalar>(accum, mul_params.clamp_max());
         accum = std::max<AccumScalar>(accum, mul_params.clamp_min());
@@ -151,6 +652,44 @@ struct Kernel<Path::kStandardCpp, LhsScalar, RhsScalar, DstScalar,
       }
     }
   }
+
+ private:
+  // Computes one destination value, dequantized and clamped, in the case of
+  // dynamic quantization with group-wise LHS scales (see
+  // MulParams::lhs_group_scales). The zero points are subtracted before
+  // multiplying, as the zero point corrections based on sums only work on
+  // whole columns. This way, padding values contribute 0, so groups made only
+  // of padding, which are beyond the end of lhs_group_scales, are skipped.
+  static float GroupWiseDot(const PMat<LhsScalar>& lhs,
+                            const PMat<RhsScalar>& rhs,
+                            const MulParamsType& mul_params, int i, int j,
+                            int depth, int rows) {
+    RUY_DCHECK(rhs.scales);
+    const AccumScalar lhs_zero_point =
+        lhs.zero_point + (mul_params.lhs_zero_point_perchannel()
+                              ? mul_params.lhs_zero_point_perchannel()[i]
+                              : 0);
+    const int group_size = mul_params.lhs_group_size();
+    float result = 0;
+    for (int group_start = 0; group_start < depth; group_start += group_size) {
+      const int group_end = std::min(group_start + group_size, depth);
+      AccumScalar group_accum = 0;
+      for (int k = group_start; k < group_end; k++) {
+        AccumScalar lhs_val = Element(lhs, k, i) - lhs_zero_point;
+        AccumScalar rhs_val = Element(rhs, k, j) - rhs.zero_point;
+        group_accum += lhs_val * rhs_val;
+      }
+      if (group_accum) {
+        const int group = group_start / group_size;
+        result += static_cast<float>(group_accum) *
+                  mul_params.lhs_group_scales()[group * rows + i];
+      }
+    }
+    result *= rhs.scales[j];
+    result = std::min<float>(result, mul_params.clamp_max());
+    result = std::max<float>(result, mul_params.clamp_min());
+    return result;
+  }
 };
 
 #define RUY_INHERIT_KERNEL(PARENT, CHILD)                                 \
@@ -185,6 +724,9 @@ RUY_INHERIT_KERNEL(Path::kAvx512, Path::kAvxVnni)
 #define RUY_ASM_FLAG_HAS_RHS_SUMS 0x4
 #define RUY_ASM_FLAG_HAS_PERCHANNEL 0x8
 #define RUY_ASM_FLAG_NEEDS_LEFT_SHIFT 0x10
+#define RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL 0x20
+#define RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT 0x40
+#define RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL 0x80
 
 #define RUY_ASM_TYPE_ID_UINT8 1
 #define RUY_ASM_TYPE_ID_INT8 2
@@ -248,6 +790,16 @@ struct KernelParams8bit {
   std::uint8_t dst_tmp_buf[LhsCols * RhsCols * kMaxDstTypeSize];
   std::int32_t multiplier_fixedpoint_buf[LhsCols];
   std::int32_t multiplier_exponent_buf[LhsCols];
+  // Only used if RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL is set, in which
+  // case the zero_point of LHS row i is
+  // lhs_zero_point + lhs_zero_point_perchannel[i]. Placed last so as not to
+  // disturb the field offsets hardcoded in asm kernels.
+  const std::int32_t* lhs_zero_point_perchannel;
+  // Only used if RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT is set, in which case
+  // these replace multiplier_fixedpoint and multiplier_exponent, and are
+  // indexed like them depending on RUY_ASM_FLAG_HAS_PERCHANNEL.
+  const float* multiplier_float;
+  float multiplier_float_buf[LhsCols];
 };
 
 template <typename DstScalar, int LhsCols, int RhsCols>
@@ -275,6 +827,9 @@ void MakeKernelParams8bit(const PMat<std::int8_t>& lhs,
     params->bias = mul_params.bias();
     params->flags |= RUY_ASM_FLAG_HAS_BIAS;
   }
+  if (mul_params.channel_dimension() == ChannelDimension::kCol) {
+    params->flags |= RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  }
   if (lhs.sums) {
     params->lhs_sums = lhs.sums;
     params->flags |= RUY_ASM_FLAG_HAS_LHS_SUMS;
@@ -295,6 +850,11 @@ void MakeKernelParams8bit(const PMat<std::int8_t>& lhs,
   params->dst_zero_point = dst->zero_point;
   params->depth = depth;
   params->prod_zp_depth = lhs.zero_point * rhs.zero_point * depth;
+  params->lhs_zero_point_perchannel = params->zero_data;
+  if (mul_params.lhs_zero_point_perchannel()) {
+    params->lhs_zero_point_perchannel = mul_params.lhs_zero_point_perchannel();
+    params->flags |= RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL;
+  }
   if (mul_params.multiplier_fixedpoint_perchannel()) {
     params->flags |= RUY_ASM_FLAG_NEEDS_LEFT_SHIFT;
     params->flags |= RUY_ASM_FLAG_HAS_PERCHANNEL;
@@ -312,6 +872,17 @@ void MakeKernelParams8bit(const PMat<std::int8_t>& lhs,
       params->multiplier_exponent_buf[i] = mul_params.multiplier_exponent();
     }
   }
+  params->multiplier_float = params->multiplier_float_buf;
+  if (mul_params.multiplier_float_perchannel()) {
+    params->flags |= RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT;
+    params->flags |= RUY_ASM_FLAG_HAS_PERCHANNEL;
+    params->multiplier_float = mul_params.multiplier_float_perchannel();
+  } else if (mul_params.multiplier_float() != 0) {
+    params->flags |= RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT;
+    for (int i = 0; i < LhsCols; i++) {
+      params->multiplier_float_buf[i] = mul_params.multiplier_float();
+    }
+  }
   params->clamp_min = mul_params.clamp_min();
   params->clamp_max = mul_params.clamp_max();
   params->dst_rows = dst->layout.rows;
@@ -348,12 +919,17 @@ struct KernelParamsFloat {
   float dst_tmp_buf[LhsCols * RhsCols];
 };
 
-template <int LhsCols, int RhsCols>
+// Same as MakeKernelParamsFloat below, except that the kernel writes the
+// destination block starting at (start_row, start_col) to `dst_block`, with
+// the given stride, instead of writing directly to the destination matrix.
+// The destination type is only used for mul_params.
+template <int LhsCols, int RhsCols, typename DstScalar>
 inline void MakeKernelParamsFloat(const PMat<float>& lhs,
                                   const PMat<float>& rhs,
-                                  const MulParams<float, float>& mul_params,
+                                  const MulParams<float, DstScalar>& mul_params,
                                   int start_row, int start_col, int end_row,
-                                  int end_col, Mat<float>* dst,
+                                  int end_col, const MatLayout& dst_layout,
+                                  float* dst_block, int dst_block_stride,
                                   KernelParamsFloat<LhsCols, RhsCols>* params) {
   const int depth = lhs.layout.rows;
   RUY_DCHECK_EQ(start_row % LhsCols, 0);
@@ -363,8 +939,7 @@ inline void MakeKernelParamsFloat(const PMat<float>& lhs,
 
   params->lhs_base_ptr = lhs.data + start_row * lhs.layout.stride;
   params->rhs_base_ptr = rhs.data + start_col * rhs.layout.stride;
-  params->dst_base_ptr =
-      dst->data.get() + start_col * dst->layout.stride + start_row;
+  params->dst_base_ptr = dst_block;
 
   std::uint8_t flags = 0;
   params->bias = params->zero_data;
@@ -372,6 +947,9 @@ inline void MakeKernelParamsFloat(const PMat<float>& lhs,
     params->bias = mul_params.bias();
     flags |= RUY_ASM_FLAG_HAS_BIAS;
   }
+  if (mul_params.channel_dimension() == ChannelDimension::kCol) {
+    flags |= RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  }
   params->flags = flags;
   params->start_row = start_row;
   params->start_col = start_col;
@@ -379,17 +957,60 @@ inline void MakeKernelParamsFloat(const PMat<float>& lhs,
   params->last_col = end_col - RhsCols;
   params->lhs_stride = sizeof(float) * lhs.layout.stride;
   params->rhs_stride = sizeof(float) * rhs.layout.stride;
-  params->dst_stride = sizeof(float) * dst->layout.stride;
+  params->dst_stride = sizeof(float) * dst_block_stride;
   params->depth = depth;
   params->clamp_min = mul_params.clamp_min();
   params->clamp_max = mul_params.clamp_max();
-  params->dst_rows = dst->layout.rows;
-  params->dst_cols = dst->layout.cols;
+  params->dst_rows = dst_layout.rows;
+  params->dst_cols = dst_layout.cols;
 
   RUY_DCHECK_LT(params->last_row, params->dst_rows);
   RUY_DCHECK_LT(params->last_col, params->dst_cols);
 }
 
+template <int LhsCols, int RhsCols>
+inline void MakeKernelParamsFloat(const PMat<float>& lhs,
+                                  const PMat<float>& rhs,
+                                  const MulParams<float, float>& mul_params,
+                                  int start_row, int start_col, int end_row,
+                                  int end_col, Mat<float>* dst,
+                                  KernelParamsFloat<LhsCols, RhsCols>* params) {
+  MakeKernelParamsFloat(lhs, rhs, mul_params, start_row, start_col, end_row,
+                        end_col, dst->layout,
+                        dst->data.get() + start_col * dst->layout.stride +
+                            start_row,
+                        dst->layout.stride, params);
+}
+
+// Runs a float kernel for a destination of a 16-bit floating-point type (see
+// float16.h). Each LhsCols x RhsCols block is computed by float_kernel into a
+// float buffer on the stack, then converted into the destination by
+// store_block(block, rows, cols, dst_ptr, dst_stride), rounding to nearest
+// even. This way, float values don't go further than the L1 cache, and the
+// destination matrix only sees 16-bit values.
+template <int LhsCols, int RhsCols, typename DstScalar>
+void RunFloatKernelWithFloat16Dst(
+    const PMat<float>& lhs, const PMat<float>& rhs,
+    const MulParams<float, DstScalar>& mul_params, int start_row,
+    int start_col, int end_row, int end_col, Mat<DstScalar>* dst,
+    void (*float_kernel)(const KernelParamsFloat<LhsCols, RhsCols>&),
+    void (*store_block)(const float*, int, int, DstScalar*, int)) {
+  static_assert(IsFloat16<DstScalar>::value, "");
+  KernelParamsFloat<LhsCols, RhsCols> params;
+  float block[LhsCols * RhsCols];
+  for (int col = start_col; col < end_col; col += RhsCols) {
+    for (int row = start_row; row < end_row; row += LhsCols) {
+      MakeKernelParamsFloat(lhs, rhs, mul_params, row, col, row + LhsCols,
+                            col + RhsCols, dst->layout, block, LhsCols,
+                            &params);
+      float_kernel(params);
+      store_block(block, std::min(LhsCols, dst->layout.rows - row),
+                  std::min(RhsCols, dst->layout.cols - col),
+                  ElementPtr(dst, row, col), dst->layout.stride);
+    }
+  }
+}
+
 #else  // ((RUY_PLATFORM_NEON_64 || RUY_PLATFORM_NEON_32) &&
        // RUY_OPT(ASM)) || RUY_PLATFORM_X86
 
@@ -55,15 +55,18 @@ void Kernel8bitSse42(const KernelParams8bit<8, 8>& params) {
   profiler::ScopeLabel label("Kernel kSse42 8-bit (UNFINISHED)");
   std::int32_t accum_data[kAvx8bitBlockSize][kAvx8bitBlockSize];
 
-  int bias_ptr_block_increment =
-      params.flags & RUY_ASM_FLAG_HAS_BIAS ? kAvx8bitBlockSize : 0;
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? kAvx8bitBlockSize : 0;
 
   const std::int8_t* rhs_col_ptr = params.rhs_base_ptr;
   void* dst_col_ptr = params.dst_base_ptr;
-  const std::int32_t* bias_col_ptr = params.bias;
-  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
-    bias_col_ptr += params.start_row;
-  }
+  const std::int32_t* bias_col_ptr =
+      has_row_bias ? params.bias + params.start_row : params.zero_data;
 
   for (int col = params.start_col; col <= params.last_col;
        col += kAvx8bitBlockSize) {
@@ -91,6 +94,13 @@ void Kernel8bitSse42(const KernelParams8bit<8, 8>& params) {
           accum_data[j][i] = initial_accum_data[i];
         }
       }
+      if (has_col_bias) {
+        for (int j = 0; j < residual_cols; ++j) {
+          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
+            accum_data[j][i] += params.bias[col + j];
+          }
+        }
+      }
       bias_ptr += bias_ptr_block_increment;
 
       std::int8_t lhs_data[kAvx8bitBlockSize][kAvx8bitInnerSize];
@@ -138,32 +148,36 @@ void Kernel8bitSse42(const KernelParams8bit<8, 8>& params) {
           }
         }
       }
-
-      if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
-        std::int32_t m_vector[kAvx8bitBlockSize];
-        std::int32_t e_vector[kAvx8bitBlockSize];
-        // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
-        if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
-          int i = 0;
-          for (; i < residual_rows; ++i) {
-            m_vector[i] = params.multiplier_fixedpoint[row + i];
-            e_vector[i] = params.multiplier_exponent[row + i];
-          }
-          for (; i < kAvx8bitBlockSize; ++i) {
-            m_vector[i] = m_vector[0];
-            e_vector[i] = e_vector[0];
-          }
-        } else {
-          // These arrays have size LhsCols, and are pre-filled.
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            m_vector[i] = params.multiplier_fixedpoint[i];
-            e_vector[i] = params.multiplier_exponent[i];
+      if (params.flags & RUY_ASM_FLAG_HAS_LHS_ZERO_POINT_PERCHANNEL) {
+        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
+          for (int i = 0; i < residual_rows; ++i) {
+            accum_data[j][i] -=
+                params.lhs_zero_point_perchannel[row + i] *
+                (params.rhs_sums[col + j] -
+                 params.rhs_zero_point * params.depth);
           }
         }
-        for (int j = 0; j < kAvx8bitBlockSize; ++j) {
-          for (int i = 0; i < kAvx8bitBlockSize; ++i) {
-            accum_data[j][i] = MultiplyByQuantizedMultiplier(
-                accum_data[j][i], m_vector[i], e_vector[i]);
+      }
+
+      if (params.dst_type_id != DstTypeId<std::int32_t>::kValue) {
+        // Per-channel multipliers are indexed by destination row, or by
+        // destination column with RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL.
+        // Otherwise the arrays have size LhsCols, and are pre-filled.
+        for (int j = 0; j < residual_cols; ++j) {
+          for (int i = 0; i < residual_rows; ++i) {
+            int channel = i;
+            if (params.flags & RUY_ASM_FLAG_HAS_PERCHANNEL) {
+              channel = channel_dimension_is_col ? col + j : row + i;
+            }
+            if (params.flags & RUY_ASM_FLAG_HAS_MULTIPLIER_FLOAT) {
+              accum_data[j][i] = detail::MultiplyByFloatMultiplier(
+                  accum_data[j][i], params.multiplier_float[channel]);
+            } else {
+              // Does not make use of RUY_ASM_FLAG_NEEDS_LEFT_SHIFT.
+              accum_data[j][i] = MultiplyByQuantizedMultiplier(
+                  accum_data[j][i], params.multiplier_fixedpoint[channel],
+                  params.multiplier_exponent[channel]);
+            }
           }
         }
 
@@ -325,15 +339,18 @@ void KernelFloatSse42(const KernelParamsFloat<8, 8>& params) {
   float lhs_data[kAvxFloatBlockSize];
   float rhs_data[kAvxFloatBlockSize];
   float accum_data[kAvxFloatBlockSize][kAvxFloatBlockSize];
-  int bias_ptr_block_increment =
-      params.flags & RUY_ASM_FLAG_HAS_BIAS ? kAvxFloatBlockSize : 0;
+  const bool channel_dimension_is_col =
+      params.flags & RUY_ASM_FLAG_CHANNEL_DIMENSION_IS_COL;
+  const bool has_row_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && !channel_dimension_is_col;
+  const bool has_col_bias =
+      (params.flags & RUY_ASM_FLAG_HAS_BIAS) && channel_dimension_is_col;
+  int bias_ptr_block_increment = has_row_bias ? kAvxFloatBlockSize : 0;
 
   const float* rhs_col_ptr = params.rhs_base_ptr;
   float* dst_col_ptr = params.dst_base_ptr;
-  const float* bias_col_ptr = params.bias;
-  if (params.flags & RUY_ASM_FLAG_HAS_BIAS) {
-    bias_col_ptr += params.start_row;
-  }
+  const float* bias_col_ptr =
+      has_row_bias ? params.bias + params.start_row : params.zero_data;
 
   for (int col = params.start_col; col <= params.last_col;
        col += kAvxFloatBlockSize) {
@@ -361,6 +378,13 @@ void KernelFloatSse42(const KernelParamsFloat<8, 8>& params) {
           accum_data[j][i] = initial_accum_data[i];
         }
       }
+      if (has_col_bias) {
+        for (int j = 0; j < residual_cols; ++j) {
+          for (int i = 0; i < kAvxFloatBlockSize; ++i) {
+            accum_data[j][i] += params.bias[col + j];
+          }
+        }
+      }
       bias_ptr += bias_ptr_block_increment;
 
       const float* lhs_ptr = lhs_col_ptr;
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "ruy/common.h"
+#include "ruy/float16.h"
 #include "ruy/kernel_common.h"
 #include "ruy/mat.h"
 #include "ruy/matrix.h"
@@ -119,6 +120,33 @@ struct Kernel<Path::kAvx512, float, float, float, MulParams<float, float>> {
   }
 };
 
+void StoreFloat16BlockAvx512(const float* block, int rows, int cols,
+                             Half* dst, int dst_stride);
+void StoreFloat16BlockAvx512(const float* block, int rows, int cols,
+                             BFloat16* dst, int dst_stride);
+
+// The float kernel, for 16-bit floating-point destinations. See
+// RunFloatKernelWithFloat16Dst.
+template <int kExponentBits>
+struct Kernel<Path::kAvx512, float, float, Float16<kExponentBits>,
+              MulParams<float, Float16<kExponentBits>>> {
+  using DstScalar = Float16<kExponentBits>;
+  Tuning tuning = Tuning::kAuto;
+  using LhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 16>;
+  using RhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 16>;
+  explicit Kernel(Tuning tuning_) : tuning(tuning_) {}
+  void Run(const PMat<float>& lhs, const PMat<float>& rhs,
+           const MulParams<float, DstScalar>& mul_params, int start_row,
+           int start_col, int end_row, int end_col,
+           Mat<DstScalar>* dst) const {
+    RunFloatKernelWithFloat16Dst(
+        lhs, rhs, mul_params, start_row, start_col, end_row, end_col, dst,
+        dst->layout.cols == 1 ? &KernelFloatAvx512SingleCol
+                              : &KernelFloatAvx512,
+        &StoreFloat16BlockAvx512);
+  }
+};
+
 void Kernel8bitAvx2(const KernelParams8bit<8, 8>& params);
 void Kernel8bitAvx2SingleCol(const KernelParams8bit<8, 8>& params);
 
@@ -166,6 +194,32 @@ struct Kernel<Path::kAvx2, float, float, float, MulParams<float, float>> {
   }
 };
 
+void StoreFloat16BlockAvx2(const float* block, int rows, int cols, Half* dst,
+                           int dst_stride);
+void StoreFloat16BlockAvx2(const float* block, int rows, int cols,
+                           BFloat16* dst, int dst_stride);
+
+// The float kernel, for 16-bit floating-point destinations. See
+// RunFloatKernelWithFloat16Dst.
+template <int kExponentBits>
+struct Kernel<Path::kAvx2, float, float, Float16<kExponentBits>,
+              MulParams<float, Float16<kExponentBits>>> {
+  using DstScalar = Float16<kExponentBits>;
+  Tuning tuning = Tuning::kAuto;
+  using LhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 8>;
+  using RhsLayout = FixedKernelLayout<Order::kRowMajor, 1, 8>;
+  explicit Kernel(Tuning tuning_) : tuning(tuning_) {}
+  void Run(const PMat<float>& lhs, const PMat<float>& rhs,
+           const MulParams<float, DstScalar>& mul_params, int start_row,
+           int start_col, int end_row, int end_col,
+           Mat<DstScalar>* dst) const {
+    RunFloatKernelWithFloat16Dst(
+        lhs, rhs, mul_params, start_row, start_col, end_row, end_col, dst,
+        dst->layout.cols == 1 ? &KernelFloatAvx2SingleCol : &KernelFloatAvx2,
+        &StoreFloat16BlockAvx2);
+  }
+};
+
 // TODO(b/147376783): SSE 4.2 and AVX-VNNI support is incomplete / placeholder.
 // Optimization is not finished. In particular the dimensions of the kernel
 // blocks can be changed as desired.
@@ -89,8 +89,10 @@ limitations under the License.
 #ifndef RUY_RUY_INTERNAL_MATRIX_H_
 #define RUY_RUY_INTERNAL_MATRIX_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
@@ -241,6 +243,12 @@ struct PEMat final {
   void* data = nullptr;
   Type sums_type;
   void* sums = nullptr;
+  // Only used for dynamic quantization, see PMat::scales. Left as the default
+  // Type, of size 0, when there are no scales.
+  Type scales_type;
+  void* scales = nullptr;
+  // Only used with MulParams::skip_zero_rhs_slices, see PMat::zero_slices.
+  std::uint8_t* zero_slices = nullptr;
   PMatLayout layout;
   std::int32_t zero_point = 0;
 };
@@ -264,6 +272,17 @@ struct PMat final {
 
   Scalar* data = nullptr;
   SumsType* sums = nullptr;
+  // The per-column scales of a packed matrix that was quantized on the fly
+  // from a floating-point source ('dynamic quantization'): column j of the
+  // source is approximated by scales[j] times column j of the packed matrix.
+  // Null in all other cases.
+  float* scales = nullptr;
+  // Optional map of the slices of the packed matrix that are entirely equal to
+  // the zero_point, as found after packing, to let kernels skip them. Slices
+  // span the kernel.cols columns of a panel and ZeroSliceDepth(layout) rows.
+  // Slice s of panel p is zero if zero_slices[p * NumZeroSlices(layout) + s]
+  // is not 0. Null if this isn't tracked.
+  std::uint8_t* zero_slices = nullptr;
   PMatLayout layout;
   std::int32_t zero_point = 0;
 };
@@ -298,6 +317,11 @@ PMat<T> UneraseType(const PEMat& matrix) {
   PMat<T> ret;
   ret.data = static_cast<T*>(matrix.data);
   ret.sums = static_cast<SumsType*>(matrix.sums);
+  if (matrix.scales) {
+    matrix.scales_type.AssertIs<float>();
+    ret.scales = static_cast<float*>(matrix.scales);
+  }
+  ret.zero_slices = matrix.zero_slices;
   ret.layout = matrix.layout;
   ret.zero_point = matrix.zero_point;
   return ret;
@@ -433,6 +457,94 @@ inline int SumsBytes(const PEMat& packed) {
   return packed.layout.cols * packed.sums_type.size;
 }
 
+inline int ScalesBytes(const PEMat& packed) {
+  // Like the sums, there is one scale per column. This is 0 unless the packed
+  // matrix uses dynamic quantization.
+  return packed.layout.cols * packed.scales_type.size;
+}
+
+// Helpers for PMat::zero_slices.
+
+inline int ZeroSliceDepth(const PMatLayout& layout) {
+  return std::max(16, static_cast<int>(layout.kernel.rows));
+}
+
+inline int NumZeroSlices(const PMatLayout& layout) {
+  const int slice_depth = ZeroSliceDepth(layout);
+  return (layout.rows + slice_depth - 1) / slice_depth;
+}
+
+inline int ZeroSlicesBytes(const PEMat& packed) {
+  return packed.layout.cols / packed.layout.kernel.cols *
+         NumZeroSlices(packed.layout);
+}
+
+// Returns whether the slice of packed rows starting at slice_start, in the
+// panel containing column col, is known to be zero.
+template <typename PackedMatrix>
+bool IsZeroSlice(const PackedMatrix& packed, int col, int slice_start) {
+  if (!packed.zero_slices) {
+    return false;
+  }
+  const int panel = col / packed.layout.kernel.cols;
+  return packed.zero_slices[panel * NumZeroSlices(packed.layout) +
+                            slice_start / ZeroSliceDepth(packed.layout)];
+}
+
+// Returns whether the panel containing column col is known to be zero.
+inline bool IsZeroPanel(const PEMat& packed, int col) {
+  if (!packed.zero_slices) {
+    return false;
+  }
+  const int num_slices = NumZeroSlices(packed.layout);
+  const std::uint8_t* panel_slices =
+      packed.zero_slices + col / packed.layout.kernel.cols * num_slices;
+  for (int s = 0; s < num_slices; s++) {
+    if (!panel_slices[s]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Fills zero_slices for the panels of packed columns [start_col, end_col),
+// which have just been packed. Within a panel, the values of a slice are
+// contiguous, whatever the kernel layout. They are compared with the zero_point
+// as a value of the packed type, whose bytes are those of the zero_point
+// truncated to the packed type's size, both for integers and for floats, which
+// have a zero_point of 0.
+inline void FindZeroSlices(PEMat* packed, int start_col, int end_col) {
+  const PMatLayout& layout = packed->layout;
+  const int elem_size = packed->data_type.size;
+  const std::int64_t zero_point = packed->zero_point;
+  // The packed zero_point, repeated.
+  std::uint8_t zero_bytes[256];
+  for (int b = 0; b < 256; b++) {
+    zero_bytes[b] =
+        static_cast<std::uint8_t>(zero_point >> (8 * (b % elem_size)));
+  }
+  const int slice_depth = ZeroSliceDepth(layout);
+  const int num_slices = NumZeroSlices(layout);
+  const char* data = static_cast<const char*>(packed->data);
+  for (int col = start_col; col < end_col; col += layout.kernel.cols) {
+    std::uint8_t* panel_slices =
+        packed->zero_slices + col / layout.kernel.cols * num_slices;
+    for (int s = 0; s < num_slices; s++) {
+      const int slice_start = s * slice_depth;
+      const int slice_end = std::min(slice_start + slice_depth, layout.rows);
+      const char* ptr = data + Offset(layout, slice_start, col) * elem_size;
+      const int num_bytes = (slice_end - slice_start) * layout.kernel.cols *
+                            elem_size;
+      bool is_zero = true;
+      for (int i = 0; i < num_bytes && is_zero; i += sizeof(zero_bytes)) {
+        const int n = std::min<int>(sizeof(zero_bytes), num_bytes - i);
+        is_zero = !memcmp(ptr + i, zero_bytes, n);
+      }
+      panel_slices[s] = is_zero;
+    }
+  }
+}
+
 // Transpose helpers.
 
 inline void TransposeOrder(Order* order) {
@@ -119,6 +119,10 @@ enum class CachePolicy : std::uint8_t {
   kCacheIfLargeSpeedup,
   kCacheIfSignificantSpeedup,
   kAlwaysCache,
+  // Caches the packed form only until the next Context::BumpPackedEpoch, for
+  // data that is constant only for a while, typically activations multiplied
+  // by several weight matrices in a row.
+  kCacheWithinEpoch,
 };
 
 // A Matrix merely wraps existing data as a matrix. It doesn't own any buffer.
@@ -162,7 +166,8 @@ class Matrix final {
   // a CachePolicy may be used instead of the default kNeverCache,
   // which will enable ruy to take advantage of this constancy of the data to
   // cache the packing work, which can be a large speedup in matrix*vector
-  // and other narrow shapes.
+  // and other narrow shapes. For data that is constant only until the next
+  // Context::BumpPackedEpoch, use kCacheWithinEpoch.
   CachePolicy cache_policy_ = CachePolicy::kNeverCache;
 };
 
@@ -0,0 +1,79 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ruy/memory_planner.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "ruy/check_macros.h"
+#include "ruy/size_util.h"
+#include "ruy/system_aligned_alloc.h"
+
+namespace ruy {
+
+namespace {
+
+std::ptrdiff_t RoundedSize(const BufferLifetime& buffer) {
+  return round_up_pot(buffer.size, detail::kMinimumBlockAlignment);
+}
+
+bool LifetimesOverlap(const BufferLifetime& a, const BufferLifetime& b) {
+  return a.first_step <= b.last_step && b.first_step <= a.last_step;
+}
+
+}  // namespace
+
+std::ptrdiff_t PlanArena(int num_buffers, const BufferLifetime* buffers,
+                         std::ptrdiff_t* offsets) {
+  std::vector<int> order(num_buffers);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [=](int a, int b) {
+    return buffers[a].size > buffers[b].size;
+  });
+  std::ptrdiff_t arena_size = 0;
+  std::vector<int> placed;
+  std::vector<int> conflicts;
+  for (int i : order) {
+    const BufferLifetime& buffer = buffers[i];
+    RUY_DCHECK_GE(buffer.size, 0);
+    RUY_DCHECK_LE(buffer.first_step, buffer.last_step);
+    const std::ptrdiff_t size = RoundedSize(buffer);
+    // The placed buffers live at the same time as this one, by offset.
+    conflicts.clear();
+    for (int p : placed) {
+      if (LifetimesOverlap(buffer, buffers[p])) {
+        conflicts.push_back(p);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [=](int a, int b) { return offsets[a] < offsets[b]; });
+    // Find the first gap large enough.
+    std::ptrdiff_t offset = 0;
+    for (int c : conflicts) {
+      if (offsets[c] >= offset + size) {
+        break;
+      }
+      offset = std::max(offset, offsets[c] + RoundedSize(buffers[c]));
+    }
+    offsets[i] = offset;
+    arena_size = std::max(arena_size, offset + size);
+    placed.push_back(i);
+  }
+  return arena_size;
+}
+
+}  // namespace ruy
@@ -0,0 +1,55 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Planning of an arena holding the intermediate destinations of a sequence
+// of Muls, as in a chain of layers, where each intermediate is only live from
+// the Mul that produces it to the last Mul that reads it. Buffers whose
+// lifetimes don't overlap share memory, so the arena is typically much smaller
+// than the sum of all intermediates, and the same memory, likely still in
+// cache, is reused from one layer to the next. See Context::AllocateArena.
+//
+// Muls of a ChainedMul run concurrently, so all of its destinations are live
+// throughout it: this is for sequences of separate Muls.
+
+#ifndef RUY_RUY_MEMORY_PLANNER_H_
+#define RUY_RUY_MEMORY_PLANNER_H_
+
+#include <cstddef>
+
+namespace ruy {
+
+// A buffer written by step `first_step` of a sequence (e.g. the Mul producing
+// it) and last read by step `last_step`, inclusive.
+struct BufferLifetime final {
+  std::ptrdiff_t size = 0;
+  int first_step = 0;
+  int last_step = 0;
+};
+
+// Computes the offsets of the given buffers in an arena, such that buffers
+// with overlapping lifetimes don't overlap in memory, and returns the size of
+// the arena. Offsets are multiples of 64 bytes, as are the buffers returned by
+// ruy's allocators.
+//
+// Buffers are placed from the largest to the smallest, each at the lowest
+// offset where it fits. That is not always optimal, as the problem is
+// NP-hard, but is usually close to the peak of live memory, and favors low
+// offsets, which are reused the most.
+std::ptrdiff_t PlanArena(int num_buffers, const BufferLifetime* buffers,
+                         std::ptrdiff_t* offsets);
+
+}  // namespace ruy
+
+#endif  // RUY_RUY_MEMORY_PLANNER_H_
@@ -0,0 +1,103 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ruy/memory_planner.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "ruy/gtest_wrapper.h"
+
+namespace ruy {
+namespace {
+
+// Checks that buffers with overlapping lifetimes don't overlap in memory.
+void CheckPlan(const std::vector<BufferLifetime>& buffers,
+               const std::vector<std::ptrdiff_t>& offsets,
+               std::ptrdiff_t arena_size) {
+  for (std::size_t i = 0; i < buffers.size(); i++) {
+    EXPECT_EQ(offsets[i] % 64, 0);
+    EXPECT_LE(offsets[i] + buffers[i].size, arena_size);
+    for (std::size_t j = 0; j < i; j++) {
+      if (buffers[i].first_step <= buffers[j].last_step &&
+          buffers[j].first_step <= buffers[i].last_step) {
+        EXPECT_TRUE(offsets[i] + buffers[i].size <= offsets[j] ||
+                    offsets[j] + buffers[j].size <= offsets[i]);
+      }
+    }
+  }
+}
+
+TEST(MemoryPlannerTest, Chain) {
+  // Layer i writes buffer i, which layer i + 1 reads: two buffers suffice.
+  std::vector<BufferLifetime> buffers(6);
+  for (int i = 0; i < 6; i++) {
+    buffers[i].size = i % 2 ? 1000 : 4096;
+    buffers[i].first_step = i;
+    buffers[i].last_step = i + 1;
+  }
+  std::vector<std::ptrdiff_t> offsets(buffers.size());
+  const std::ptrdiff_t arena_size =
+      PlanArena(buffers.size(), buffers.data(), offsets.data());
+  CheckPlan(buffers, offsets, arena_size);
+  EXPECT_EQ(arena_size, 4096 + 1024);
+  for (int i = 0; i < 6; i += 2) {
+    EXPECT_EQ(offsets[i], offsets[0]);
+    EXPECT_EQ(offsets[i + 1], offsets[1]);
+  }
+}
+
+TEST(MemoryPlannerTest, AllLive) {
+  std::vector<BufferLifetime> buffers(4);
+  for (int i = 0; i < 4; i++) {
+    buffers[i].size = 100 * (i + 1);
+    buffers[i].first_step = 0;
+    buffers[i].last_step = 3;
+  }
+  std::vector<std::ptrdiff_t> offsets(buffers.size());
+  const std::ptrdiff_t arena_size =
+      PlanArena(buffers.size(), buffers.data(), offsets.data());
+  CheckPlan(buffers, offsets, arena_size);
+  EXPECT_EQ(arena_size, 128 + 256 + 320 + 448);
+}
+
+TEST(MemoryPlannerTest, SkipConnections) {
+  // Buffers with various lifetimes, e.g. due to residual connections.
+  std::vector<BufferLifetime> buffers;
+  for (int i = 0; i < 40; i++) {
+    BufferLifetime buffer;
+    buffer.size = 1 + (i * 7919) % 5000;
+    buffer.first_step = i / 2;
+    buffer.last_step = buffer.first_step + 1 + (i * 13) % 5;
+    buffers.push_back(buffer);
+  }
+  std::vector<std::ptrdiff_t> offsets(buffers.size());
+  const std::ptrdiff_t arena_size =
+      PlanArena(buffers.size(), buffers.data(), offsets.data());
+  CheckPlan(buffers, offsets, arena_size);
+  std::ptrdiff_t total_size = 0;
+  for (const auto& buffer : buffers) {
+    total_size += buffer.size;
+  }
+  EXPECT_LT(arena_size, total_size);
+}
+
+}  // namespace
+}  // namespace ruy
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
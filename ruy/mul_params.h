@@ -49,6 +49,65 @@ enum class ZeroPointSupport { kGeneral, kSymmetric };
 //    - Destination is ColMajor
 enum class LayoutSupport { kGeneral, kRCC };
 
+// The activation function applied to the gate in ruy::GatedMul:
+//    - kSigmoid gives the original GLU,
+//    - kSilu (x * sigmoid(x)) gives SwiGLU,
+//    - kGelu (the exact, erf-based GELU) gives GeGLU,
+//    - kRelu gives ReGLU.
+enum class GateActivation { kSigmoid, kSilu, kGelu, kRelu };
+
+// Optional reductions of the destination values, computed as a side output of
+// a matrix multiplication instead of requiring another pass over the
+// destination matrix. Each pointer that is not null designates a buffer which
+// ruy overwrites with the corresponding reduction, along each row (for
+// MulParams::row_reductions, with one value per destination row) or along each
+// column (for MulParams::col_reductions, with one value per destination
+// column). The reduced values are the final destination values, as stored in
+// the destination matrix, and the reductions are accumulated in AccumScalar.
+template <typename AccumScalar>
+struct DstReductions final {
+  AccumScalar* sum = nullptr;
+  AccumScalar* sum_of_squares = nullptr;
+  AccumScalar* maximum = nullptr;
+  AccumScalar* minimum = nullptr;
+};
+
+// Opt-in bit-packed arithmetic for binarized and ternary neural networks, see
+// MulParams::bit_packing.
+enum class BitPacking { kNone, kBinary, kTernary };
+
+// The dimension of the destination matrix along which the per-channel
+// parameters of MulParams (bias and multipliers) vary: kRow means one value per
+// destination row (the default), kCol one value per destination column.
+enum class ChannelDimension : std::int8_t { kRow, kCol };
+
+// Kinds of DstMask.
+enum class DstMaskType { kNone, kLowerTriangular, kUpperTriangular, kCustom };
+
+// Optional declaration that only some of the destination values are needed,
+// for instance in causal attention or in symmetric rank-k updates. Blocks of
+// the destination matrix that contain no needed value are then skipped
+// altogether, and the LHS and RHS panels that only such blocks would use are
+// not packed. Needed values are computed as usual; other values are
+// unspecified: they may or may not be overwritten.
+//
+// The needed values, at row i and column j, are:
+//    - kNone: all of them (the default).
+//    - kLowerTriangular: those with j <= i + diagonal_offset.
+//    - kUpperTriangular: those with j >= i + diagonal_offset.
+//    - kCustom: any value of a block for which block_predicate returns true.
+//      It is called with the half-open ranges of rows [start_row, end_row)
+//      and columns [start_col, end_col) of a block and with user_data, from
+//      any of the threads of the Context, and must return whether any value
+//      in that block is needed.
+struct DstMask final {
+  DstMaskType type = DstMaskType::kNone;
+  int diagonal_offset = 0;
+  bool (*block_predicate)(int start_row, int start_col, int end_row,
+                          int end_col, void* user_data) = nullptr;
+  void* user_data = nullptr;
+};
+
 // MulParams describes all about a matrix multiplication that
 // isn't encoded in the LHS, RHS and destination matrices. Some of that
 // information is encoded as compile-time constants and types (for instance, the
@@ -60,7 +119,8 @@ class MulParams /* not final, legitimate to subclass */ {
   // Accumulator type. The type of accumulators used to compute the dot-products
   // before being ultimately casted to the destination type.
   using AccumScalar = tAccumScalar;
-  // The destination scalar type.
+  // The destination scalar type. With float accumulators, this may also be
+  // one of the 16-bit floating-point types of float16.h.
   using DstScalar = tDstScalar;
 
   const AccumScalar* bias() const { return bias_; }
@@ -85,6 +145,56 @@ class MulParams /* not final, legitimate to subclass */ {
   void set_multiplier_exponent_perchannel(const int* ptr) {
     multiplier_exponent_perchannel_ = ptr;
   }
+  float multiplier_float() const { return multiplier_float_; }
+  void set_multiplier_float(const float value) { multiplier_float_ = value; }
+  const float* multiplier_float_perchannel() const {
+    return multiplier_float_perchannel_;
+  }
+  void set_multiplier_float_perchannel(const float* ptr) {
+    multiplier_float_perchannel_ = ptr;
+  }
+  const AccumScalar* lhs_zero_point_perchannel() const {
+    return lhs_zero_point_perchannel_;
+  }
+  void set_lhs_zero_point_perchannel(const AccumScalar* ptr) {
+    lhs_zero_point_perchannel_ = ptr;
+  }
+  const float* lhs_group_scales() const { return lhs_group_scales_; }
+  void set_lhs_group_scales(const float* ptr) { lhs_group_scales_ = ptr; }
+  int lhs_group_size() const { return lhs_group_size_; }
+  void set_lhs_group_size(const int value) { lhs_group_size_ = value; }
+  ChannelDimension channel_dimension() const { return channel_dimension_; }
+  void set_channel_dimension(const ChannelDimension value) {
+    channel_dimension_ = value;
+  }
+  GateActivation gate_activation() const { return gate_activation_; }
+  void set_gate_activation(const GateActivation value) {
+    gate_activation_ = value;
+  }
+  const DstReductions<AccumScalar>& row_reductions() const {
+    return row_reductions_;
+  }
+  DstReductions<AccumScalar>* mutable_row_reductions() {
+    return &row_reductions_;
+  }
+  const DstReductions<AccumScalar>& col_reductions() const {
+    return col_reductions_;
+  }
+  DstReductions<AccumScalar>* mutable_col_reductions() {
+    return &col_reductions_;
+  }
+  const int* lhs_row_indices() const { return lhs_row_indices_; }
+  void set_lhs_row_indices(const int* ptr) { lhs_row_indices_ = ptr; }
+  const int* rhs_col_indices() const { return rhs_col_indices_; }
+  void set_rhs_col_indices(const int* ptr) { rhs_col_indices_ = ptr; }
+  BitPacking bit_packing() const { return bit_packing_; }
+  void set_bit_packing(const BitPacking value) { bit_packing_ = value; }
+  int strassen_cutoff() const { return strassen_cutoff_; }
+  void set_strassen_cutoff(int value) { strassen_cutoff_ = value; }
+  bool skip_zero_rhs_slices() const { return skip_zero_rhs_slices_; }
+  void set_skip_zero_rhs_slices(bool value) { skip_zero_rhs_slices_ = value; }
+  const DstMask& dst_mask() const { return dst_mask_; }
+  DstMask* mutable_dst_mask() { return &dst_mask_; }
   DstScalar clamp_min() const { return clamp_min_; }
   void set_clamp_min(const DstScalar value) { clamp_min_ = value; }
   DstScalar clamp_max() const { return clamp_max_; }
@@ -113,12 +223,137 @@ class MulParams /* not final, legitimate to subclass */ {
   // Either none or both of multiplier_exponent_perchannel and
   // multiplier_fixedpoint_perchannel must be nullptr.
   const int* multiplier_exponent_perchannel_ = nullptr;
+  // Only for non-floating-point cases. Opt-in alternative to the above
+  // fixed-point multiplier: if not 0, accumulators are converted to float,
+  // multiplied by this value, and rounded back to int32 (to nearest, ties to
+  // even, saturating to [-2^30, 2^30]), before the destination zero_point is
+  // added. When this is used,
+  // multiplier_fixedpoint and multiplier_exponent, and their per-channel
+  // variants, must be left at their default values.
+  //
+  // Bit-exactness: with the fixed-point multiplier, optimized paths may break
+  // rounding ties differently from Path::kStandardCpp (see
+  // RUY_OPT(NATIVE_ROUNDING)), so results may differ by 1. With the float
+  // multiplier, all paths perform the exact same IEEE single-precision
+  // operations, so results are bit-exact across paths; they are not
+  // bit-exact with the fixed-point multiplier, and accumulators beyond 2^24 in
+  // magnitude are rounded when converted to float.
+  //
+  // With dynamic quantization, i.e. an integer LHS and a floating-point RHS,
+  // which the packing code quantizes to int8 with one scale per column, this is
+  // the scale of the LHS and is required: the destination value is then
+  // accum * multiplier_float * rhs_column_scale, followed by clamping. There
+  // is no rounding to int32 and no destination zero_point in that case.
+  //
+  // With an 8-bit floating-point LHS (see float8.h), this is the optional
+  // scale of the LHS: if not 0, accumulators are multiplied by it before the
+  // bias is added.
+  float multiplier_float_ = 0;
+  // Per-channel variant of multiplier_float. If not nullptr, this must point to
+  // a buffer of as many values as there are rows in the destination matrix.
+  // Each row of the destination matrix will use the corresponding buffer
+  // element instead of multiplier_float.
+  const float* multiplier_float_perchannel_ = nullptr;
+  // Only for non-floating-point cases. Per-channel variant of the LHS
+  // zero_point. If not nullptr, this must point to a buffer of as many values
+  // as there are rows in the destination matrix. The zero_point of row i of the
+  // LHS matrix is then lhs.zero_point() + lhs_zero_point_perchannel[i]. The
+  // typical usage is to leave lhs.zero_point() at 0 and pass the actual
+  // per-channel zero points here.
+  const AccumScalar* lhs_zero_point_perchannel_ = nullptr;
+  // Only for dynamic quantization (see multiplier_float). Group-wise
+  // alternative to multiplier_float as the scale of the LHS: the depth
+  // dimension is split into groups of lhs_group_size consecutive elements,
+  // the last one possibly partial, and each group of each row has its own
+  // scale. If not nullptr, this must point to a buffer of
+  // ceil(depth / lhs_group_size) * rows values, where rows is the number of
+  // rows of the destination matrix, storing the scale of group g of row i at
+  // index g * rows + i. Accumulation is then done in int32 within each group,
+  // and in float across groups. multiplier_float and
+  // multiplier_float_perchannel must be left at their default values.
+  const float* lhs_group_scales_ = nullptr;
+  // Number of depth elements per group for lhs_group_scales.
+  int lhs_group_size_ = 0;
+  // Which dimension of the destination bias, multiplier_fixedpoint_perchannel,
+  // multiplier_exponent_perchannel and multiplier_float_perchannel are indexed
+  // by, see ChannelDimension. Their descriptions above assume kRow; with kCol,
+  // they hold one value per column of the destination instead.
+  // lhs_zero_point_perchannel and lhs_group_scales always refer to rows. Only
+  // kRow is supported with dynamic quantization, with an 8-bit floating-point
+  // LHS, and by ruy::GatedMul.
+  ChannelDimension channel_dimension_ = ChannelDimension::kRow;
+  // Only for ruy::GatedMul. The activation function applied to the product of
+  // the gate matrix by the RHS.
+  GateActivation gate_activation_ = GateActivation::kSilu;
+  // Reductions of the destination values along each row, see DstReductions.
+  DstReductions<AccumScalar> row_reductions_;
+  // Reductions of the destination values along each column, see
+  // DstReductions.
+  DstReductions<AccumScalar> col_reductions_;
+  // Optional selection of the rows of the LHS for which the product is
+  // computed. If not nullptr, this must point to a buffer of as many values as
+  // there are rows in the destination matrix, each a row index of the LHS
+  // matrix, which may then have any number of rows: row i of the destination
+  // receives row lhs_row_indices[i] of the product. This avoids gathering the
+  // selected rows of the LHS into a new matrix, so that the packed form of the
+  // whole LHS can still be cached (see cache_policy). Only the packed panels
+  // containing selected rows are used. The per-channel parameters above, and
+  // lhs_group_scales, still refer to rows of the LHS, not of the destination.
+  // Not supported by ruy::GatedMul.
+  const int* lhs_row_indices_ = nullptr;
+  // Same as lhs_row_indices, for the columns of the RHS and of the destination.
+  const int* rhs_col_indices_ = nullptr;
+  // Only for int8 LHS and RHS with int32 accumulators and zero_points of 0.
+  // With kBinary, all LHS and RHS values must be -1 or 1, and with kTernary,
+  // -1, 0 or 1. Packing then stores 1 bit per value (2 bits with kTernary),
+  // making cached packed matrices 8x (4x) smaller, and the kernel computes
+  // dot-products with bitwise operations and population counts. Accumulators
+  // go through the same bias, multiplier and clamping as in other integer
+  // multiplications. This is implemented in portable C++, for all paths. Not
+  // supported by ruy::GatedMul nor together with skip_zero_rhs_slices.
+  BitPacking bit_packing_ = BitPacking::kNone;
+  // Opt-in for Strassen's recursive algorithm (see strassen.h), when
+  // positive. Only for floating-point types, with the same type for LHS, RHS,
+  // accumulators and destination. Each level of recursion halves all
+  // dimensions, trading 1 of the 8 block products for 18 block additions,
+  // until any of them is at most strassen_cutoff; the remaining products use
+  // the regular kernels. The best value depends on the machine, but is
+  // typically a few thousands, as below that, the additions and temporary
+  // buffers cost more than the saved products.
+  //
+  // Accuracy is lower than with the classical algorithm: its error bound is
+  // componentwise, |error(i, j)| <= depth * u * sum_k |lhs(i, k) rhs(k, j)|,
+  // with u the unit roundoff, while Strassen's is only normwise, growing by
+  // a factor of about 12 (instead of 2) with each halving of the dimensions:
+  // max |error| <= c * (depth / leaf_depth)^log2(12) * leaf_depth * u *
+  // max |lhs| * max |rhs|. Small destination values can thus have large
+  // relative errors, especially with many levels of recursion.
+  //
+  // Ignored by ruy::GatedMul and ruy::GroupedMul, and with row_reductions,
+  // col_reductions, lhs_row_indices or rhs_col_indices. Packed blocks are
+  // never cached (see cache_policy), and dst_mask doesn't avoid any
+  // computation.
+  int strassen_cutoff_ = 0;
+  // Opt-in for RHS matrices with many zeros, such as activations after a ReLU.
+  // When packing the RHS, ruy then records which slices of its packed panels
+  // (a few columns by a few rows) are entirely zero, i.e. equal to the RHS
+  // zero_point. Runs of RHS panels that are entirely zero skip the kernel,
+  // leaving only the bias and the rest of the epilogue to apply, and
+  // Path::kStandardCpp also skips zero slices within other panels. This
+  // costs an extra pass over the packed RHS, and with floating-point types,
+  // infinite or NaN LHS values multiplied by zeros are no longer propagated.
+  // Not supported by ruy::GatedMul, and ignored for cached RHS matrices.
+  bool skip_zero_rhs_slices_ = false;
+  // Which destination values are needed, see DstMask. Not supported together
+  // with row_reductions and col_reductions.
+  DstMask dst_mask_;
   // min clamp bound of destination values.
-  DstScalar clamp_min_ = std::is_floating_point<DstScalar>::value
-                             ? -std::numeric_limits<DstScalar>::infinity()
+  DstScalar clamp_min_ = std::numeric_limits<DstScalar>::has_infinity
+                             ? static_cast<DstScalar>(
+                                   -std::numeric_limits<DstScalar>::infinity())
                              : std::numeric_limits<DstScalar>::lowest();
   // max clamp bound of destination values.
-  DstScalar clamp_max_ = std::is_floating_point<DstScalar>::value
+  DstScalar clamp_max_ = std::numeric_limits<DstScalar>::has_infinity
                              ? std::numeric_limits<DstScalar>::infinity()
                              : std::numeric_limits<DstScalar>::max();
 
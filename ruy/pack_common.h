@@ -16,16 +16,24 @@ limitations under the License.
 #ifndef RUY_RUY_PACK_COMMON_H_
 #define RUY_RUY_PACK_COMMON_H_
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 
 #include "ruy/check_macros.h"
 #include "ruy/common.h"
+#include "ruy/float8.h"
 #include "ruy/mat.h"
 #include "ruy/matrix.h"
 #include "ruy/opt_set.h"
 #include "ruy/path.h"
 #include "ruy/platform.h"
 #include "ruy/profiler/instrumentation.h"
+#include "ruy/side_pair.h"
 #include "ruy/tune.h"
 
 namespace ruy {
@@ -106,6 +114,17 @@ struct PackedTypeImpl<Path::kAvxVnni, std::uint8_t> {
 template <Path ThePath, typename Scalar>
 using PackedType = typename PackedTypeImpl<ThePath, Scalar>::Type;
 
+// 'Dynamic quantization' is the case of an integer LHS (typically
+// pre-quantized weights) multiplied by a floating-point RHS (typically
+// activations). The RHS is then quantized to int8 on the fly by the packing
+// code, see the PackImpl specialization below, and the kernel dequantizes the
+// accumulators to a floating-point destination.
+template <typename LhsScalar, typename RhsScalar>
+struct IsDynamicQuantization
+    : std::integral_constant<bool,
+                             std::numeric_limits<LhsScalar>::is_integer &&
+                                 std::is_floating_point<RhsScalar>::value> {};
+
 template <typename PackedScalar, typename Scalar>
 PackedScalar Pack(Scalar x) {
   return x - SymmetricZeroPoint<Scalar>() + SymmetricZeroPoint<PackedScalar>();
@@ -151,6 +170,73 @@ struct PackImpl<Path::kStandardCpp, FixedKernelLayout, Scalar, PackedScalar,
   }
 };
 
+// Packing with dynamic quantization of a float source into int8. Each column
+// gets its own symmetric scale, mapping its largest magnitude to 127, which is
+// stored in packed_matrix->scales for the kernel to dequantize accumulators.
+// The packed int8 values and their sums are written in the same pass, so the
+// quantized RHS never exists outside of the packed matrix.
+template <typename FixedKernelLayout>
+struct PackImpl<Path::kStandardCpp, FixedKernelLayout, float, std::int8_t,
+                std::int32_t> {
+  static void Run(Tuning, const Mat<float>& src_matrix,
+                  PMat<std::int8_t>* packed_matrix, int start_col,
+                  int end_col) {
+    profiler::ScopeLabel label("Pack (generic, dynamic quantization)");
+    RUY_DCHECK_EQ((end_col - start_col) % FixedKernelLayout::kCols, 0);
+    RUY_DCHECK(packed_matrix->scales);
+    RUY_DCHECK_EQ(packed_matrix->zero_point, 0);
+    std::int32_t* sums = packed_matrix->sums;
+    float* scales = packed_matrix->scales;
+    for (int col = start_col; col < end_col; col++) {
+      const bool col_in_src = col < src_matrix.layout.cols;
+      float max_abs = 0;
+      if (col_in_src) {
+        for (int row = 0; row < src_matrix.layout.rows; row++) {
+          max_abs = std::max(max_abs, std::abs(Element(src_matrix, row, col)));
+        }
+      }
+      const float inverse_scale = max_abs > 0 ? 127.f / max_abs : 0.f;
+      std::int32_t accum = 0;
+      for (int row = 0; row < packed_matrix->layout.rows; row++) {
+        std::int8_t packed_val = 0;
+        if (col_in_src && row < src_matrix.layout.rows) {
+          float q =
+              std::nearbyint(Element(src_matrix, row, col) * inverse_scale);
+          q = std::min(127.f, std::max(-127.f, q));
+          packed_val = static_cast<std::int8_t>(q);
+        }
+        accum += packed_val;
+        *ElementPtr(packed_matrix, row, col) = packed_val;
+      }
+      sums[col] = accum;
+      scales[col] = max_abs / 127.f;
+    }
+  }
+};
+
+// Packing of an 8-bit floating-point LHS, which stays 8-bit, see float8.h.
+// There are no sums, as there are no zero_points.
+template <typename FixedKernelLayout, int kExponentBits>
+struct PackImpl<Path::kStandardCpp, FixedKernelLayout, Float8<kExponentBits>,
+                Float8<kExponentBits>, std::int32_t> {
+  static void Run(Tuning, const Mat<Float8<kExponentBits>>& src_matrix,
+                  PMat<Float8<kExponentBits>>* packed_matrix, int start_col,
+                  int end_col) {
+    profiler::ScopeLabel label("Pack (generic, float8)");
+    RUY_DCHECK_EQ((end_col - start_col) % FixedKernelLayout::kCols, 0);
+    for (int col = start_col; col < end_col; col++) {
+      for (int row = 0; row < packed_matrix->layout.rows; row++) {
+        Float8<kExponentBits> packed_val;
+        if (col < src_matrix.layout.cols && row < src_matrix.layout.rows) {
+          packed_val = Element(src_matrix, row, col);
+        }
+        *ElementPtr(packed_matrix, row, col) = packed_val;
+      }
+      packed_matrix->sums[col] = 0;
+    }
+  }
+};
+
 #if RUY_PLATFORM_NEON
 RUY_INHERIT_PACK(Path::kStandardCpp, Path::kNeon)
 RUY_INHERIT_PACK(Path::kNeon, Path::kNeonDotprod)
@@ -173,6 +259,99 @@ void RunPack(Tuning tuning, const EMat& src_matrix, PEMat* packed_matrix,
       tuning, src, &packed, start_col, end_col);
 }
 
+// Number of 64-bit words per bit plane of a column of a bit-packed matrix, see
+// RunBitPack.
+inline int NumBitPackedWords(int depth) { return (depth + 63) / 64; }
+
+// Packing for MulParams::bit_packing, for int8 sources with values -1 or 1
+// (kBitPlanes == 1, binary) or -1, 0 or 1 (kBitPlanes == 2, ternary). Each
+// packed column is made of kBitPlanes planes of NumBitPackedWords(depth)
+// words: with kBitPlanes == 2, a plane of nonzero bits, then a plane of sign
+// bits (set for -1), and with kBitPlanes == 1, only the plane of sign bits.
+// Padding bits are 0. As they then compare as equal in binary dot-products,
+// the sums hold the depth, which the kernel needs to correct for them.
+template <int kBitPlanes>
+void RunBitPack(Tuning, const EMat& src_matrix, PEMat* packed_matrix,
+                int start_col, int end_col) {
+  profiler::ScopeLabel label("Pack (bit-packed)");
+  Mat<std::int8_t> src = UneraseType<std::int8_t>(src_matrix);
+  const int depth = src.layout.rows;
+  const int num_words = NumBitPackedWords(depth);
+  const int stride = packed_matrix->layout.stride;
+  for (int col = start_col; col < end_col; col++) {
+    std::uint64_t* words =
+        static_cast<std::uint64_t*>(packed_matrix->data) + col * stride;
+    memset(words, 0, stride * sizeof(std::uint64_t));
+    std::uint64_t* nonzero_bits = words;
+    std::uint64_t* sign_bits = words + (kBitPlanes - 1) * num_words;
+    if (col < src.layout.cols) {
+      for (int k = 0; k < depth; k++) {
+        const std::int8_t val = Element(src, k, col);
+        RUY_DCHECK(val == -1 || val == 1 || (kBitPlanes == 2 && val == 0));
+        const std::uint64_t bit = std::uint64_t(1) << (k % 64);
+        if (val < 0) {
+          sign_bits[k / 64] |= bit;
+        }
+        if (kBitPlanes == 2 && val != 0) {
+          nonzero_bits[k / 64] |= bit;
+        }
+      }
+    }
+    static_cast<std::int32_t*>(packed_matrix->sums)[col] = depth;
+  }
+}
+
+// Packing for ruy::ComplexMul, which multiplies complex matrices as real
+// matrices of twice their dimensions, interleaving real and imaginary parts:
+//
+//   lhs:  [ re -im ]    rhs:  [ re ]    dst:  [ re ]
+//         [ im  re ]          [ im ]          [ im ]
+//
+// with each complex value expanding to such a 2x2 or 2x1 block. The source is
+// the complex matrix, described by the layout of `src_matrix` except for its
+// rows and cols, which are those of the real matrix being packed: the
+// transposed expanded LHS for kSide == Side::kLhs, or the expanded RHS.
+template <typename Scalar, Side kSide>
+void RunComplexPack(Tuning, const EMat& src_matrix, PEMat* packed_matrix,
+                    int start_col, int end_col) {
+  profiler::ScopeLabel label("Pack (complex)");
+  Mat<std::complex<Scalar>> src;
+  src.data.set(static_cast<const std::complex<Scalar>*>(src_matrix.data));
+  src.layout = src_matrix.layout;
+  src.layout.rows /= 2;
+  if (kSide == Side::kLhs) {
+    src.layout.cols /= 2;
+  }
+  PMat<Scalar> packed = UneraseType<Scalar>(*packed_matrix);
+  for (int col = start_col; col < end_col; col++) {
+    Scalar accum = 0;
+    for (int row = 0; row < packed.layout.rows; row++) {
+      Scalar packed_val = 0;
+      if (col < src_matrix.layout.cols && row < src_matrix.layout.rows) {
+        const bool is_imag_row = row % 2;
+        if (kSide == Side::kLhs) {
+          // Row `col` of the expanded LHS, which is the real part of a dst
+          // value if even, and its imaginary part if odd.
+          const std::complex<Scalar> val = Element(src, row / 2, col / 2);
+          if (col % 2 == 0) {
+            packed_val = is_imag_row ? -val.imag() : val.real();
+          } else {
+            packed_val = is_imag_row ? val.real() : val.imag();
+          }
+        } else {
+          const std::complex<Scalar> val = Element(src, row / 2, col);
+          packed_val = is_imag_row ? val.imag() : val.real();
+        }
+      }
+      accum += packed_val;
+      *ElementPtr(&packed, row, col) = packed_val;
+    }
+    if (packed.sums) {
+      packed.sums[col] = accum;
+    }
+  }
+}
+
 }  // namespace ruy
 
 #endif  // RUY_RUY_PACK_COMMON_H_
@@ -23,7 +23,7 @@ namespace ruy {
 
 namespace {
 
-// Allocates the `data` and `sums` buffers, and sets the corresponding
+// Allocates the `data`, `sums` and `scales` buffers, and sets the corresponding
 // pointer fields, in a PEMat whose other fields, particularly `layout`
 // and the runtime data types, are already populated.
 int AllocateBuffers(PEMat* packed_matrix) {
@@ -35,13 +35,19 @@ int AllocateBuffers(PEMat* packed_matrix) {
     sums_bytes = SumsBytes(*packed_matrix);
     packed_matrix->sums = detail::SystemAlignedAlloc(sums_bytes);
   }
-  return data_bytes + sums_bytes;
+  const int scales_bytes = ScalesBytes(*packed_matrix);
+  if (scales_bytes) {
+    // Dynamically quantized matrices also need the `scales` buffer.
+    packed_matrix->scales = detail::SystemAlignedAlloc(scales_bytes);
+  }
+  return data_bytes + sums_bytes + scales_bytes;
 }
 
-// Frees the `data` and `sums` buffers held by a PEMat.
+// Frees the `data`, `sums` and `scales` buffers held by a PEMat.
 void FreeBuffers(const PEMat& packed_matrix) {
   detail::SystemAlignedFree(packed_matrix.data);
   detail::SystemAlignedFree(packed_matrix.sums);
+  detail::SystemAlignedFree(packed_matrix.scales);
 }
 
 }  // end anonymous namespace
@@ -101,6 +107,44 @@ PrepackedCache::Action PrepackedCache::Get(const void* src_data,
   return Action::kInsertedNewEntry;
 }
 
+const PEMat* PrepackedCache::Find(const void* src_data) const {
+  const Entry* result = nullptr;
+  for (const auto& pair : cache_) {
+    if (pair.first.src_data == src_data &&
+        (!result || pair.second.timestamp > result->timestamp)) {
+      result = &pair.second;
+    }
+  }
+  return result ? &result->packed_matrix : nullptr;
+}
+
+EpochPackedCache::Action EpochPackedCache::Get(const void* src_data,
+                                               PEMat* packed_matrix) {
+  if (entries_epoch_ != epoch_) {
+    entries_.clear();
+    allocator_.FreeAll();
+    entries_epoch_ = epoch_;
+  }
+  PrepackedCache::Key key;
+  key.src_data = src_data;
+  key.packed_layout = packed_matrix->layout;
+  key.zero_point = packed_matrix->zero_point;
+  for (const Entry& entry : entries_) {
+    if (entry.key == key) {
+      *packed_matrix = entry.packed_matrix;
+      return Action::kGotExistingEntry;
+    }
+  }
+  // Zero-sized buffers, such as the scales unless dynamically
+  // quantized, are null.
+  packed_matrix->data = allocator_.AllocateBytes(DataBytes(*packed_matrix));
+  packed_matrix->sums = allocator_.AllocateBytes(SumsBytes(*packed_matrix));
+  packed_matrix->scales =
+      allocator_.AllocateBytes(ScalesBytes(*packed_matrix));
+  entries_.push_back(Entry{key, *packed_matrix});
+  return Action::kInsertedNewEntry;
+}
+
 void PrepackedCache::EjectUntilRoomFor(int new_bytes) {
   profiler::ScopeLabel label("PrepackedCacheEjection");
   // While we are above the threshold of ejection, eject the LRU entry.
@@ -121,7 +165,8 @@ void PrepackedCache::EjectOne() {
     }
   }
   const PEMat& packed_matrix = oldest->second.packed_matrix;
-  buffers_bytes_ -= DataBytes(packed_matrix) + SumsBytes(packed_matrix);
+  buffers_bytes_ -= DataBytes(packed_matrix) + SumsBytes(packed_matrix) +
+                    ScalesBytes(packed_matrix);
   FreeBuffers(packed_matrix);
   cache_.erase(oldest);
 }
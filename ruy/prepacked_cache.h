@@ -19,7 +19,9 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <unordered_map>
+#include <vector>
 
+#include "ruy/allocator.h"
 #include "ruy/mat.h"
 
 namespace ruy {
@@ -126,6 +128,11 @@ class PrepackedCache final {
   //    entry was created. Otherwise it is Action::kGotExistingEntry.
   Action Get(const void* src_data, PEMat* packed_matrix);
 
+  // Returns the most recently used packed matrix whose source matrix data
+  // pointer is `src_data`, or nullptr if there is none. Like ejection, this
+  // linearly searches the entries. Timestamps are not updated.
+  const PEMat* Find(const void* src_data) const;
+
  private:
   void EjectOne();
   void EjectUntilRoomFor(int new_bytes);
@@ -136,6 +143,46 @@ class PrepackedCache final {
   Timestamp timestamp_ = 0;
 };
 
+// Cache for packed matrices with CachePolicy::kCacheWithinEpoch, typically
+// activations multiplied by several weight matrices in a row. Entries are
+// only valid within the epoch in which they were inserted: the first Get of a
+// new epoch drops them all at once. Buffers come from an Allocator, so that in
+// steady state, e.g. with the same shapes at each inference, no system
+// allocation happens.
+//
+// Like PrepackedCache, this is owned by a Context, and not thread-safe.
+class EpochPackedCache final {
+ public:
+  using Action = PrepackedCache::Action;
+
+  // Same as PrepackedCache::Get, for entries inserted in the current epoch.
+  // The `data`, `sums` and `scales` buffers remain valid until the first Get
+  // of a later epoch.
+  Action Get(const void* src_data, PEMat* packed_matrix);
+
+  // Starts a new epoch, invalidating all entries.
+  void BumpEpoch() { epoch_++; }
+
+  // Returns the number of packed matrices inserted in the current epoch.
+  int MatrixCount() const {
+    return entries_epoch_ == epoch_ ? entries_.size() : 0;
+  }
+
+ private:
+  struct Entry {
+    PrepackedCache::Key key;
+    PEMat packed_matrix;
+  };
+
+  // Few matrices are typically reused within an epoch, so entries are
+  // searched linearly.
+  std::vector<Entry> entries_;
+  Allocator allocator_;
+  std::uint64_t epoch_ = 0;
+  // The epoch in which the current entries were inserted.
+  std::uint64_t entries_epoch_ = 0;
+};
+
 }  // namespace ruy
 
 #endif  // RUY_RUY_PREPACKED_CACHE_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #include "ruy/prepacked_cache.h"
 
 #include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "ruy/context.h"
 #include "ruy/context_get_ctx.h"
@@ -300,6 +301,138 @@ TEST(PrepackedCacheTest, TestClearCache) {
   EXPECT_EQ(cache->MatrixCount(), 0);
 }
 
+TEST(PrepackedCacheTest, TestEpochPackedCache) {
+  EpochPackedCache cache;
+  std::vector<std::uint8_t> data1(10 * 20);
+  std::vector<std::uint8_t> data2(5 * 3);
+  PEMat mat1 = MakeDummyPEMat(Type::Create<std::uint8_t>(), 10, 20);
+  PEMat mat2 = MakeDummyPEMat(Type::Create<std::uint8_t>(), 5, 3);
+  EXPECT_TRUE(cache.Get(data1.data(), &mat1) ==
+              EpochPackedCache::Action::kInsertedNewEntry);
+  DummyPack(data1, &mat1);
+  EXPECT_TRUE(cache.Get(data2.data(), &mat2) ==
+              EpochPackedCache::Action::kInsertedNewEntry);
+  EXPECT_EQ(cache.MatrixCount(), 2);
+
+  PEMat mat1_again = MakeDummyPEMat(Type::Create<std::uint8_t>(), 10, 20);
+  EXPECT_TRUE(cache.Get(data1.data(), &mat1_again) ==
+              EpochPackedCache::Action::kGotExistingEntry);
+  EXPECT_EQ(mat1_again.data, mat1.data);
+  EXPECT_EQ(mat1_again.sums, mat1.sums);
+
+  // A different packed layout of the same data is a different entry.
+  PEMat mat1_transposed = MakeDummyPEMat(Type::Create<std::uint8_t>(), 20, 10);
+  EXPECT_TRUE(cache.Get(data1.data(), &mat1_transposed) ==
+              EpochPackedCache::Action::kInsertedNewEntry);
+  EXPECT_EQ(cache.MatrixCount(), 3);
+
+  // Entries of past epochs are not reused.
+  cache.BumpEpoch();
+  EXPECT_EQ(cache.MatrixCount(), 0);
+  EXPECT_TRUE(cache.Get(data1.data(), &mat1) ==
+              EpochPackedCache::Action::kInsertedNewEntry);
+  EXPECT_EQ(cache.MatrixCount(), 1);
+}
+
+TEST(PrepackedCacheTest, TestCacheWithinEpoch) {
+  ruy::Context context;
+  EpochPackedCache* cache = get_ctx(&context)->GetEpochPackedCache();
+
+  const float lhs1_data[] = {1, 2, 3, 4};
+  const float lhs2_data[] = {5, 6, 7, 8};
+  float rhs_data[] = {1, 2};
+  float dst_data[2];
+
+  ruy::Matrix<float> lhs1;
+  ruy::MakeSimpleLayout(2, 2, ruy::Order::kRowMajor, lhs1.mutable_layout());
+  lhs1.set_data(lhs1_data);
+  ruy::Matrix<float> lhs2;
+  ruy::MakeSimpleLayout(2, 2, ruy::Order::kRowMajor, lhs2.mutable_layout());
+  lhs2.set_data(lhs2_data);
+  ruy::Matrix<float> rhs;
+  ruy::MakeSimpleLayout(2, 1, ruy::Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data);
+  rhs.set_cache_policy(CachePolicy::kCacheWithinEpoch);
+  ruy::Matrix<float> dst;
+  ruy::MakeSimpleLayout(2, 1, ruy::Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data);
+
+  // Both Muls share the packed RHS, which isn't in the long-lived cache.
+  ruy::MulParams<float, float> mul_params;
+  ruy::Mul<ruy::kAllPaths>(lhs1, rhs, mul_params, &context, &dst);
+  EXPECT_EQ(dst_data[0], 5);
+  EXPECT_EQ(dst_data[1], 11);
+  ruy::Mul<ruy::kAllPaths>(lhs2, rhs, mul_params, &context, &dst);
+  EXPECT_EQ(dst_data[0], 17);
+  EXPECT_EQ(dst_data[1], 23);
+  EXPECT_EQ(cache->MatrixCount(), 1);
+  EXPECT_EQ(get_ctx(&context)->GetPrepackedCache()->MatrixCount(), 0);
+
+  // New activations in the same buffer, in a new epoch, are repacked.
+  rhs_data[0] = 3;
+  context.BumpPackedEpoch();
+  ruy::Mul<ruy::kAllPaths>(lhs1, rhs, mul_params, &context, &dst);
+  EXPECT_EQ(dst_data[0], 7);
+  EXPECT_EQ(dst_data[1], 17);
+  EXPECT_EQ(cache->MatrixCount(), 1);
+}
+
+TEST(PrepackedCacheTest, TestFind) {
+  PrepackedCache prepacked_cache;
+  std::vector<std::uint8_t> data1(10 * 20);
+  std::vector<std::uint8_t> data2(10 * 20);
+  EXPECT_EQ(prepacked_cache.Find(data1.data()), nullptr);
+  PEMat mat1 = MakeDummyPEMat(Type::Create<std::uint8_t>(), 10, 20);
+  prepacked_cache.Get(data1.data(), &mat1);
+  const PEMat* found = prepacked_cache.Find(data1.data());
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(found->data, mat1.data);
+  EXPECT_EQ(prepacked_cache.Find(data2.data()), nullptr);
+}
+
+TEST(PrepackedCacheTest, TestPrefetchPacked) {
+  ruy::Context context;
+  context.set_max_num_threads(4);
+  Ctx* ctx = get_ctx(&context);
+
+  const int size = 64;
+  std::vector<float> lhs_data(size * size, 1);
+  std::vector<float> rhs_data(size * size, 2);
+  std::vector<float> dst_data(size * size);
+  ruy::Matrix<float> lhs;
+  ruy::MakeSimpleLayout(size, size, ruy::Order::kRowMajor,
+                        lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  lhs.set_cache_policy(CachePolicy::kAlwaysCache);
+  ruy::Matrix<float> rhs;
+  ruy::MakeSimpleLayout(size, size, ruy::Order::kColMajor,
+                        rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  ruy::Matrix<float> dst;
+  ruy::MakeSimpleLayout(size, size, ruy::Order::kColMajor,
+                        dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  ruy::MulParams<float, float> mul_params;
+
+  // Nothing to prefetch until the LHS is cached.
+  context.PrefetchPacked(lhs);
+  EXPECT_EQ(ctx->TakePackedToPrefetch(), nullptr);
+
+  ruy::Mul<ruy::kAllPaths>(lhs, rhs, mul_params, &context, &dst);
+  context.PrefetchPacked(lhs);
+  EXPECT_NE(ctx->TakePackedToPrefetch(), nullptr);
+  // Requests are taken only once.
+  EXPECT_EQ(ctx->TakePackedToPrefetch(), nullptr);
+
+  // The next Mul takes the request, and prefetching has no visible effect.
+  context.PrefetchPacked(lhs);
+  ruy::Mul<ruy::kAllPaths>(lhs, rhs, mul_params, &context, &dst);
+  EXPECT_EQ(ctx->TakePackedToPrefetch(), nullptr);
+  for (float value : dst_data) {
+    EXPECT_EQ(value, 2 * size);
+  }
+}
+
 }  // namespace
 }  // namespace ruy
 
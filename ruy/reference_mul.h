@@ -30,17 +30,23 @@ void ReferenceMul(const Matrix<LhsScalar>& lhs, const Matrix<RhsScalar>& rhs,
                   const MulParams<AccumScalar, DstScalar>& mul_params,
                   Matrix<DstScalar>* dst) {
   for (int i = 0; i < lhs.layout().rows(); i++) {
+    AccumScalar lhs_zero_point = lhs.zero_point();
+    if (mul_params.lhs_zero_point_perchannel()) {
+      lhs_zero_point += mul_params.lhs_zero_point_perchannel()[i];
+    }
     for (int j = 0; j < rhs.layout().cols(); j++) {
       AccumScalar accum = 0;
       for (int k = 0; k < lhs.layout().cols(); k++) {
         AccumScalar lhs_val = Element(lhs, i, k);
         AccumScalar rhs_val = Element(rhs, k, j);
-        accum += (lhs_val - lhs.zero_point()) * (rhs_val - rhs.zero_point());
+        accum += (lhs_val - lhs_zero_point) * (rhs_val - rhs.zero_point());
       }
+      const int channel =
+          mul_params.channel_dimension() == ChannelDimension::kCol ? j : i;
       if (mul_params.bias()) {
-        accum += mul_params.bias()[i];
+        accum += mul_params.bias()[channel];
       }
-      ApplyMultiplier(mul_params, i, &accum);
+      ApplyMultiplier(mul_params, channel, &accum);
       accum += dst->zero_point();
       accum = std::min<AccumScalar>(accum, mul_params.clamp_max());
       accum = std::max<AccumScalar>(accum, mul_params.clamp_min());
@@ -18,11 +18,16 @@ limitations under the License.
 #ifndef RUY_RUY_RUY_H_
 #define RUY_RUY_RUY_H_
 
+#include <complex>
+
 #include "ruy/context.h"
 #include "ruy/context_get_ctx.h"
 #include "ruy/dispatch.h"
+#include "ruy/float16.h"
+#include "ruy/float8.h"
 #include "ruy/mat.h"
 #include "ruy/matrix.h"
+#include "ruy/memory_planner.h"
 #include "ruy/mul_params.h"
 #include "ruy/path.h"
 
@@ -66,14 +71,14 @@ namespace ruy {
 // nothing is done to ensure reentrancy with shared Context objects.
 //
 // Ruy defaults to using only 1 thread. Multi-threading is always opted in to,
-// by calling Context::set_max_num_threads() with an explicit thread count.
-// If multiple threads may concurrently be calling ruy::Mul, it is advisable
-// to set up their respective Context objects with set_max_num_threads so that
-// the overall number of threads doesn't exceed the overall number of threads
-// that the system can usefully execute concurrently
-// (e.g. the number of CPU cores in typical scenarios). At least ruy forces
-// each invocation to make an explicit decision here, there is no automatic
-// detection of the best number of threads to use in ruy.
+// by calling Context::set_max_num_threads() with an explicit thread count, or
+// with Context::kAutoMaxNumThreads to use as many threads as there are CPUs
+// available to the process (accounting for affinity masks and container CPU
+// quotas). If multiple threads may concurrently be calling ruy::Mul, it is
+// advisable to set up their respective Context objects with
+// set_max_num_threads so that the overall number of threads doesn't exceed
+// the overall number of threads that the system can usefully execute
+// concurrently (e.g. the number of CPU cores in typical scenarios).
 template <typename LhsScalar, typename RhsScalar, typename DstScalar,
           typename MulParamsType>
 void Mul(const Matrix<LhsScalar>& lhs, const Matrix<RhsScalar>& rhs,
@@ -101,6 +106,131 @@ void Mul(const Matrix<LhsScalar>& lhs, const Matrix<RhsScalar>& rhs,
       internal_lhs, internal_rhs, mul_params, get_ctx(context), &internal_dst);
 }
 
+// Fused gated linear unit, as found in the feed-forward layers of transformer
+// models (GLU, SwiGLU, GeGLU...). Computes
+//
+//   dst = activation(gate * rhs) * (lhs * rhs)    // elementwise product
+//
+// where the activation is mul_params.gate_activation(), without materializing
+// either of the two matrix products. `gate` and `lhs` must have the same shape.
+// The RHS is packed only once, and the gate is packed along with the LHS.
+//
+// Only floating-point types are supported, without bias. The clamp bounds of
+// mul_params apply to the gated product. Both products are computed by the
+// kernels of the selected path, a few kernel blocks at a time.
+template <typename LhsScalar, typename RhsScalar, typename DstScalar,
+          typename MulParamsType>
+void GatedMul(const Matrix<LhsScalar>& gate, const Matrix<LhsScalar>& lhs,
+              const Matrix<RhsScalar>& rhs, const MulParamsType& mul_params,
+              Context* context, Matrix<DstScalar>* dst) {
+  Mat<LhsScalar> internal_gate = ToInternal(gate);
+  Mat<LhsScalar> internal_lhs = ToInternal(lhs);
+  Mat<RhsScalar> internal_rhs = ToInternal(rhs);
+  Mat<DstScalar> internal_dst = ToInternal(*dst);
+  DispatchGatedMul<ruy::kDefaultPaths, LhsScalar, RhsScalar, DstScalar,
+                   MulParamsType>(internal_gate, internal_lhs, internal_rhs,
+                                  mul_params, get_ctx(context), &internal_dst);
+}
+
+// Grouped matrix multiplication, as in Mixture-of-Experts layers where each
+// column of the RHS (a token) is routed to some of the groups (experts), each
+// with its own LHS (weights). For each group g in [0, num_groups), computes
+//
+//   dst[:, begin:end] = lhs[g] * rhs[:, rhs_col_indices[begin:end]]
+//
+// with mul_params[g], where begin = group_offsets[g] and
+// end = group_offsets[g + 1], group_offsets having num_groups + 1 values,
+// starting at 0 and ending at the number of columns of dst. That is, the
+// columns of dst correspond one-to-one to the entries of rhs_col_indices, which
+// lists the columns of the RHS routed to each group, group after group.
+//
+// The RHS is packed only once, and each group gathers its columns from that
+// packed RHS. The blocks of all groups are shared among the threads in a single
+// dispatch to the thread pool, so that groups with few columns still use all
+// threads. Combining the results of each column of the RHS, e.g. with routing
+// weights, is left to the caller.
+//
+// All lhs[g] must have as many rows as dst. They may be cached (see
+// Matrix::set_cache_policy), in which case the PrepackedCache of the Context
+// must be able to hold the packed forms of all of them at once.
+template <typename LhsScalar, typename RhsScalar, typename DstScalar,
+          typename MulParamsType>
+void GroupedMul(int num_groups, const Matrix<LhsScalar>* lhs,
+                const Matrix<RhsScalar>& rhs, const int* group_offsets,
+                const int* rhs_col_indices, const MulParamsType* mul_params,
+                Context* context, Matrix<DstScalar>* dst) {
+  Ctx* ctx = get_ctx(context);
+  Mat<LhsScalar>* internal_lhs;
+  ctx->GetMainAllocator()->Allocate(num_groups, &internal_lhs);
+  for (int g = 0; g < num_groups; g++) {
+    internal_lhs[g] = ToInternal(lhs[g]);
+  }
+  Mat<RhsScalar> internal_rhs = ToInternal(rhs);
+  Mat<DstScalar> internal_dst = ToInternal(*dst);
+  DispatchGroupedMul<ruy::kDefaultPaths, LhsScalar, RhsScalar, DstScalar,
+                     MulParamsType>(num_groups, internal_lhs, internal_rhs,
+                                    group_offsets, rhs_col_indices, mul_params,
+                                    ctx, &internal_dst);
+}
+
+// Chained matrix multiplication, as in a sequence of layers where each layer's
+// output is the next layer's input. Computes
+//
+//   dst[0] = lhs[0] * rhs
+//   dst[i] = lhs[i] * dst[i - 1]  for i in [1, num_muls)
+//
+// with mul_params[i]. All dst[i] have as many columns as rhs, and are the
+// same type as rhs. Unlike num_muls separate Muls, which each wait for all
+// threads to be done before returning, this runs all Muls in a single dispatch
+// to the thread pool: each thread moves on to blocks of the next Mul as soon
+// as the columns of dst[i - 1] that they use are computed.
+//
+// Selecting rows or columns (MulParams::set_lhs_row_indices and
+// set_rhs_col_indices) and DstMask are not supported.
+template <typename LhsScalar, typename Scalar, typename MulParamsType>
+void ChainedMul(int num_muls, const Matrix<LhsScalar>* lhs,
+                const Matrix<Scalar>& rhs, const MulParamsType* mul_params,
+                Context* context, Matrix<Scalar>* dst) {
+  Ctx* ctx = get_ctx(context);
+  Mat<LhsScalar>* internal_lhs;
+  ctx->GetMainAllocator()->Allocate(num_muls, &internal_lhs);
+  Mat<Scalar>* internal_dst;
+  ctx->GetMainAllocator()->Allocate(num_muls, &internal_dst);
+  for (int i = 0; i < num_muls; i++) {
+    internal_lhs[i] = ToInternal(lhs[i]);
+    internal_dst[i] = ToInternal(dst[i]);
+  }
+  Mat<Scalar> internal_rhs = ToInternal(rhs);
+  DispatchChainedMul<ruy::kDefaultPaths, LhsScalar, Scalar, MulParamsType>(
+      num_muls, internal_lhs, internal_rhs, mul_params, ctx, internal_dst);
+}
+
+// Multiplies complex matrices: dst = lhs * rhs + bias, where bias, if not
+// null, has one value per row of dst. Scalar may be float or double.
+//
+// This uses the real kernels on the real matrices of twice the dimensions
+// obtained by expanding each complex value x + iy of the LHS into the 2x2
+// block [x -y; y x], and each complex value of the RHS and dst into the 2x1
+// block [x; y]. That is the 4M algorithm (4 real multiplications per complex
+// one), in a single TrMul: the expanded LHS and RHS are packed directly from
+// their complex forms, with the usual caching (see Matrix::set_cache_policy),
+// and a column-major dst is written in place by the regular kernels, as its
+// memory layout is that of the expanded real dst. There is no combining pass.
+//
+// A bias is not supported with a row-major dst.
+template <typename Scalar>
+void ComplexMul(const Matrix<std::complex<Scalar>>& lhs,
+                const Matrix<std::complex<Scalar>>& rhs,
+                const std::complex<Scalar>* bias, Context* context,
+                Matrix<std::complex<Scalar>>* dst) {
+  Ctx* ctx = get_ctx(context);
+  Mat<std::complex<Scalar>> internal_lhs = ToInternal(lhs);
+  Mat<std::complex<Scalar>> internal_rhs = ToInternal(rhs);
+  Mat<std::complex<Scalar>> internal_dst = ToInternal(*dst);
+  DispatchComplexMul<ruy::kDefaultPaths>(internal_lhs, internal_rhs, bias,
+                                         ctx, &internal_dst);
+}
+
 }  // namespace ruy
 
 #endif  // RUY_RUY_RUY_H_
@@ -0,0 +1,235 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Strassen's recursive matrix multiplication, for MulParams::strassen_cutoff.
+//
+// Each level of recursion splits the LHS, RHS and destination in 2x2 blocks,
+// and computes the destination blocks from 7 products of sums of blocks,
+// instead of the 8 block products of the classical algorithm. Blocks are split
+// at the rounded-up half of each dimension, the other blocks being implicitly
+// padded with zeros, so that all products at a given depth of the recursion
+// have the same shape and share the same temporary buffers. Products at the
+// last level, the leaves, are computed by a caller-provided function, which
+// runs the regular ruy kernels.
+
+#ifndef RUY_RUY_STRASSEN_H_
+#define RUY_RUY_STRASSEN_H_
+
+#include <algorithm>
+
+#include "ruy/allocator.h"
+#include "ruy/check_macros.h"
+#include "ruy/mat.h"
+#include "ruy/matrix.h"
+#include "ruy/profiler/instrumentation.h"
+
+namespace ruy {
+
+// Returns the number of levels of recursion for the given shape, halving
+// all dimensions at each level for as long as they all exceed `cutoff`.
+inline int NumStrassenLevels(int rows, int depth, int cols, int cutoff) {
+  int num_levels = 0;
+  while (std::min(std::min(rows, depth), cols) > cutoff) {
+    rows = (rows + 1) / 2;
+    depth = (depth + 1) / 2;
+    cols = (cols + 1) / 2;
+    num_levels++;
+  }
+  return num_levels;
+}
+
+// Returns a view of the given block of `mat`. Views are never cached, as the
+// PrepackedCache would otherwise hold packed forms of arbitrary blocks.
+template <typename Scalar>
+Mat<Scalar> StrassenBlock(const Mat<Scalar>& mat, int start_row,
+                          int start_col, int rows, int cols) {
+  Mat<Scalar> block = mat;
+  block.data.set(ElementPtr(mat, start_row, start_col));
+  block.layout.rows = rows;
+  block.layout.cols = cols;
+  block.cache_policy = CachePolicy::kNeverCache;
+  return block;
+}
+
+template <typename Scalar>
+Mat<Scalar> StrassenBlock(Mat<Scalar>* mat, int start_row, int start_col,
+                          int rows, int cols) {
+  Mat<Scalar> block = *mat;
+  block.data.set(ElementPtr(mat, start_row, start_col));
+  block.layout.rows = rows;
+  block.layout.cols = cols;
+  block.cache_policy = CachePolicy::kNeverCache;
+  return block;
+}
+
+// Sets `dst` to x + y_coeff * y, where x and y (which may be null) may be
+// smaller than `dst`, and are then padded with zeros.
+template <typename Scalar>
+void StrassenAdd(const Mat<Scalar>& x, const Mat<Scalar>* y, Scalar y_coeff,
+                 Mat<Scalar>* dst) {
+  for (int col = 0; col < dst->layout.cols; col++) {
+    for (int row = 0; row < dst->layout.rows; row++) {
+      Scalar val = 0;
+      if (row < x.layout.rows && col < x.layout.cols) {
+        val = Element(x, row, col);
+      }
+      if (y && row < y->layout.rows && col < y->layout.cols) {
+        val += y_coeff * Element(*y, row, col);
+      }
+      *ElementPtr(dst, row, col) = val;
+    }
+  }
+}
+
+// Adds coeff * src to `dst`, which may be smaller than `src`.
+template <typename Scalar>
+void StrassenAccumulate(const Mat<Scalar>& src, Scalar coeff,
+                        Mat<Scalar>* dst) {
+  for (int col = 0; col < dst->layout.cols; col++) {
+    for (int row = 0; row < dst->layout.rows; row++) {
+      *ElementPtr(dst, row, col) += coeff * Element(src, row, col);
+    }
+  }
+}
+
+// Temporary buffers for one depth of the recursion: the two sums of blocks
+// to multiply, and their product.
+template <typename Scalar>
+struct StrassenLevel final {
+  Mat<Scalar> lhs_sum;
+  Mat<Scalar> rhs_sum;
+  Mat<Scalar> product;
+};
+
+template <typename Scalar, typename LeafMulFn>
+void StrassenMulRecursive(const Mat<Scalar>& lhs, const Mat<Scalar>& rhs,
+                          StrassenLevel<Scalar>* levels, int num_levels,
+                          const LeafMulFn& leaf_mul, Mat<Scalar>* dst) {
+  if (num_levels == 0) {
+    leaf_mul(lhs, rhs, dst);
+    return;
+  }
+  const int rows = lhs.layout.rows;
+  const int depth = lhs.layout.cols;
+  const int cols = rhs.layout.cols;
+  const int r0 = (rows + 1) / 2;
+  const int d0 = (depth + 1) / 2;
+  const int c0 = (cols + 1) / 2;
+  const Mat<Scalar> a11 = StrassenBlock(lhs, 0, 0, r0, d0);
+  const Mat<Scalar> a12 = StrassenBlock(lhs, 0, d0, r0, depth - d0);
+  const Mat<Scalar> a21 = StrassenBlock(lhs, r0, 0, rows - r0, d0);
+  const Mat<Scalar> a22 = StrassenBlock(lhs, r0, d0, rows - r0, depth - d0);
+  const Mat<Scalar> b11 = StrassenBlock(rhs, 0, 0, d0, c0);
+  const Mat<Scalar> b12 = StrassenBlock(rhs, 0, c0, d0, cols - c0);
+  const Mat<Scalar> b21 = StrassenBlock(rhs, d0, 0, depth - d0, c0);
+  const Mat<Scalar> b22 = StrassenBlock(rhs, d0, c0, depth - d0, cols - c0);
+  Mat<Scalar> c11 = StrassenBlock(dst, 0, 0, r0, c0);
+  Mat<Scalar> c12 = StrassenBlock(dst, 0, c0, r0, cols - c0);
+  Mat<Scalar> c21 = StrassenBlock(dst, r0, 0, rows - r0, c0);
+  Mat<Scalar> c22 = StrassenBlock(dst, r0, c0, rows - r0, cols - c0);
+  for (Mat<Scalar>* block : {&c11, &c12, &c21, &c22}) {
+    for (int col = 0; col < block->layout.cols; col++) {
+      for (int row = 0; row < block->layout.rows; row++) {
+        *ElementPtr(block, row, col) = 0;
+      }
+    }
+  }
+
+  StrassenLevel<Scalar>* level = levels;
+  Mat<Scalar>* lhs_sum = &level->lhs_sum;
+  Mat<Scalar>* rhs_sum = &level->rhs_sum;
+  const Mat<Scalar>& product = level->product;
+  const auto multiply = [&](const Mat<Scalar>& x, const Mat<Scalar>& y) {
+    StrassenMulRecursive(x, y, levels + 1, num_levels - 1, leaf_mul,
+                         &level->product);
+  };
+  // M1 = (A11 + A22) (B11 + B22)
+  StrassenAdd<Scalar>(a11, &a22, 1, lhs_sum);
+  StrassenAdd<Scalar>(b11, &b22, 1, rhs_sum);
+  multiply(*lhs_sum, *rhs_sum);
+  StrassenAccumulate<Scalar>(product, 1, &c11);
+  StrassenAccumulate<Scalar>(product, 1, &c22);
+  // M2 = (A21 + A22) B11
+  StrassenAdd<Scalar>(a21, &a22, 1, lhs_sum);
+  multiply(*lhs_sum, b11);
+  StrassenAccumulate<Scalar>(product, 1, &c21);
+  StrassenAccumulate<Scalar>(product, -1, &c22);
+  // M3 = A11 (B12 - B22)
+  StrassenAdd<Scalar>(b12, &b22, -1, rhs_sum);
+  multiply(a11, *rhs_sum);
+  StrassenAccumulate<Scalar>(product, 1, &c12);
+  StrassenAccumulate<Scalar>(product, 1, &c22);
+  // M4 = A22 (B21 - B11)
+  StrassenAdd<Scalar>(a22, nullptr, 0, lhs_sum);
+  StrassenAdd<Scalar>(b21, &b11, -1, rhs_sum);
+  multiply(*lhs_sum, *rhs_sum);
+  StrassenAccumulate<Scalar>(product, 1, &c11);
+  StrassenAccumulate<Scalar>(product, 1, &c21);
+  // M5 = (A11 + A12) B22
+  StrassenAdd<Scalar>(a11, &a12, 1, lhs_sum);
+  StrassenAdd<Scalar>(b22, nullptr, 0, rhs_sum);
+  multiply(*lhs_sum, *rhs_sum);
+  StrassenAccumulate<Scalar>(product, -1, &c11);
+  StrassenAccumulate<Scalar>(product, 1, &c12);
+  // M6 = (A21 - A11) (B11 + B12)
+  StrassenAdd<Scalar>(a21, &a11, -1, lhs_sum);
+  StrassenAdd<Scalar>(b11, &b12, 1, rhs_sum);
+  multiply(*lhs_sum, *rhs_sum);
+  StrassenAccumulate<Scalar>(product, 1, &c22);
+  // M7 = (A12 - A22) (B21 + B22)
+  StrassenAdd<Scalar>(a12, &a22, -1, lhs_sum);
+  StrassenAdd<Scalar>(b21, &b22, 1, rhs_sum);
+  multiply(*lhs_sum, *rhs_sum);
+  StrassenAccumulate<Scalar>(product, 1, &c11);
+}
+
+// Computes dst = lhs * rhs with Strassen's algorithm, recursing for as long
+// as all dimensions exceed `cutoff`, see NumStrassenLevels. Products at the
+// leaves are computed by leaf_mul(lhs, rhs, dst), for column-major `dst`.
+template <typename Scalar, typename LeafMulFn>
+void StrassenMul(const Mat<Scalar>& lhs, const Mat<Scalar>& rhs, int cutoff,
+                 const LeafMulFn& leaf_mul, Mat<Scalar>* dst) {
+  profiler::ScopeLabel label("Strassen");
+  RUY_DCHECK_GT(cutoff, 0);
+  int rows = lhs.layout.rows;
+  int depth = lhs.layout.cols;
+  int cols = rhs.layout.cols;
+  const int num_levels = NumStrassenLevels(rows, depth, cols, cutoff);
+  // Dimensions are int32, so they can't be halved more times than this.
+  StrassenLevel<Scalar> levels[32];
+  Allocator allocator;
+  for (int l = 0; l < num_levels; l++) {
+    rows = (rows + 1) / 2;
+    depth = (depth + 1) / 2;
+    cols = (cols + 1) / 2;
+    const int shapes[3][2] = {{rows, depth}, {depth, cols}, {rows, cols}};
+    Mat<Scalar>* mats[3] = {&levels[l].lhs_sum, &levels[l].rhs_sum,
+                            &levels[l].product};
+    for (int m = 0; m < 3; m++) {
+      Scalar* data;
+      allocator.Allocate(shapes[m][0] * shapes[m][1], &data);
+      mats[m]->data.set(data);
+      mats[m]->layout.rows = shapes[m][0];
+      mats[m]->layout.cols = shapes[m][1];
+      mats[m]->layout.stride = shapes[m][0];
+      mats[m]->layout.order = Order::kColMajor;
+    }
+  }
+  StrassenMulRecursive(lhs, rhs, levels, num_levels, leaf_mul, dst);
+}
+
+}  // namespace ruy
+
+#endif  // RUY_RUY_STRASSEN_H_
@@ -19,6 +19,7 @@ limitations under the License.
 #include <math.h>
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -579,6 +580,8 @@ struct TestSet final {
 
   std::vector<AccumScalar> per_channel_multiplier_fixedpoint;
   std::vector<int> per_channel_multiplier_exponent;
+  std::vector<float> per_channel_multiplier_float;
+  std::vector<AccumScalar> per_channel_lhs_zero_point;
 
   StorageMatrix<LhsScalar> lhs;
   StorageMatrix<RhsScalar> rhs;
@@ -591,6 +594,8 @@ struct TestSet final {
 
   bool benchmark = false;
   bool perchannel = false;
+  bool perchannel_lhs_zero_point = false;
+  bool use_multiplier_float = false;
   int max_num_threads = 0;
 
   bool cache_lhs = false;
@@ -1478,6 +1483,21 @@ void SwitchMultiplierToPerChannel(TestSetType* test_set) {
   test_set->mul_params.set_multiplier_exponent(0);
 }
 
+template <typename TestSetType>
+void SwitchMultiplierFloatToPerChannel(TestSetType* test_set) {
+  test_set->per_channel_multiplier_float.resize(test_set->rows);
+  for (int i = 0; i < test_set->rows; i++) {
+    // Scale each channel by a random factor in [1/2, 2].
+    const int nudge = global_random_engine()() % 1024;
+    test_set->per_channel_multiplier_float[i] =
+        test_set->mul_params.multiplier_float() *
+        std::exp2((nudge - 512) / 512.f);
+  }
+  test_set->mul_params.set_multiplier_float_perchannel(
+      test_set->per_channel_multiplier_float.data());
+  test_set->mul_params.set_multiplier_float(0);
+}
+
 template <
     typename TestSetType,
     bool IsApplicable =
@@ -1491,6 +1511,16 @@ struct MakeSpecMultiplierFieldsImpl<TestSetType, true> {
     double multiplier;
     ComputeReasonableMultiplier<TestSetType>(test_set->lhs.matrix,
                                              test_set->rhs.matrix, &multiplier);
+    if (test_set->use_multiplier_float) {
+      test_set->mul_params.set_multiplier_float(static_cast<float>(multiplier));
+      if (!test_set->benchmark) {
+        test_set->perchannel = global_random_engine()() & 1;
+      }
+      if (test_set->perchannel) {
+        SwitchMultiplierFloatToPerChannel(test_set);
+      }
+      return;
+    }
     typename TestSetType::AccumScalar multiplier_fixedpoint;
     int multiplier_exponent;
     QuantizeMultiplier(multiplier, &multiplier_fixedpoint,
@@ -1591,6 +1621,19 @@ void TestSet<LhsScalar, RhsScalar, SpecType>::MakeMulParams() {
       rhs.matrix.zero_point() == std::numeric_limits<RhsScalar>::lowest()) {
     lhs.matrix.set_zero_point(lhs.matrix.zero_point() + 1);
   }
+  if (perchannel_lhs_zero_point) {
+    RUY_CHECK(!std::is_floating_point<LhsScalar>::value);
+    // Per-channel zero points are expressed relative to the LHS matrix's
+    // zero_point, see MulParams::lhs_zero_point_perchannel.
+    per_channel_lhs_zero_point.resize(rows);
+    for (int i = 0; i < rows; i++) {
+      LhsScalar zero_point;
+      MakeRandomScalar(RandomRange::kReasonableSrcZeroPoint, &zero_point);
+      per_channel_lhs_zero_point[i] =
+          static_cast<AccumScalar>(zero_point) - lhs.matrix.zero_point();
+    }
+    mul_params.set_lhs_zero_point_perchannel(per_channel_lhs_zero_point.data());
+  }
   MakeSpecMultiplierFieldsImpl<TestSet>::Run(this);
   MakeSpecClampFields(&mul_params);
   life_stage = LifeStage::kHasMulParams;
@@ -1691,9 +1734,11 @@ void TestSet<LhsScalar, RhsScalar, SpecType>::MakeResultPaths() {
     if (SupportsGemmlowp<TestSetType>::kValue) {
 #ifdef GEMMLOWP_SSE4
       const bool gemmlowp_supported =
-          !mul_params.multiplier_fixedpoint_perchannel();
+          !mul_params.multiplier_fixedpoint_perchannel() &&
+          !mul_params.lhs_zero_point_perchannel() && !use_multiplier_float;
 #else
-      const bool gemmlowp_supported = true;
+      const bool gemmlowp_supported =
+          !mul_params.lhs_zero_point_perchannel() && !use_multiplier_float;
 #endif
       if (gemmlowp_supported) {
         external_paths.push_back(ExternalPath::kGemmlowp);
@@ -15,6 +15,9 @@ limitations under the License.
 
 // This test contains cheap test cases, completes in a few seconds.
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
 #include <vector>
 
 #include "ruy/test.h"
@@ -107,4 +110,1249 @@ TEST(RuyTest, TestGEMV) {
   TestLinearAllOrders<TestSetType>(8193, 17, 1);
 }
 
+TEST(RuyTest, TestPerChannelLhsZeroPoint) {
+  if (std::is_floating_point<LhsScalar>::value) {
+    return;
+  }
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {40, 65, 33}, {100, 16, 1}};
+  for (const auto& shape : shapes) {
+    for (Order lhs_order : {Order::kRowMajor, Order::kColMajor}) {
+      TestSetType test_set;
+      test_set.rows = shape[0];
+      test_set.depth = shape[1];
+      test_set.cols = shape[2];
+      test_set.lhs_order = lhs_order;
+      test_set.rhs_order = Order::kColMajor;
+      test_set.dst_order = Order::kColMajor;
+      test_set.layout_style = LayoutStyle::kLinear;
+      test_set.perchannel_lhs_zero_point = true;
+      test_set.Run();
+    }
+  }
+}
+
+TEST(RuyTest, TestMultiplierFloat) {
+  if (std::is_floating_point<AccumScalar>::value ||
+      std::is_same<DstScalar, std::int32_t>::value) {
+    return;
+  }
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {40, 65, 33}, {100, 16, 1}};
+  for (const auto& shape : shapes) {
+    for (Order lhs_order : {Order::kRowMajor, Order::kColMajor}) {
+      TestSetType test_set;
+      test_set.rows = shape[0];
+      test_set.depth = shape[1];
+      test_set.cols = shape[2];
+      test_set.lhs_order = lhs_order;
+      test_set.rhs_order = Order::kColMajor;
+      test_set.dst_order = Order::kColMajor;
+      test_set.layout_style = LayoutStyle::kLinear;
+      test_set.use_multiplier_float = true;
+      test_set.Run();
+    }
+  }
+}
+
+// Checks that float multipliers saturate, rather than overflow, when the
+// destination zero point is added to scaled accumulators beyond the int16
+// range, on every enabled path.
+TEST(RuyTest, TestMultiplierFloatSaturation) {
+  const int depth = 64;
+  std::vector<std::int8_t> lhs_data(2 * depth);
+  for (int k = 0; k < depth; k++) {
+    lhs_data[2 * k] = 127;
+    lhs_data[2 * k + 1] = -127;
+  }
+  std::vector<std::int8_t> rhs_data(depth, 127);
+  Matrix<std::int8_t> lhs;
+  MakeSimpleLayout(2, depth, Order::kColMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<std::int8_t> rhs;
+  MakeSimpleLayout(depth, 1, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  std::int16_t dst_data[2];
+  Matrix<std::int16_t> dst;
+  MakeSimpleLayout(2, 1, Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data);
+  dst.set_zero_point(1000);
+  MulParams<std::int32_t, std::int16_t> mul_params;
+  // Scales the accumulators of +/-2^20 to about +/-2^33.
+  mul_params.set_multiplier_float(8192.f);
+
+  Context context;
+  Ctx* ctx = get_ctx(&context);
+  for (Path path : PathsBitfieldAsVector(ctx->GetRuntimeEnabledPaths())) {
+    ctx->SetRuntimeEnabledPaths(path);
+    Mul<kAllPaths>(lhs, rhs, mul_params, &context, &dst);
+    EXPECT_EQ(dst_data[0], 32767);
+    EXPECT_EQ(dst_data[1], -32768);
+  }
+}
+
+// Runs a Mul into a row-major destination, which ruy performs with swapped
+// operands, on every enabled path. Checks that the bias and per-channel
+// multipliers still apply along destination rows, and that each path runs its
+// own kernel rather than falling back to Path::kStandardCpp.
+template <typename Scalar, typename AccumScalar, typename DstScalar>
+void TestRowMajorDstChannelParams(
+    const MulParams<AccumScalar, DstScalar>& mul_params, int rows, int depth,
+    int cols) {
+  std::vector<Scalar> lhs_data;
+  std::vector<Scalar> rhs_data;
+  MakeRandomVector(RandomRange::kOffCenterAvoidMinValue, rows * depth,
+                   &lhs_data);
+  MakeRandomVector(RandomRange::kOffCenterAvoidMinValue, depth * cols,
+                   &rhs_data);
+  // With swapped operands, the optimized paths want a row-major LHS, as they
+  // do a column-major RHS.
+  Matrix<Scalar> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<Scalar> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  std::vector<DstScalar> expected_data(rows * cols);
+  std::vector<DstScalar> dst_data(rows * cols);
+  Matrix<DstScalar> dst;
+  MakeSimpleLayout(rows, cols, Order::kRowMajor, dst.mutable_layout());
+
+  Context context;
+  Ctx* ctx = get_ctx(&context);
+  const Path enabled_paths = ctx->GetRuntimeEnabledPaths();
+  ctx->SetRuntimeEnabledPaths(Path::kStandardCpp);
+  dst.set_data(expected_data.data());
+  Mul<kAllPaths>(lhs, rhs, mul_params, &context, &dst);
+  dst.set_data(dst_data.data());
+  for (Path path : PathsBitfieldAsVector(enabled_paths)) {
+    ctx->SetRuntimeEnabledPaths(path);
+    Mul<kAllPaths>(lhs, rhs, mul_params, &context, &dst);
+#if !RUY_PLATFORM_ARM
+    // The ARM kernels do not support per-column parameters yet.
+    EXPECT_EQ(ctx->last_trmul_path(), path);
+#endif
+    for (int i = 0; i < rows * cols; i++) {
+      EXPECT_NEAR(dst_data[i], expected_data[i],
+                  1e-4 * std::abs(expected_data[i]) + 1e-4);
+    }
+  }
+}
+
+TEST(RuyTest, TestRowMajorDstChannelParams) {
+  const int rows = 11;
+  const int depth = 20;
+  const int cols = 19;
+  std::vector<float> float_bias;
+  MakeRandomVector(RandomRange::kBias, rows, &float_bias);
+  MulParams<float, float> float_mul_params;
+  float_mul_params.set_bias(float_bias.data());
+  TestRowMajorDstChannelParams<float>(float_mul_params, rows, depth, cols);
+
+  std::vector<std::int32_t> bias;
+  MakeRandomVector(RandomRange::kBias, rows, &bias);
+  std::vector<std::int32_t> multiplier_fixedpoint(rows);
+  std::vector<int> multiplier_exponent(rows);
+  std::vector<float> multiplier_float(rows);
+  for (int i = 0; i < rows; i++) {
+    multiplier_fixedpoint[i] = (1 << 30) + (i << 24);
+    multiplier_exponent[i] = -10 - i % 3;
+    multiplier_float[i] = (1 + i % 5) / 8192.f;
+  }
+  MulParams<std::int32_t, std::int8_t> mul_params;
+  mul_params.set_bias(bias.data());
+  mul_params.set_multiplier_fixedpoint_perchannel(
+      multiplier_fixedpoint.data());
+  mul_params.set_multiplier_exponent_perchannel(multiplier_exponent.data());
+  TestRowMajorDstChannelParams<std::int8_t>(mul_params, rows, depth, cols);
+  mul_params.set_multiplier_fixedpoint_perchannel(nullptr);
+  mul_params.set_multiplier_exponent_perchannel(nullptr);
+  mul_params.set_multiplier_float_perchannel(multiplier_float.data());
+  TestRowMajorDstChannelParams<std::int8_t>(mul_params, rows, depth, cols);
+}
+
+// How the LHS scales are specified in TestDynamicQuantization.
+enum class LhsScaleStyle { kPerTensor, kPerChannel, kGroupWise };
+
+// Dynamic quantization: a quantized LHS times a float RHS, which ruy quantizes
+// per-column while packing. Compares against the float product, within the
+// error bound implied by rounding the RHS to its scale.
+template <typename WeightScalar>
+void TestDynamicQuantization(int rows, int depth, int cols, Order lhs_order,
+                             LhsScaleStyle lhs_scale_style) {
+  // Small enough to have several groups, and a partial one, in most shapes.
+  static constexpr int kGroupSize = 4;
+  Context context;
+  std::vector<WeightScalar> lhs_data;
+  std::vector<float> rhs_data;
+  MakeRandomVector(RandomRange::kOffCenterAvoidMinValue, rows * depth,
+                   &lhs_data);
+  MakeRandomVector(RandomRange::kGeneral, depth * cols, &rhs_data);
+  WeightScalar lhs_zero_point;
+  MakeRandomScalar(RandomRange::kReasonableSrcZeroPoint, &lhs_zero_point);
+  const int num_groups = (depth + kGroupSize - 1) / kGroupSize;
+  std::vector<float> lhs_scales(rows * num_groups);
+  for (int i = 0; i < rows * num_groups; i++) {
+    lhs_scales[i] = 0.01f * (1 + i % 7);
+  }
+  // Returns the scale of the LHS element at row i, depth k.
+  auto lhs_scale = [&](int i, int k) {
+    switch (lhs_scale_style) {
+      case LhsScaleStyle::kPerTensor:
+        return lhs_scales[0];
+      case LhsScaleStyle::kPerChannel:
+        return lhs_scales[i];
+      default:
+        return lhs_scales[(k / kGroupSize) * rows + i];
+    }
+  };
+
+  Matrix<WeightScalar> lhs;
+  MakeSimpleLayout(rows, depth, lhs_order, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  lhs.set_zero_point(lhs_zero_point);
+  Matrix<float> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  std::vector<float> dst_data(rows * cols);
+  Matrix<float> dst;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  MulParams<std::int32_t, float> mul_params;
+  switch (lhs_scale_style) {
+    case LhsScaleStyle::kPerTensor:
+      mul_params.set_multiplier_float(lhs_scales[0]);
+      break;
+    case LhsScaleStyle::kPerChannel:
+      mul_params.set_multiplier_float_perchannel(lhs_scales.data());
+      break;
+    case LhsScaleStyle::kGroupWise:
+      mul_params.set_lhs_group_scales(lhs_scales.data());
+      mul_params.set_lhs_group_size(kGroupSize);
+      break;
+  }
+  std::vector<double> expected(rows * cols);
+  std::vector<double> tolerance(rows * cols);
+  for (int j = 0; j < cols; j++) {
+    float max_abs = 0;
+    for (int k = 0; k < depth; k++) {
+      max_abs = std::max(max_abs, std::abs(rhs_data[k + j * depth]));
+    }
+    const float rhs_scale = max_abs / 127;
+    for (int i = 0; i < rows; i++) {
+      double sum_abs_lhs = 0;
+      for (int k = 0; k < depth; k++) {
+        const int lhs_index =
+            lhs_order == Order::kColMajor ? i + k * rows : k + i * depth;
+        const double lhs_val =
+            (static_cast<double>(lhs_data[lhs_index]) - lhs_zero_point) *
+            lhs_scale(i, k);
+        expected[i + j * rows] += lhs_val * rhs_data[k + j * depth];
+        sum_abs_lhs += std::abs(lhs_val);
+      }
+      // Each RHS value is off by at most half of rhs_scale once quantized. The
+      // second term accounts for float rounding.
+      tolerance[i + j * rows] =
+          sum_abs_lhs * (0.5 * rhs_scale + 1e-5 * max_abs);
+    }
+  }
+
+  Ctx* ctx = get_ctx(&context);
+  for (Path path : PathsBitfieldAsVector(ctx->GetRuntimeEnabledPaths())) {
+    ctx->SetRuntimeEnabledPaths(path);
+    Mul<kAllPaths>(lhs, rhs, mul_params, &context, &dst);
+    // With a row-major LHS, the optimized paths run their own kernels, except
+    // for group-wise scales.
+    if (lhs_order == Order::kRowMajor &&
+        lhs_scale_style != LhsScaleStyle::kGroupWise) {
+      EXPECT_EQ(ctx->last_trmul_path(), path);
+    }
+    for (int i = 0; i < rows * cols; i++) {
+      EXPECT_NEAR(dst_data[i], expected[i], tolerance[i]);
+    }
+  }
+}
+
+TEST(RuyTest, TestDynamicQuantization) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {40, 65, 33}, {100, 16, 1}};
+  for (const auto& shape : shapes) {
+    for (Order lhs_order : {Order::kRowMajor, Order::kColMajor}) {
+      for (LhsScaleStyle lhs_scale_style :
+           {LhsScaleStyle::kPerTensor, LhsScaleStyle::kPerChannel,
+            LhsScaleStyle::kGroupWise}) {
+        TestDynamicQuantization<std::int8_t>(shape[0], shape[1], shape[2],
+                                             lhs_order, lhs_scale_style);
+        TestDynamicQuantization<std::uint8_t>(shape[0], shape[1], shape[2],
+                                              lhs_order, lhs_scale_style);
+      }
+    }
+  }
+}
+
+// Compares GatedMul against a double-precision reference.
+void TestGatedMul(int rows, int depth, int cols, Order lhs_order,
+                  GateActivation activation) {
+  Context context;
+  context.set_max_num_threads(4);
+  std::vector<float> gate_data;
+  std::vector<float> lhs_data;
+  std::vector<float> rhs_data;
+  MakeRandomVector(RandomRange::kGeneral, rows * depth, &gate_data);
+  MakeRandomVector(RandomRange::kGeneral, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kGeneral, depth * cols, &rhs_data);
+
+  Matrix<float> gate;
+  MakeSimpleLayout(rows, depth, lhs_order, gate.mutable_layout());
+  gate.set_data(gate_data.data());
+  Matrix<float> lhs;
+  MakeSimpleLayout(rows, depth, lhs_order, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<float> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  std::vector<float> dst_data(rows * cols);
+  Matrix<float> dst;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  MulParams<float, float> mul_params;
+  mul_params.set_gate_activation(activation);
+  GatedMul(gate, lhs, rhs, mul_params, &context, &dst);
+  // With a row-major LHS, whose transpose is column-major, the gated product
+  // runs on the selected path rather than falling back to Path::kStandardCpp.
+  if (lhs_order == Order::kRowMajor) {
+    const Ctx* ctx = get_ctx(&context);
+    EXPECT_EQ(ctx->last_trmul_path(), ctx->last_used_path());
+  }
+
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      double gate_val = 0;
+      double lhs_val = 0;
+      for (int k = 0; k < depth; k++) {
+        const int lhs_index =
+            lhs_order == Order::kColMajor ? i + k * rows : k + i * depth;
+        gate_val += static_cast<double>(gate_data[lhs_index]) *
+                    rhs_data[k + j * depth];
+        lhs_val += static_cast<double>(lhs_data[lhs_index]) *
+                   rhs_data[k + j * depth];
+      }
+      const double expected =
+          ApplyGateActivation(activation, gate_val) * lhs_val;
+      EXPECT_NEAR(dst_data[i + j * rows], expected,
+                  1e-4 * (1 + std::abs(expected)) * depth);
+    }
+  }
+}
+
+TEST(RuyTest, TestGatedMul) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {40, 65, 33}, {200, 160, 70}};
+  for (const auto& shape : shapes) {
+    for (Order lhs_order : {Order::kRowMajor, Order::kColMajor}) {
+      for (GateActivation activation :
+           {GateActivation::kSigmoid, GateActivation::kSilu,
+            GateActivation::kGelu, GateActivation::kRelu}) {
+        TestGatedMul(shape[0], shape[1], shape[2], lhs_order, activation);
+      }
+    }
+  }
+}
+
+// Checks the reductions of destination values requested through MulParams
+// against reductions computed from the destination matrix.
+template <typename Scalar, typename AccumScalar>
+void TestDstReductions(int rows, int depth, int cols, int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<Scalar> lhs_data;
+  std::vector<Scalar> rhs_data;
+  MakeRandomVector(RandomRange::kAvoidMinValue, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kAvoidMinValue, depth * cols, &rhs_data);
+  Matrix<Scalar> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<Scalar> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  std::vector<Scalar> dst_data(rows * cols);
+  Matrix<Scalar> dst;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+
+  MulParams<AccumScalar, Scalar> mul_params;
+  if (!std::is_floating_point<Scalar>::value) {
+    mul_params.set_multiplier_float(1.f / depth);
+  }
+  std::vector<AccumScalar> row_buffers[kNumDstReductions];
+  std::vector<AccumScalar> col_buffers[kNumDstReductions];
+  for (int r = 0; r < kNumDstReductions; r++) {
+    row_buffers[r].resize(rows);
+    col_buffers[r].resize(cols);
+  }
+  auto set_buffers = [](std::vector<AccumScalar>* buffers,
+                        DstReductions<AccumScalar>* reductions) {
+    reductions->sum = buffers[kDstReductionSum].data();
+    reductions->sum_of_squares = buffers[kDstReductionSumOfSquares].data();
+    reductions->maximum = buffers[kDstReductionMaximum].data();
+    reductions->minimum = buffers[kDstReductionMinimum].data();
+  };
+  set_buffers(row_buffers, mul_params.mutable_row_reductions());
+  set_buffers(col_buffers, mul_params.mutable_col_reductions());
+  Mul(lhs, rhs, mul_params, &context, &dst);
+
+  // Floating-point reductions are accumulated in a different order.
+  const double tolerance =
+      std::is_floating_point<Scalar>::value ? 1e-4 * depth : 0;
+  for (Side side : {Side::kLhs, Side::kRhs}) {
+    const bool is_row = side == Side::kLhs;
+    const int size = is_row ? rows : cols;
+    const int other_size = is_row ? cols : rows;
+    for (int x = 0; x < size; x++) {
+      double sum = 0;
+      double sum_of_squares = 0;
+      double maximum = -std::numeric_limits<double>::infinity();
+      double minimum = std::numeric_limits<double>::infinity();
+      for (int y = 0; y < other_size; y++) {
+        const double val = is_row ? dst_data[x + y * rows]
+                                  : dst_data[y + x * rows];
+        sum += val;
+        sum_of_squares += val * val;
+        maximum = std::max(maximum, val);
+        minimum = std::min(minimum, val);
+      }
+      const auto& buffers = is_row ? row_buffers : col_buffers;
+      EXPECT_NEAR(buffers[kDstReductionSum][x], sum, tolerance);
+      EXPECT_NEAR(buffers[kDstReductionSumOfSquares][x], sum_of_squares,
+                  tolerance * (1 + sum_of_squares));
+      EXPECT_EQ(buffers[kDstReductionMaximum][x], maximum);
+      EXPECT_EQ(buffers[kDstReductionMinimum][x], minimum);
+    }
+  }
+}
+
+TEST(RuyTest, TestDstReductions) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {40, 65, 33}, {300, 100, 200}};
+  for (const auto& shape : shapes) {
+    for (int max_num_threads : {1, 4}) {
+      TestDstReductions<float, float>(shape[0], shape[1], shape[2],
+                                      max_num_threads);
+      TestDstReductions<std::int8_t, std::int32_t>(shape[0], shape[1],
+                                                   shape[2], max_num_threads);
+    }
+  }
+}
+
+// Checks Mul with selected LHS rows and RHS columns against the corresponding
+// rows and columns of the full product.
+template <typename Scalar, typename AccumScalar>
+void TestSelectedRowsAndCols(int rows, int depth, int cols, Order dst_order,
+                             bool select_rows, bool select_cols,
+                             bool cache_lhs) {
+  Context context;
+  context.set_max_num_threads(4);
+  std::vector<Scalar> lhs_data;
+  std::vector<Scalar> rhs_data;
+  MakeRandomVector(RandomRange::kAvoidMinValue, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kAvoidMinValue, depth * cols, &rhs_data);
+  Matrix<Scalar> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  // Selections are meant to reuse the cached packed LHS, but also work when
+  // the selected columns get packed from the source matrix.
+  if (cache_lhs) {
+    lhs.set_cache_policy(CachePolicy::kAlwaysCache);
+  }
+  Matrix<Scalar> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  std::vector<AccumScalar> bias(rows);
+  std::vector<float> multipliers(rows);
+  for (int i = 0; i < rows; i++) {
+    bias[i] = static_cast<AccumScalar>(i % 7) - 3;
+    multipliers[i] = (1 + i % 3) / (4.f * depth);
+  }
+  MulParams<AccumScalar, Scalar> mul_params;
+  mul_params.set_bias(bias.data());
+  if (!std::is_floating_point<Scalar>::value) {
+    mul_params.set_multiplier_float_perchannel(multipliers.data());
+  }
+  std::vector<Scalar> expected_data(rows * cols);
+  Matrix<Scalar> expected;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  Mul(lhs, rhs, mul_params, &context, &expected);
+
+  // Selections in arbitrary order, with duplicates.
+  std::vector<int> row_indices;
+  std::vector<int> col_indices;
+  for (int i = 0; i <= rows / 3; i++) {
+    row_indices.push_back((i * 7 + 3) % rows);
+  }
+  for (int j = 0; j <= cols / 2; j++) {
+    col_indices.push_back(cols - 1 - j * 5 % cols);
+  }
+  const int dst_rows = select_rows ? row_indices.size() : rows;
+  const int dst_cols = select_cols ? col_indices.size() : cols;
+  if (select_rows) {
+    mul_params.set_lhs_row_indices(row_indices.data());
+  }
+  if (select_cols) {
+    mul_params.set_rhs_col_indices(col_indices.data());
+  }
+  std::vector<Scalar> dst_data(dst_rows * dst_cols);
+  Matrix<Scalar> dst;
+  MakeSimpleLayout(dst_rows, dst_cols, dst_order, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  Mul(lhs, rhs, mul_params, &context, &dst);
+
+  for (int i = 0; i < dst_rows; i++) {
+    for (int j = 0; j < dst_cols; j++) {
+      const int row = select_rows ? row_indices[i] : i;
+      const int col = select_cols ? col_indices[j] : j;
+      EXPECT_NEAR(Element(dst, i, j), Element(expected, row, col),
+                  std::is_floating_point<Scalar>::value ? 1e-5 * depth : 0);
+    }
+  }
+}
+
+TEST(RuyTest, TestSelectedRowsAndCols) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {40, 65, 33}, {300, 100, 200}};
+  for (const auto& shape : shapes) {
+    for (Order dst_order : {Order::kColMajor, Order::kRowMajor}) {
+      for (bool select_rows : {false, true}) {
+        for (bool select_cols : {false, true}) {
+          for (bool cache_lhs : {false, true}) {
+            TestSelectedRowsAndCols<float, float>(
+                shape[0], shape[1], shape[2], dst_order, select_rows,
+                select_cols, cache_lhs);
+            TestSelectedRowsAndCols<std::int8_t, std::int32_t>(
+                shape[0], shape[1], shape[2], dst_order, select_rows,
+                select_cols, cache_lhs);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Checks GroupedMul against separate Muls for each group, routing each column
+// of the RHS to two groups, and none to the last group.
+template <typename Scalar, typename AccumScalar>
+void TestGroupedMul(int num_groups, int rows, int depth, int rhs_cols,
+                    bool cache_lhs) {
+  Context context;
+  context.set_max_num_threads(4);
+  std::vector<std::vector<Scalar>> lhs_data(num_groups);
+  std::vector<Matrix<Scalar>> lhs(num_groups);
+  std::vector<std::vector<AccumScalar>> bias(num_groups);
+  std::vector<MulParams<AccumScalar, Scalar>> mul_params(num_groups);
+  for (int g = 0; g < num_groups; g++) {
+    MakeRandomVector(RandomRange::kAvoidMinValue, rows * depth, &lhs_data[g]);
+    MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs[g].mutable_layout());
+    lhs[g].set_data(lhs_data[g].data());
+    if (cache_lhs) {
+      lhs[g].set_cache_policy(CachePolicy::kAlwaysCache);
+    }
+    for (int i = 0; i < rows; i++) {
+      bias[g].push_back(static_cast<AccumScalar>((i + g) % 5) - 2);
+    }
+    mul_params[g].set_bias(bias[g].data());
+    if (!std::is_floating_point<Scalar>::value) {
+      mul_params[g].set_multiplier_float(1.f / depth);
+    }
+  }
+  std::vector<Scalar> rhs_data;
+  MakeRandomVector(RandomRange::kAvoidMinValue, depth * rhs_cols, &rhs_data);
+  Matrix<Scalar> rhs;
+  MakeSimpleLayout(depth, rhs_cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  std::vector<int> group_offsets{0};
+  std::vector<int> rhs_col_indices;
+  for (int g = 0; g < num_groups; g++) {
+    for (int j = 0; j < rhs_cols; j++) {
+      const int first_group = j % (num_groups - 1);
+      const int second_group = (j * 3 + 1) % (num_groups - 1);
+      if (g == first_group || (g == second_group && g != first_group)) {
+        rhs_col_indices.push_back(j);
+      }
+    }
+    group_offsets.push_back(rhs_col_indices.size());
+  }
+  const int dst_cols = rhs_col_indices.size();
+  std::vector<Scalar> dst_data(rows * dst_cols);
+  Matrix<Scalar> dst;
+  MakeSimpleLayout(rows, dst_cols, Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  GroupedMul(num_groups, lhs.data(), rhs, group_offsets.data(),
+             rhs_col_indices.data(), mul_params.data(), &context, &dst);
+
+  for (int g = 0; g < num_groups; g++) {
+    std::vector<Scalar> expected_data(rows * rhs_cols);
+    Matrix<Scalar> expected;
+    MakeSimpleLayout(rows, rhs_cols, Order::kColMajor,
+                     expected.mutable_layout());
+    expected.set_data(expected_data.data());
+    Mul(lhs[g], rhs, mul_params[g], &context, &expected);
+    for (int k = group_offsets[g]; k < group_offsets[g + 1]; k++) {
+      for (int i = 0; i < rows; i++) {
+        EXPECT_NEAR(Element(dst, i, k),
+                    Element(expected, i, rhs_col_indices[k]),
+                    std::is_floating_point<Scalar>::value ? 1e-5 * depth : 0);
+      }
+    }
+  }
+}
+
+TEST(RuyTest, TestGroupedMul) {
+  const int shapes[][4] = {
+      {2, 1, 1, 1}, {3, 5, 7, 3}, {5, 17, 31, 9}, {9, 100, 60, 70}};
+  for (const auto& shape : shapes) {
+    for (bool cache_lhs : {false, true}) {
+      TestGroupedMul<float, float>(shape[0], shape[1], shape[2], shape[3],
+                                   cache_lhs);
+      TestGroupedMul<std::int8_t, std::int32_t>(shape[0], shape[1], shape[2],
+                                                shape[3], cache_lhs);
+    }
+  }
+}
+
+// Checks ChainedMul against separate Muls, for layers of the given sizes:
+// sizes[0] is the depth of the first Mul, and sizes[i + 1] the rows of Mul i.
+template <typename Scalar, typename AccumScalar>
+void TestChainedMul(const std::vector<int>& sizes, int cols,
+                    int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  const int num_muls = sizes.size() - 1;
+  std::vector<std::vector<Scalar>> lhs_data(num_muls);
+  std::vector<Matrix<Scalar>> lhs(num_muls);
+  std::vector<MulParams<AccumScalar, Scalar>> mul_params(num_muls);
+  std::vector<std::vector<Scalar>> dst_data(num_muls);
+  std::vector<Matrix<Scalar>> dst(num_muls);
+  for (int i = 0; i < num_muls; i++) {
+    MakeRandomVector(RandomRange::kAvoidMinValue, sizes[i + 1] * sizes[i],
+                     &lhs_data[i]);
+    MakeSimpleLayout(sizes[i + 1], sizes[i], Order::kRowMajor,
+                     lhs[i].mutable_layout());
+    lhs[i].set_data(lhs_data[i].data());
+    if (!std::is_floating_point<Scalar>::value) {
+      mul_params[i].set_multiplier_float(1.f / sizes[i]);
+    }
+    dst_data[i].resize(sizes[i + 1] * cols);
+    MakeSimpleLayout(sizes[i + 1], cols, Order::kColMajor,
+                     dst[i].mutable_layout());
+    dst[i].set_data(dst_data[i].data());
+  }
+  std::vector<Scalar> rhs_data;
+  MakeRandomVector(RandomRange::kAvoidMinValue, sizes[0] * cols, &rhs_data);
+  Matrix<Scalar> rhs;
+  MakeSimpleLayout(sizes[0], cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  ChainedMul(num_muls, lhs.data(), rhs, mul_params.data(), &context,
+             dst.data());
+
+  std::vector<Scalar> expected_data;
+  std::vector<Scalar> previous_data = rhs_data;
+  for (int i = 0; i < num_muls; i++) {
+    Matrix<Scalar> previous;
+    MakeSimpleLayout(sizes[i], cols, Order::kColMajor,
+                     previous.mutable_layout());
+    previous.set_data(previous_data.data());
+    expected_data.assign(sizes[i + 1] * cols, 0);
+    Matrix<Scalar> expected;
+    MakeSimpleLayout(sizes[i + 1], cols, Order::kColMajor,
+                     expected.mutable_layout());
+    expected.set_data(expected_data.data());
+    Mul(lhs[i], previous, mul_params[i], &context, &expected);
+    for (int k = 0; k < sizes[i + 1] * cols; k++) {
+      // Relative to the expected value, as values grow along the chain.
+      EXPECT_NEAR(dst_data[i][k], expected_data[k],
+                  std::is_floating_point<Scalar>::value
+                      ? 1e-4 * std::abs(expected_data[k]) + 1e-3
+                      : 0);
+    }
+    // Continue from ChainedMul's result, so that errors don't compound.
+    previous_data = dst_data[i];
+  }
+}
+
+TEST(RuyTest, TestChainedMul) {
+  const std::vector<std::vector<int>> sizes = {
+      {1, 1}, {7, 5, 3}, {31, 17, 40, 9}, {100, 300, 64, 200, 100}};
+  for (const auto& layer_sizes : sizes) {
+    for (int cols : {1, 9, 70}) {
+      for (int max_num_threads : {1, 4}) {
+        TestChainedMul<float, float>(layer_sizes, cols, max_num_threads);
+        TestChainedMul<std::int8_t, std::int32_t>(layer_sizes, cols,
+                                                  max_num_threads);
+      }
+    }
+  }
+}
+
+TEST(RuyTest, TestChainedMulDeepFirstMul) {
+  // The first Muls have a single block each, so they are the initial blocks
+  // of the first threads, and each depends on the previous one, which is
+  // much slower, see TrMulTask::WaitForProducer.
+  for (int max_num_threads : {2, 3, 8}) {
+    TestChainedMul<float, float>({65536, 16, 16, 16, 4096}, 16,
+                                 max_num_threads);
+    TestChainedMul<std::int8_t, std::int32_t>({65536, 16, 16, 16, 4096}, 16,
+                                              max_num_threads);
+  }
+}
+
+// Checks that skip_zero_rhs_slices doesn't change results, on a RHS with runs
+// of zero columns and zero slices of depth.
+template <typename Scalar, typename AccumScalar>
+void TestSkipZeroRhsSlices(int rows, int depth, int cols, int zero_point,
+                           int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<Scalar> lhs_data;
+  std::vector<Scalar> rhs_data;
+  MakeRandomVector(RandomRange::kAvoidMinValue, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kAvoidMinValue, depth * cols, &rhs_data);
+  for (int j = 0; j < cols; j++) {
+    for (int k = 0; k < depth; k++) {
+      if ((j / 8) % 3 == 1 || (j % 5 == 0 && k >= 16 && k < 48)) {
+        rhs_data[k + j * depth] = static_cast<Scalar>(zero_point);
+      }
+    }
+  }
+  Matrix<Scalar> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  lhs.set_zero_point(static_cast<Scalar>(zero_point));
+  Matrix<Scalar> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  rhs.set_zero_point(static_cast<Scalar>(zero_point));
+
+  std::vector<AccumScalar> bias(rows);
+  for (int i = 0; i < rows; i++) {
+    bias[i] = static_cast<AccumScalar>(i % 9) - 4;
+  }
+  MulParams<AccumScalar, Scalar> mul_params;
+  mul_params.set_bias(bias.data());
+  if (!std::is_floating_point<Scalar>::value) {
+    mul_params.set_multiplier_float(1.f / depth);
+  }
+  std::vector<Scalar> expected_data(rows * cols);
+  Matrix<Scalar> expected;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  Mul(lhs, rhs, mul_params, &context, &expected);
+
+  mul_params.set_skip_zero_rhs_slices(true);
+  std::vector<Scalar> dst_data(rows * cols);
+  Matrix<Scalar> dst;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  Mul(lhs, rhs, mul_params, &context, &dst);
+  EXPECT_EQ(dst_data, expected_data);
+}
+
+TEST(RuyTest, TestSkipZeroRhsSlices) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 40}, {40, 65, 33}, {200, 100, 150}};
+  for (const auto& shape : shapes) {
+    for (int max_num_threads : {1, 4}) {
+      TestSkipZeroRhsSlices<float, float>(shape[0], shape[1], shape[2], 0,
+                                          max_num_threads);
+      TestSkipZeroRhsSlices<std::int8_t, std::int32_t>(
+          shape[0], shape[1], shape[2], 0, max_num_threads);
+      TestSkipZeroRhsSlices<std::uint8_t, std::int32_t>(
+          shape[0], shape[1], shape[2], 128, max_num_threads);
+    }
+  }
+}
+
+// Checks that bit_packing gives the same results as the regular int8 path, on
+// binary or ternary values. The LHS is cached, so that both packed forms of it
+// have to be told apart by the PrepackedCache.
+template <typename DstScalar>
+void TestBitPacking(int rows, int depth, int cols, BitPacking bit_packing,
+                    int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  const int num_values = bit_packing == BitPacking::kBinary ? 2 : 3;
+  std::vector<std::int8_t> lhs_data(rows * depth);
+  std::vector<std::int8_t> rhs_data(depth * cols);
+  for (auto* data : {&lhs_data, &rhs_data}) {
+    for (auto& val : *data) {
+      const int r = static_cast<int>(global_random_engine()() % num_values);
+      val = static_cast<std::int8_t>(num_values == 2 ? 2 * r - 1 : r - 1);
+    }
+  }
+  Matrix<std::int8_t> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  lhs.set_cache_policy(CachePolicy::kAlwaysCache);
+  Matrix<std::int8_t> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  std::vector<std::int32_t> bias(rows);
+  for (int i = 0; i < rows; i++) {
+    bias[i] = i % 9 - 4;
+  }
+  MulParams<std::int32_t, DstScalar> mul_params;
+  mul_params.set_bias(bias.data());
+  if (!std::is_same<DstScalar, std::int32_t>::value) {
+    mul_params.set_multiplier_float(4.f / depth);
+  }
+  std::vector<DstScalar> expected_data(rows * cols);
+  Matrix<DstScalar> expected;
+  MakeSimpleLayout(rows, cols, Order::kColMajor, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  Mul(lhs, rhs, mul_params, &context, &expected);
+
+  mul_params.set_bit_packing(bit_packing);
+  for (int repeat = 0; repeat < 2; repeat++) {
+    std::vector<DstScalar> dst_data(rows * cols);
+    Matrix<DstScalar> dst;
+    MakeSimpleLayout(rows, cols, Order::kColMajor, dst.mutable_layout());
+    dst.set_data(dst_data.data());
+    Mul(lhs, rhs, mul_params, &context, &dst);
+    EXPECT_EQ(dst_data, expected_data);
+  }
+}
+
+TEST(RuyTest, TestBitPacking) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 64, 40}, {40, 65, 33}, {100, 300, 150}};
+  for (const auto& shape : shapes) {
+    for (int max_num_threads : {1, 4}) {
+      for (BitPacking bit_packing :
+           {BitPacking::kBinary, BitPacking::kTernary}) {
+        TestBitPacking<std::int8_t>(shape[0], shape[1], shape[2], bit_packing,
+                                    max_num_threads);
+        TestBitPacking<std::int32_t>(shape[0], shape[1], shape[2],
+                                     bit_packing, max_num_threads);
+      }
+    }
+  }
+}
+
+// Checks that strassen_cutoff gives the same results as the classical
+// algorithm, up to rounding errors, including bias and clamping.
+void TestStrassen(int rows, int depth, int cols, int cutoff, Order dst_order,
+                  int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<float> lhs_data;
+  std::vector<float> rhs_data;
+  std::vector<float> bias;
+  MakeRandomVector(RandomRange::kGeneral, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kGeneral, depth * cols, &rhs_data);
+  MakeRandomVector(RandomRange::kBias, rows, &bias);
+  Matrix<float> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<float> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  MulParams<float, float> mul_params;
+  mul_params.set_bias(bias.data());
+  mul_params.set_clamp_min(-2.f);
+  mul_params.set_clamp_max(2.f);
+  std::vector<float> expected_data(rows * cols);
+  Matrix<float> expected;
+  MakeSimpleLayout(rows, cols, dst_order, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  Mul(lhs, rhs, mul_params, &context, &expected);
+
+  mul_params.set_strassen_cutoff(cutoff);
+  std::vector<float> dst_data(rows * cols);
+  Matrix<float> dst;
+  MakeSimpleLayout(rows, cols, dst_order, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  Mul(lhs, rhs, mul_params, &context, &dst);
+  for (int i = 0; i < rows * cols; i++) {
+    EXPECT_NEAR(dst_data[i], expected_data[i], 1e-5f * depth);
+  }
+}
+
+TEST(RuyTest, TestStrassen) {
+  const int shapes[][4] = {{5, 7, 3, 1},      {31, 33, 35, 8},
+                           {65, 70, 80, 16},  {40, 300, 41, 32},
+                           {200, 100, 150, 40}};
+  for (const auto& shape : shapes) {
+    for (Order dst_order : {Order::kColMajor, Order::kRowMajor}) {
+      for (int max_num_threads : {1, 4}) {
+        TestStrassen(shape[0], shape[1], shape[2], shape[3], dst_order,
+                     max_num_threads);
+      }
+    }
+  }
+}
+
+// Checks ComplexMul against a straightforward complex product, for all
+// storage orders. The LHS is cached, so the second repetition uses its packed
+// form from the PrepackedCache.
+void TestComplexMul(int rows, int depth, int cols, Order lhs_order,
+                    Order rhs_order, Order dst_order, bool use_bias,
+                    int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<float> random_values;
+  MakeRandomVector(RandomRange::kGeneral,
+                   2 * (rows * depth + depth * cols + rows), &random_values);
+  const std::complex<float>* random_complex =
+      reinterpret_cast<const std::complex<float>*>(random_values.data());
+  std::vector<std::complex<float>> lhs_data(random_complex,
+                                            random_complex + rows * depth);
+  std::vector<std::complex<float>> rhs_data(
+      random_complex + rows * depth,
+      random_complex + rows * depth + depth * cols);
+  std::vector<std::complex<float>> bias(
+      random_complex + rows * depth + depth * cols,
+      random_complex + rows * depth + depth * cols + rows);
+  Matrix<std::complex<float>> lhs;
+  MakeSimpleLayout(rows, depth, lhs_order, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  lhs.set_cache_policy(CachePolicy::kAlwaysCache);
+  Matrix<std::complex<float>> rhs;
+  MakeSimpleLayout(depth, cols, rhs_order, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  std::vector<std::complex<float>> expected(rows * cols);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      std::complex<double> accum = use_bias ? bias[i] : 0.f;
+      for (int k = 0; k < depth; k++) {
+        accum += std::complex<double>(Element(lhs, i, k)) *
+                 std::complex<double>(Element(rhs, k, j));
+      }
+      expected[i + j * rows] = std::complex<float>(accum);
+    }
+  }
+  for (int repeat = 0; repeat < 2; repeat++) {
+    std::vector<std::complex<float>> dst_data(rows * cols);
+    Matrix<std::complex<float>> dst;
+    MakeSimpleLayout(rows, cols, dst_order, dst.mutable_layout());
+    dst.set_data(dst_data.data());
+    ComplexMul(lhs, rhs, use_bias ? bias.data() : nullptr, &context, &dst);
+    for (int i = 0; i < rows; i++) {
+      for (int j = 0; j < cols; j++) {
+        EXPECT_NEAR(std::abs(Element(dst, i, j) - expected[i + j * rows]), 0,
+                    1e-5f * depth);
+      }
+    }
+  }
+}
+
+TEST(RuyTest, TestComplexMul) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 40}, {64, 65, 33}, {100, 50, 70}};
+  const Order orders[] = {Order::kColMajor, Order::kRowMajor};
+  for (const auto& shape : shapes) {
+    for (Order lhs_order : orders) {
+      for (Order rhs_order : orders) {
+        for (int max_num_threads : {1, 4}) {
+          TestComplexMul(shape[0], shape[1], shape[2], lhs_order, rhs_order,
+                         Order::kColMajor, true, max_num_threads);
+          TestComplexMul(shape[0], shape[1], shape[2], lhs_order, rhs_order,
+                         Order::kRowMajor, false, max_num_threads);
+        }
+      }
+    }
+  }
+}
+
+template <typename Float8Type>
+void TestFloat8RoundTrip() {
+  for (int bits = 0; bits < 256; bits++) {
+    const Float8Type val = Float8Type::FromBits(bits);
+    // Infinities saturate, see FloatToFloat8Bits.
+    if (!std::isfinite(static_cast<float>(val))) {
+      continue;
+    }
+    EXPECT_EQ(Float8Type(static_cast<float>(val)).bits(), bits);
+  }
+}
+
+TEST(RuyTest, TestFloat8Conversions) {
+  TestFloat8RoundTrip<Float8E4M3>();
+  TestFloat8RoundTrip<Float8E5M2>();
+  EXPECT_EQ(static_cast<float>(std::numeric_limits<Float8E4M3>::max()), 448.f);
+  EXPECT_EQ(static_cast<float>(std::numeric_limits<Float8E5M2>::max()),
+            57344.f);
+  EXPECT_TRUE(std::isnan(static_cast<float>(Float8E4M3::FromBits(0x7f))));
+  EXPECT_TRUE(std::isinf(static_cast<float>(Float8E5M2::FromBits(0x7c))));
+  // Saturation.
+  EXPECT_EQ(Float8E4M3(1000.f).bits(), 0x7e);
+  EXPECT_EQ(Float8E4M3(-1e30f).bits(), 0xfe);
+  EXPECT_EQ(Float8E5M2(1e30f).bits(), 0x7b);
+  EXPECT_EQ(Float8E5M2(std::numeric_limits<float>::infinity()).bits(), 0x7b);
+  // Rounding to nearest, ties to even, including subnormals.
+  EXPECT_EQ(static_cast<float>(Float8E4M3(1.0625f)), 1.f);
+  EXPECT_EQ(static_cast<float>(Float8E4M3(1.1875f)), 1.25f);
+  EXPECT_EQ(static_cast<float>(Float8E4M3(1.07f)), 1.125f);
+  EXPECT_EQ(Float8E4M3(std::ldexp(1.f, -9)).bits(), 1);
+  EXPECT_EQ(Float8E4M3(std::ldexp(1.f, -10)).bits(), 0);
+  EXPECT_EQ(Float8E4M3(std::ldexp(3.f, -10)).bits(), 2);
+  EXPECT_EQ(static_cast<float>(Float8E5M2(0.8f)), 0.75f);
+}
+
+// Checks a Mul with an 8-bit floating-point LHS against a float Mul with the
+// widened and scaled LHS. The LHS is cached, so the second repetition uses its
+// 8-bit packed form from the PrepackedCache.
+template <typename Float8Type>
+void TestFloat8Lhs(int rows, int depth, int cols, bool per_channel_scales,
+                   Order dst_order, int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<float> random_lhs;
+  std::vector<float> rhs_data;
+  std::vector<float> bias;
+  MakeRandomVector(RandomRange::kGeneral, rows * depth, &random_lhs);
+  MakeRandomVector(RandomRange::kGeneral, depth * cols, &rhs_data);
+  MakeRandomVector(RandomRange::kBias, rows, &bias);
+  std::vector<float> scales(rows);
+  for (int i = 0; i < rows; i++) {
+    scales[i] = per_channel_scales ? 0.5f + 0.25f * (i % 5) : 0.75f;
+  }
+  std::vector<Float8Type> lhs_data(rows * depth);
+  std::vector<float> widened_lhs_data(rows * depth);
+  for (int i = 0; i < rows; i++) {
+    for (int k = 0; k < depth; k++) {
+      lhs_data[i * depth + k] = Float8Type(8 * random_lhs[i * depth + k]);
+      widened_lhs_data[i * depth + k] =
+          scales[i] * static_cast<float>(lhs_data[i * depth + k]);
+    }
+  }
+  Matrix<Float8Type> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  lhs.set_cache_policy(CachePolicy::kAlwaysCache);
+  Matrix<float> widened_lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor,
+                   widened_lhs.mutable_layout());
+  widened_lhs.set_data(widened_lhs_data.data());
+  Matrix<float> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  MulParams<float, float> mul_params;
+  mul_params.set_bias(bias.data());
+  std::vector<float> expected_data(rows * cols);
+  Matrix<float> expected;
+  MakeSimpleLayout(rows, cols, dst_order, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  Mul(widened_lhs, rhs, mul_params, &context, &expected);
+
+  if (per_channel_scales) {
+    mul_params.set_multiplier_float_perchannel(scales.data());
+  } else {
+    mul_params.set_multiplier_float(scales[0]);
+  }
+  for (int repeat = 0; repeat < 2; repeat++) {
+    std::vector<float> dst_data(rows * cols);
+    Matrix<float> dst;
+    MakeSimpleLayout(rows, cols, dst_order, dst.mutable_layout());
+    dst.set_data(dst_data.data());
+    Mul(lhs, rhs, mul_params, &context, &dst);
+    for (int i = 0; i < rows * cols; i++) {
+      EXPECT_NEAR(dst_data[i], expected_data[i], 1e-4f * depth);
+    }
+  }
+}
+
+TEST(RuyTest, TestFloat8Lhs) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 40}, {64, 65, 33}, {100, 50, 70}};
+  for (const auto& shape : shapes) {
+    for (bool per_channel_scales : {false, true}) {
+      for (Order dst_order : {Order::kColMajor, Order::kRowMajor}) {
+        for (int max_num_threads : {1, 4}) {
+          TestFloat8Lhs<Float8E4M3>(shape[0], shape[1], shape[2],
+                                    per_channel_scales, dst_order,
+                                    max_num_threads);
+          TestFloat8Lhs<Float8E5M2>(shape[0], shape[1], shape[2],
+                                    per_channel_scales, dst_order,
+                                    max_num_threads);
+        }
+      }
+    }
+  }
+}
+
+template <typename Float16Type>
+void TestFloat16RoundTrip() {
+  for (int bits = 0; bits < 65536; bits++) {
+    const Float16Type val = Float16Type::FromBits(bits);
+    if (std::isnan(static_cast<float>(val))) {
+      continue;
+    }
+    EXPECT_EQ(Float16Type(static_cast<float>(val)).bits(), bits);
+  }
+}
+
+TEST(RuyTest, TestFloat16Conversions) {
+  TestFloat16RoundTrip<Half>();
+  TestFloat16RoundTrip<BFloat16>();
+  EXPECT_EQ(static_cast<float>(std::numeric_limits<Half>::max()), 65504.f);
+  EXPECT_EQ(static_cast<float>(std::numeric_limits<BFloat16>::max()),
+            std::ldexp(255.f, 120));
+  EXPECT_TRUE(std::isnan(static_cast<float>(Half(std::nanf("")))));
+  EXPECT_TRUE(std::isnan(static_cast<float>(BFloat16(std::nanf("")))));
+  // Rounding to nearest, ties to even, including to infinity.
+  EXPECT_EQ(static_cast<float>(Half(65519.f)), 65504.f);
+  EXPECT_TRUE(std::isinf(static_cast<float>(Half(65520.f))));
+  EXPECT_TRUE(std::isinf(static_cast<float>(BFloat16(3.4e38f))));
+  EXPECT_EQ(static_cast<float>(Half(1.f + std::ldexp(1.f, -11))), 1.f);
+  EXPECT_EQ(static_cast<float>(Half(1.f + std::ldexp(3.f, -11))),
+            1.f + std::ldexp(1.f, -9));
+  EXPECT_EQ(static_cast<float>(BFloat16(1.f + std::ldexp(1.f, -8))), 1.f);
+  EXPECT_EQ(static_cast<float>(BFloat16(1.f + std::ldexp(3.f, -8))),
+            1.f + std::ldexp(1.f, -6));
+  EXPECT_EQ(Half(std::ldexp(1.f, -24)).bits(), 1);
+  EXPECT_EQ(Half(std::ldexp(1.f, -25)).bits(), 0);
+  EXPECT_EQ(Half(std::ldexp(3.f, -25)).bits(), 2);
+  EXPECT_EQ(Half(-std::ldexp(1023.5f, -24)).bits(), 0x8400);
+}
+
+// Checks a float Mul with a 16-bit floating-point destination against a float
+// Mul whose result is then converted. Both use the same float kernel, so the
+// results should be exactly the same.
+template <typename DstScalar>
+void TestFloat16Dst(int rows, int depth, int cols, Order dst_order,
+                    int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<float> lhs_data;
+  std::vector<float> rhs_data;
+  std::vector<float> bias;
+  MakeRandomVector(RandomRange::kGeneral, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kGeneral, depth * cols, &rhs_data);
+  MakeRandomVector(RandomRange::kBias, rows, &bias);
+  Matrix<float> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<float> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+
+  MulParams<float, float> float_mul_params;
+  float_mul_params.set_bias(bias.data());
+  float_mul_params.set_clamp_max(2.f);
+  std::vector<float> expected_data(rows * cols);
+  Matrix<float> expected;
+  MakeSimpleLayout(rows, cols, dst_order, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  Mul(lhs, rhs, float_mul_params, &context, &expected);
+
+  MulParams<float, DstScalar> mul_params;
+  mul_params.set_bias(bias.data());
+  mul_params.set_clamp_max(2.f);
+  std::vector<DstScalar> dst_data(rows * cols);
+  Matrix<DstScalar> dst;
+  MakeSimpleLayout(rows, cols, dst_order, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  Mul(lhs, rhs, mul_params, &context, &dst);
+  for (int i = 0; i < rows * cols; i++) {
+    EXPECT_EQ(dst_data[i].bits(), DstScalar(expected_data[i]).bits());
+  }
+}
+
+TEST(RuyTest, TestFloat16Dst) {
+  const int shapes[][3] = {{1, 1, 1},    {5, 7, 3},    {8, 8, 8},
+                           {17, 31, 40}, {64, 65, 33}, {100, 50, 1}};
+  for (const auto& shape : shapes) {
+    for (Order dst_order : {Order::kColMajor, Order::kRowMajor}) {
+      for (int max_num_threads : {1, 4}) {
+        TestFloat16Dst<Half>(shape[0], shape[1], shape[2], dst_order,
+                             max_num_threads);
+        TestFloat16Dst<BFloat16>(shape[0], shape[1], shape[2], dst_order,
+                                 max_num_threads);
+      }
+    }
+  }
+}
+
+bool IsBlockInLeftColumns(int, int start_col, int, int, void* user_data) {
+  return start_col < *static_cast<int*>(user_data);
+}
+
+void TestDstMask(int rows, int depth, int cols, Order dst_order,
+                 DstMaskType mask_type, int diagonal_offset,
+                 int max_num_threads) {
+  Context context;
+  context.set_max_num_threads(max_num_threads);
+  std::vector<float> lhs_data;
+  std::vector<float> rhs_data;
+  MakeRandomVector(RandomRange::kGeneral, rows * depth, &lhs_data);
+  MakeRandomVector(RandomRange::kGeneral, depth * cols, &rhs_data);
+  Matrix<float> lhs;
+  MakeSimpleLayout(rows, depth, Order::kRowMajor, lhs.mutable_layout());
+  lhs.set_data(lhs_data.data());
+  Matrix<float> rhs;
+  MakeSimpleLayout(depth, cols, Order::kColMajor, rhs.mutable_layout());
+  rhs.set_data(rhs_data.data());
+  std::vector<float> expected_data(rows * cols);
+  Matrix<float> expected;
+  MakeSimpleLayout(rows, cols, dst_order, expected.mutable_layout());
+  expected.set_data(expected_data.data());
+  MulParams<float, float> mul_params;
+  Mul(lhs, rhs, mul_params, &context, &expected);
+
+  // Values outside of the mask are unspecified, so only the needed ones are
+  // compared.
+  std::vector<float> dst_data(rows * cols, 0);
+  Matrix<float> dst;
+  MakeSimpleLayout(rows, cols, dst_order, dst.mutable_layout());
+  dst.set_data(dst_data.data());
+  int custom_cols = cols / 2;
+  DstMask* mask = mul_params.mutable_dst_mask();
+  mask->type = mask_type;
+  mask->diagonal_offset = diagonal_offset;
+  mask->block_predicate = &IsBlockInLeftColumns;
+  mask->user_data = &custom_cols;
+  Mul(lhs, rhs, mul_params, &context, &dst);
+
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < cols; c++) {
+      bool needed = true;
+      if (mask_type == DstMaskType::kLowerTriangular) {
+        needed = c <= r + diagonal_offset;
+      } else if (mask_type == DstMaskType::kUpperTriangular) {
+        needed = c >= r + diagonal_offset;
+      } else if (mask_type == DstMaskType::kCustom) {
+        needed = c < custom_cols;
+      }
+      if (needed) {
+        EXPECT_NEAR(Element(dst, r, c), Element(expected, r, c),
+                    1e-5f * depth);
+      }
+    }
+  }
+}
+
+TEST(RuyTest, TestDstMask) {
+  const int shapes[][3] = {
+      {1, 1, 1}, {5, 7, 3}, {17, 31, 9}, {100, 40, 100}, {300, 50, 260}};
+  for (const auto& shape : shapes) {
+    for (Order dst_order : {Order::kColMajor, Order::kRowMajor}) {
+      for (int max_num_threads : {1, 4}) {
+        for (DstMaskType mask_type :
+             {DstMaskType::kLowerTriangular, DstMaskType::kUpperTriangular,
+              DstMaskType::kCustom}) {
+          for (int diagonal_offset : {-20, 0, 3}) {
+            TestDstMask(shape[0], shape[1], shape[2], dst_order, mask_type,
+                        diagonal_offset, max_num_threads);
+          }
+        }
+      }
+    }
+  }
+}
+
 }  // namespace ruy
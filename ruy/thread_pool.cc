@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "ruy/thread_pool.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>              // NOLINT(build/c++11)
 #include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
@@ -95,16 +97,24 @@ class Thread {
     }
     state_.store(new_state, std::memory_order_relaxed);
     state_cond_.notify_all();
+    BlockingCounter* counter_to_decrement_when_ready =
+        counter_to_decrement_when_ready_.load(std::memory_order_relaxed);
     state_mutex_.unlock();
     if (new_state == State::Ready) {
-      counter_to_decrement_when_ready_->DecrementCount();
+      counter_to_decrement_when_ready->DecrementCount();
     }
   }
 
   static void ThreadFunc(Thread* arg) { arg->ThreadFuncImpl(); }
 
-  // Called by the master thead to give this thread work to do.
-  void StartWork(Task* task) { ChangeState(State::HasWork, task); }
+  // Called by the master thead, or by a worker thread (see ExecuteTreeTask),
+  // to give this thread work to do. When done, this thread decrements
+  // `counter_to_decrement_when_ready`.
+  void StartWork(Task* task, BlockingCounter* counter_to_decrement_when_ready) {
+    counter_to_decrement_when_ready_.store(counter_to_decrement_when_ready,
+                                           std::memory_order_relaxed);
+    ChangeState(State::HasWork, task);
+  }
 
  private:
   // Thread entry point.
@@ -150,17 +160,67 @@ class Thread {
   // to be a std::atomic because we use WaitForVariableChange.
   std::atomic<State> state_;
 
-  // pointer to the master's thread BlockingCounter object, to notify the
-  // master thread of when this thread switches to the 'Ready' state.
-  BlockingCounter* const counter_to_decrement_when_ready_;
+  // pointer to the BlockingCounter object to notify when this thread switches
+  // to the 'Ready' state: that of the master thread at startup, then that of
+  // the thread that gave this thread work to do. Changed by StartWork, which
+  // is only called in the 'Ready' state, and read under state_mutex_.
+  std::atomic<BlockingCounter*> counter_to_decrement_when_ready_;
 
   // See ThreadPool::spin_duration_.
   const Duration spin_duration_;
 };
 
+// Fanout of the tree along which ExecuteImpl starts tasks and waits for them.
+// With up to that many worker threads, the main thread starts and waits for
+// all of them by itself. Beyond that, the time to start all threads and the
+// contention on each counter grow logarithmically with the number of threads,
+// instead of linearly.
+constexpr int kExecuteTreeFanout = 8;
+
+// The node of that tree for one task, with node 0 being the main thread, and
+// node i > 0 being threads_[i - 1]. The children of node i are nodes
+// i * kExecuteTreeFanout + 1 to i * kExecuteTreeFanout + kExecuteTreeFanout.
+// Running this task first starts the tasks of the children nodes, so that
+// they run concurrently with this one, then runs this node's own task, then
+// waits for the children nodes, which themselves have waited for their own
+// children. Each node is a separate allocation, so that the counters of
+// different nodes are unlikely to share cache lines.
+class ExecuteTreeTask final : public Task {
+ public:
+  void Run() override {
+    const int first_child = node * kExecuteTreeFanout + 1;
+    const int end_child =
+        std::min(first_child + kExecuteTreeFanout, *task_count);
+    if (first_child < end_child) {
+      children_counter.Reset(end_child - first_child);
+      for (int child = first_child; child < end_child; child++) {
+        (*threads)[child - 1]->StartWork((*tree_tasks)[child],
+                                         &children_counter);
+      }
+    }
+    task->Run();
+    if (first_child < end_child) {
+      children_counter.Wait(*spin_duration);
+    }
+  }
+
+  int node = 0;
+  // The task of this node, set by each ExecuteImpl.
+  Task* task = nullptr;
+  // Pointers to the state of the ThreadPool.
+  const int* task_count = nullptr;
+  const std::vector<Thread*>* threads = nullptr;
+  const std::vector<ExecuteTreeTask*>* tree_tasks = nullptr;
+  const Duration* spin_duration = nullptr;
+  // Counts the children nodes that haven't completed yet.
+  BlockingCounter children_counter;
+};
+
 void ThreadPool::ExecuteImpl(int task_count, int stride, Task* tasks) {
   RUY_DCHECK_GE(task_count, 1);
 
+  ReapIdleThreads(task_count - 1);
+
   // Case of 1 thread: just run the single task on the current thread.
   if (task_count == 1) {
     (tasks + 0)->Run();
@@ -169,17 +229,28 @@ void ThreadPool::ExecuteImpl(int task_count, int stride, Task* tasks) {
 
   // Task #0 will be run on the current thread.
   CreateThreads(task_count - 1);
-  counter_to_decrement_when_ready_.Reset(task_count - 1);
-  for (int i = 1; i < task_count; i++) {
+  const TimePoint now = CoarseNow();
+  for (int i = 0; i < task_count - 1; i++) {
+    thread_last_used_[i] = now;
+  }
+  task_count_ = task_count;
+  while (tree_tasks_.size() < static_cast<std::size_t>(task_count)) {
+    ExecuteTreeTask* tree_task = new ExecuteTreeTask;
+    tree_task->node = tree_tasks_.size();
+    tree_task->task_count = &task_count_;
+    tree_task->threads = &threads_;
+    tree_task->tree_tasks = &tree_tasks_;
+    tree_task->spin_duration = &spin_duration_;
+    tree_tasks_.push_back(tree_task);
+  }
+  for (int i = 0; i < task_count; i++) {
     auto task_address = reinterpret_cast<std::uintptr_t>(tasks) + i * stride;
-    threads_[i - 1]->StartWork(reinterpret_cast<Task*>(task_address));
+    tree_tasks_[i]->task = reinterpret_cast<Task*>(task_address);
   }
 
-  // Execute task #0 immediately on the current thread.
-  (tasks + 0)->Run();
-
-  // Wait for the threads submitted above to finish.
-  counter_to_decrement_when_ready_.Wait(spin_duration_);
+  // Starts the other tasks along the tree, executes task #0 on the current
+  // thread, and waits for the other tasks to finish.
+  tree_tasks_[0]->Run();
 }
 
 // Ensures that the pool has at least the given count of threads.
@@ -195,14 +266,39 @@ void ThreadPool::CreateThreads(int threads_count) {
   while (threads_.size() < unsigned_threads_count) {
     threads_.push_back(
         new Thread(&counter_to_decrement_when_ready_, spin_duration_));
+    thread_last_used_.push_back(CoarseNow());
   }
   counter_to_decrement_when_ready_.Wait(spin_duration_);
 }
 
+int ThreadPool::ReapIdleThreads(int min_thread_count) {
+  if (idle_timeout_ <= Duration::zero()) {
+    return 0;
+  }
+  const TimePoint now = CoarseNow();
+  int reaped_count = 0;
+  while (static_cast<int>(threads_.size()) > std::max(min_thread_count, 0) &&
+         now - thread_last_used_.back() > idle_timeout_) {
+    // Waits for the thread to exit.
+    delete threads_.back();
+    threads_.pop_back();
+    thread_last_used_.pop_back();
+    reaped_count++;
+  }
+  while (tree_tasks_.size() > threads_.size() + 1) {
+    delete tree_tasks_.back();
+    tree_tasks_.pop_back();
+  }
+  return reaped_count;
+}
+
 ThreadPool::~ThreadPool() {
   for (auto w : threads_) {
     delete w;
   }
+  for (auto t : tree_tasks_) {
+    delete t;
+  }
 }
 
 }  // end namespace ruy
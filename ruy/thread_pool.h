@@ -33,6 +33,7 @@ struct Task {
 };
 
 class Thread;
+class ExecuteTreeTask;
 
 // A simple pool of threads, that only allows the very
 // specific parallelization pattern that we use here:
@@ -42,6 +43,11 @@ class Thread;
 // the worker threads to have all completed. That is the only synchronization
 // performed by this ThreadPool.
 //
+// With many threads, tasks are started and waited for along a tree rooted at
+// the main thread (see ExecuteTreeTask), so that neither the main thread has
+// to wake up all worker threads by itself, nor do all worker threads
+// decrement the same atomic counter when they are done.
+//
 // In particular, there is a naive 1:1 mapping of Tasks to threads.
 // This ThreadPool considers it outside of its own scope to try to work
 // with fewer threads than there are Tasks. The idea is that such N:M mappings
@@ -85,6 +91,27 @@ class ThreadPool {
     return ToFloatMilliseconds(spin_duration_);
   }
 
+  // The number of worker threads, not counting the main thread.
+  int thread_count() const { return static_cast<int>(threads_.size()); }
+
+  // Worker threads that have not run any task for longer than this are
+  // destroyed by ReapIdleThreads, and recreated when needed again. The
+  // default, 0, means never.
+  void set_idle_timeout_milliseconds(float milliseconds) {
+    idle_timeout_ = DurationFromMilliseconds(milliseconds);
+  }
+
+  float idle_timeout_milliseconds() const {
+    return ToFloatMilliseconds(idle_timeout_);
+  }
+
+  // Destroys worker threads that have been idle for longer than the idle
+  // timeout, keeping at least `min_thread_count` threads. As Execute always
+  // uses the first threads, the idle threads are the last ones. Called by
+  // Execute, and by callers holding per-thread resources, which they can then
+  // free. Returns the number of destroyed threads.
+  int ReapIdleThreads(int min_thread_count = 0);
+
  private:
   // Ensures that the pool has at least the given count of threads.
   // If any new thread has to be created, this function waits for it to
@@ -102,9 +129,19 @@ class ThreadPool {
   // the pool creates threads and destroys them in its destructor.
   std::vector<Thread*> threads_;
 
-  // The BlockingCounter used to wait for the threads.
+  // When each thread last started running a task, for ReapIdleThreads.
+  std::vector<TimePoint> thread_last_used_;
+
+  // The BlockingCounter used to wait for new threads to be ready.
   BlockingCounter counter_to_decrement_when_ready_;
 
+  // The nodes of the tree along which ExecuteImpl starts tasks and waits for
+  // them, one per task. Owned by the pool, like threads_.
+  std::vector<ExecuteTreeTask*> tree_tasks_;
+
+  // The task_count of the current ExecuteImpl call.
+  int task_count_ = 0;
+
   // This value was empirically derived with some microbenchmark, we don't have
   // high confidence in it.
   //
@@ -120,6 +157,9 @@ class ThreadPool {
   // may be a little longer. There may also not be another GEMM for a long time,
   // in which case we'll end up passively waiting below.
   Duration spin_duration_ = DurationFromMilliseconds(2);
+
+  // See set_idle_timeout_milliseconds.
+  Duration idle_timeout_ = Duration::zero();
 };
 
 }  // namespace ruy
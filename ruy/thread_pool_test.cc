@@ -0,0 +1,93 @@
+/* Copyright 2020 Google LLC. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "ruy/thread_pool.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "ruy/gtest_wrapper.h"
+
+namespace ruy {
+namespace {
+
+struct CountingTask final : Task {
+  void Run() override {
+    run_count++;
+    thread_id = std::this_thread::get_id();
+    total_run_count->fetch_add(1);
+  }
+  int run_count = 0;
+  std::thread::id thread_id;
+  std::atomic<int>* total_run_count = nullptr;
+};
+
+// Checks that each task runs exactly once, on its own thread, and that all
+// tasks have completed when Execute returns, including when tasks are
+// started along a tree with several levels.
+void TestExecute(ThreadPool* pool, int task_count) {
+  std::atomic<int> total_run_count(0);
+  std::vector<CountingTask> tasks(task_count);
+  for (auto& task : tasks) {
+    task.total_run_count = &total_run_count;
+  }
+  pool->Execute(task_count, tasks.data());
+  EXPECT_EQ(total_run_count.load(), task_count);
+  for (int i = 0; i < task_count; i++) {
+    EXPECT_EQ(tasks[i].run_count, 1);
+    for (int j = 0; j < i; j++) {
+      EXPECT_NE(tasks[i].thread_id, tasks[j].thread_id);
+    }
+  }
+  EXPECT_EQ(tasks[0].thread_id, std::this_thread::get_id());
+}
+
+TEST(ThreadPoolTest, Execute) {
+  ThreadPool pool;
+  for (int task_count = 1; task_count <= 80; task_count++) {
+    TestExecute(&pool, task_count);
+  }
+  for (int task_count = 80; task_count >= 1; task_count -= 7) {
+    TestExecute(&pool, task_count);
+  }
+}
+
+TEST(ThreadPoolTest, ReapIdleThreads) {
+  ThreadPool pool;
+  TestExecute(&pool, 5);
+  EXPECT_EQ(pool.thread_count(), 4);
+  // Without an idle timeout, threads are never destroyed.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(pool.ReapIdleThreads(), 0);
+  pool.set_idle_timeout_milliseconds(10);
+  TestExecute(&pool, 3);
+  EXPECT_EQ(pool.thread_count(), 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(pool.ReapIdleThreads(1), 1);
+  EXPECT_EQ(pool.thread_count(), 1);
+  // Threads are recreated when needed again.
+  TestExecute(&pool, 4);
+  EXPECT_EQ(pool.thread_count(), 3);
+}
+
+}  // namespace
+}  // namespace ruy
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -17,9 +17,11 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "ruy/allocator.h"
@@ -35,6 +37,7 @@ limitations under the License.
 #include "ruy/side_pair.h"
 #include "ruy/size_util.h"
 #include "ruy/thread_pool.h"
+#include "ruy/time.h"
 #include "ruy/tune.h"
 
 namespace ruy {
@@ -43,40 +46,209 @@ namespace {
 
 enum class PackingStatus : std::uint8_t { kNotStarted, kInProgress, kFinished };
 
+// A thread whose initial block is taken by another thread this long after the
+// start of the TrMul counts as a straggler, see TrMulTask::Run. That is well
+// above the usual latency of waking up a thread, but below a scheduler
+// time slice, which is how long a descheduled thread may take to run again.
+constexpr float kStragglerTimeoutMilliseconds = 1.f;
+
+// Weight of each multi-threaded TrMul in Ctx::straggler_rate.
+constexpr float kStragglerRateWeight = 1.f / 16;
+
+// State of one of the TrMuls computed by a pool dispatch, shared by all the
+// threads. TrMul computes one, GroupedTrMul and ChainedTrMul compute several
+// at once.
+struct TrMulGroup final {
+  TrMulParams* params = nullptr;
+  BlockMap block_map;
+  // Number of blocks to compute. When some blocks are skipped due to a
+  // DstMask, active_blocks lists the indices of the other blocks, and
+  // needed_panels tells which LHS and RHS panels they use. Otherwise, these
+  // are null and all blocks are computed.
+  int num_blocks = 0;
+  const int* active_blocks = nullptr;
+  SidePair<bool*> needed_panels{nullptr, nullptr};
+  // In the need_atomics case, the packing status of the blocks of each side.
+  SidePair<std::atomic<PackingStatus>*> packing_status{nullptr, nullptr};
+  // The per-thread buffers of partial reductions of the destination, if any,
+  // of params->dst_reduction_partials_bytes each.
+  char* dst_reduction_partials = nullptr;
+  // In ChainedTrMul, the group whose destination is the RHS of this group.
+  // RHS panels are only packed once the blocks of rhs_producer covering their
+  // columns are complete.
+  const TrMulGroup* rhs_producer = nullptr;
+  // In ChainedTrMul, for each block of columns of this group's block map, the
+  // number of blocks of these columns that are complete.
+  std::atomic<int>* complete_blocks_per_col_block = nullptr;
+};
+
+// Memory that threads prefetch once done with their blocks, see
+// Ctx::PrefetchPacked, as chunks claimed with an atomic counter.
+struct PrefetchRegion final {
+  static constexpr int kChunkBytes = 4096;
+  const char* data = nullptr;
+  int num_chunks = 0;
+  std::atomic<int> next_chunk{0};
+};
+
+void AllocatePMatrix(Allocator* allocator, PEMat* packed) {
+  packed->data = allocator->AllocateBytes(DataBytes(*packed));
+  packed->sums = allocator->AllocateBytes(SumsBytes(*packed));
+  packed->scales = allocator->AllocateBytes(ScalesBytes(*packed));
+}
+
+// Helper for CopyPackedColumn, for the per-column sums and scales.
+void CopyPackedColumnValue(const void* src, int size, int src_col, void* dst,
+                           int dst_col) {
+  if (!src || !size) {
+    return;
+  }
+  char* dst_ptr = static_cast<char*>(dst) + dst_col * size;
+  if (src_col < 0) {
+    memset(dst_ptr, 0, size);
+  } else {
+    memcpy(dst_ptr, static_cast<const char*>(src) + src_col * size, size);
+  }
+}
+
+// Copies column `src_col` of the packed matrix `src` into column `dst_col` of
+// `dst`, which has the same layout but for the number of columns, or fills that
+// column with zeros if `src_col` is negative.
+void CopyPackedColumn(const PEMat& src, int src_col, PEMat* dst, int dst_col) {
+  const KernelLayout& kernel = src.layout.kernel;
+  const int elem_size = src.data_type.size;
+  char* dst_data = static_cast<char*>(dst->data);
+  const char* src_data = static_cast<const char*>(src.data);
+  for (int row = 0; row < src.layout.rows; row += kernel.rows) {
+    char* dst_ptr = dst_data + Offset(dst->layout, row, dst_col) * elem_size;
+    const char* src_ptr =
+        src_col < 0 ? nullptr
+                    : src_data + Offset(src.layout, row, src_col) * elem_size;
+    if (kernel.order == Order::kColMajor) {
+      // The kernel.rows values of this column are contiguous.
+      if (src_ptr) {
+        memcpy(dst_ptr, src_ptr, kernel.rows * elem_size);
+      } else {
+        memset(dst_ptr, 0, kernel.rows * elem_size);
+      }
+    } else {
+      for (int r = 0; r < kernel.rows; r++) {
+        const int offset = r * kernel.cols * elem_size;
+        if (src_ptr) {
+          memcpy(dst_ptr + offset, src_ptr + offset, elem_size);
+        } else {
+          memset(dst_ptr + offset, 0, elem_size);
+        }
+      }
+    }
+  }
+  CopyPackedColumnValue(src.sums, src.sums_type.size, src_col, dst->sums,
+                        dst_col);
+  CopyPackedColumnValue(src.scales, src.scales_type.size, src_col, dst->scales,
+                        dst_col);
+}
+
+// Packs columns [start, end) of the packed matrix on the given side. With
+// TrMulParams::selected_indices, these are columns of the compact packed
+// matrix, gathered from the full prepacked matrix if there is one, or packed
+// from the source panels that contain them into a panel-sized scratch buffer
+// allocated from `allocator`. This lets the threads gather the selected columns
+// block by block, like they pack other matrices.
+void PackColumns(TrMulParams* params, Side side, Tuning tuning, int start,
+                 int end, Allocator* allocator) {
+  const int* indices = params->selected_indices[side];
+  if (!indices) {
+    params->RunPack(side, tuning, start, end);
+    return;
+  }
+  RUY_DCHECK(!params->is_gated());
+  PEMat& packed = params->packed[side];
+  const PEMat& selection_packed = params->selection_packed[side];
+  const EMat& selection_src = params->selection_src[side];
+  const int count = params->src[side].layout.cols;
+  const int kernel_cols = packed.layout.kernel.cols;
+  PEMat scratch;
+  int scratch_panel = -1;
+  if (!selection_packed.data) {
+    scratch = packed;
+    scratch.layout.cols = kernel_cols;
+    AllocatePMatrix(allocator, &scratch);
+  }
+  for (int col = start; col < end; col++) {
+    // Padding columns are filled with zeros.
+    const int src_col = col < count ? indices[col] : -1;
+    if (selection_packed.data || src_col < 0) {
+      CopyPackedColumn(selection_packed, src_col, &packed, col);
+      continue;
+    }
+    const int panel = src_col / kernel_cols;
+    if (panel != scratch_panel) {
+      const int panel_start = panel * kernel_cols;
+      EMat panel_src = selection_src;
+      panel_src.data =
+          static_cast<char*>(selection_src.data) +
+          Offset(selection_src.layout, 0, panel_start) *
+              selection_src.data_type.size;
+      panel_src.layout.cols =
+          std::min(kernel_cols, selection_src.layout.cols - panel_start);
+      params->run_pack[side](tuning, panel_src, &scratch, 0, kernel_cols);
+      scratch_panel = panel;
+    }
+    CopyPackedColumn(scratch, src_col % kernel_cols, &packed, col);
+  }
+  if (packed.zero_slices) {
+    FindZeroSlices(&packed, start, end);
+  }
+}
+
 struct TrMulTask final : Task {
-  TrMulTask(TrMulParams* params_, const BlockMap& block_map_,
-            std::atomic<int>* atomic_block_id_, int thread_id_,
-            bool need_atomics_,
-            SidePair<std::atomic<PackingStatus>*> packing_status_,
+  TrMulTask(const TrMulGroup* groups_, int num_groups_,
+            const int* group_block_offsets_,
+            std::atomic<int>* atomic_block_id_,
+            std::atomic<bool>* initial_block_claimed_,
+            std::atomic<bool>* straggled_, TimePoint start_time_,
+            PrefetchRegion* prefetch_region_, int thread_id_,
+            int thread_count_, bool need_atomics_,
             TuningResolver* tuning_resolver_, Allocator* local_allocator_)
-      : params(params_),
-        block_map(block_map_),
+      : groups(groups_),
+        num_groups(num_groups_),
+        group_block_offsets(group_block_offsets_),
         atomic_block_id(atomic_block_id_),
+        initial_block_claimed(initial_block_claimed_),
+        straggled(straggled_),
+        start_time(start_time_),
+        prefetch_region(prefetch_region_),
         thread_id(thread_id_),
+        thread_count(thread_count_),
         need_atomics(need_atomics_),
-        packing_status(packing_status_),
         tuning_resolver(tuning_resolver_),
         local_allocator(local_allocator_),
-        local_packed{nullptr, nullptr} {}
+        local_packed(nullptr) {}
 
   void Run() override {
-    for (Side side : {Side::kLhs, Side::kRhs}) {
-      if (!params->is_prepacked[side]) {
-        const int size = NumBlocksPerSide(side, block_map);
-        local_allocator->Allocate(size, &local_packed[side]);
-        memset(local_packed[side], 0, size * sizeof(bool));
+    local_allocator->Allocate(num_groups, &local_packed);
+    for (int g = 0; g < num_groups; g++) {
+      for (Side side : {Side::kLhs, Side::kRhs}) {
+        local_packed[g][side] = nullptr;
+        if (!groups[g].params->is_prepacked[side]) {
+          const int size = NumBlocksPerSide(side, groups[g].block_map);
+          local_allocator->Allocate(size, &local_packed[g][side]);
+          memset(local_packed[g][side], 0, size * sizeof(bool));
+        }
       }
     }
 
     const Tuning tuning = tuning_resolver->Resolve();
-    const int num_blocks = NumBlocks(block_map);
-    SidePair<int> block;
-    SidePair<int> start;
-    SidePair<int> end;
+    const int num_blocks = group_block_offsets[num_groups];
 
     // Each thread starts by initially reserving the block whose id
-    // is the thread id.
-    int block_id = thread_id;
+    // is the thread id, unless another thread has already taken it, see
+    // below. Block ids are numbered consecutively across groups.
+    int block_id =
+        ClaimInitialBlock(thread_id)
+            ? thread_id
+            : atomic_block_id->fetch_add(1, std::memory_order_relaxed);
+    int group_id = 0;
     while (block_id < num_blocks) {
       // Reserve the next block to handle. In order to hide the latency
       // (typically comparable to an access to the level of data cache that
@@ -85,32 +257,160 @@ struct TrMulTask final : Task {
       // immediately depending on the `next_n` result.
       const int next_block_id =
           atomic_block_id->fetch_add(1, std::memory_order_relaxed);
-      // Get coordinates of the current block to handle, in "block space".
-      GetBlockByIndex(block_map, block_id, &block);
-      // Get coordinates of the current block to handle, in matrix space.
-      GetBlockMatrixCoords(block_map, block, &start, &end);
-      // Maybe pack the current LHS/RHS block, if not already packed.
-      EnsurePacked(block, start, end, tuning);
-      // Actually do matrix multiplication work
-      params->RunKernel(tuning, start, end);
+      RunBlock(block_id, tuning, &group_id);
       // Move on to the next block as obtained by the atomic increment
       // at the start of this while loop iteration.
       block_id = next_block_id;
     }
 
+    RunUnstartedInitialBlocks(num_blocks, tuning);
+
+    if (prefetch_region) {
+      Prefetch();
+    }
+
     local_allocator->FreeAll();
   }
 
  private:
+  // Threads that haven't started running yet, typically because they were
+  // descheduled under CPU contention, would otherwise hold their initial
+  // blocks, and the main thread would wait for them. Instead, run these
+  // blocks now. Blocks that a thread has started running can't be taken
+  // over, as they may already be partially written.
+  //
+  // Only blocks with ids smaller than `end_block_id` are taken over. Blocks
+  // of a chained TrMul only depend on blocks with smaller ids, so while
+  // waiting from within a block, only taking over blocks with smaller ids
+  // ensures that they don't depend on that block, or on the blocks under it
+  // in this thread's stack, which would deadlock.
+  void RunUnstartedInitialBlocks(int end_block_id, Tuning tuning) {
+    for (int i = 1; i < thread_count; i++) {
+      const int other_thread_id = (thread_id + i) % thread_count;
+      if (other_thread_id < end_block_id &&
+          ClaimInitialBlock(other_thread_id)) {
+        if (Now() - start_time >
+            DurationFromMilliseconds(kStragglerTimeoutMilliseconds)) {
+          straggled->store(true, std::memory_order_relaxed);
+        }
+        int group_id = 0;
+        RunBlock(other_thread_id, tuning, &group_id);
+      }
+    }
+  }
+
+  // Prefetches chunks of prefetch_region until there are none left.
+  void Prefetch() {
+    while (true) {
+      const int chunk =
+          prefetch_region->next_chunk.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= prefetch_region->num_chunks) {
+        return;
+      }
+      const char* chunk_data =
+          prefetch_region->data + chunk * PrefetchRegion::kChunkBytes;
+      for (int i = 0; i < PrefetchRegion::kChunkBytes; i += 64) {
+#if defined __GNUC__
+        // Read access, moderate temporal locality: these are meant to end up
+        // in the shared cache, rather than evict this core's working data.
+        __builtin_prefetch(chunk_data + i, 0, 2);
+#else
+        (void)chunk_data;
+#endif
+      }
+    }
+  }
+
+  // Waits, from within block `block_id`, until the blocks of `producer`
+  // covering the given columns of its destination are complete. These blocks
+  // all have smaller ids than `block_id`, so they have all been claimed
+  // already, except maybe the initial blocks of threads that haven't started
+  // yet, which are then run here. Any thread waiting on a block is thus
+  // waiting on a block with a smaller id, which can't be under its own stack.
+  void WaitForProducer(const TrMulGroup& producer, int start_col, int end_col,
+                       int block_id, Tuning tuning) {
+    const int num_col_blocks = NumBlocksPerSide(Side::kRhs, producer.block_map);
+    const int num_row_blocks = NumBlocksPerSide(Side::kLhs, producer.block_map);
+    for (int b = 0; b < num_col_blocks; b++) {
+      int block_start, block_end;
+      GetBlockMatrixCoords(Side::kRhs, producer.block_map, b, &block_start,
+                           &block_end);
+      if (block_start >= end_col || block_end <= start_col) {
+        continue;
+      }
+      std::atomic<int>& complete_blocks =
+          producer.complete_blocks_per_col_block[b];
+      while (complete_blocks.load(std::memory_order_acquire) <
+             num_row_blocks) {
+        RunUnstartedInitialBlocks(block_id, tuning);
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  // Claims the initial block of the given thread. Returns false if another
+  // thread has already claimed it.
+  bool ClaimInitialBlock(int initial_thread_id) {
+    std::atomic<bool>& claimed = initial_block_claimed[initial_thread_id];
+    return !claimed.load(std::memory_order_relaxed) &&
+           !claimed.exchange(true, std::memory_order_relaxed);
+  }
+
+  // Runs the given block. `group_id` is the group of the previous block run
+  // by this thread, if that had a smaller id, or 0, and is updated.
+  void RunBlock(int block_id, Tuning tuning, int* group_id) {
+    SidePair<int> block;
+    SidePair<int> start;
+    SidePair<int> end;
+    // Each thread gets increasing block ids, so the group of the current
+    // block is found by moving forward from the group of the previous one.
+    while (block_id >= group_block_offsets[*group_id + 1]) {
+      ++*group_id;
+    }
+    const TrMulGroup& group = groups[*group_id];
+    const int index = block_id - group_block_offsets[*group_id];
+    // Get coordinates of the current block to handle, in "block space".
+    GetBlockByIndex(group.block_map,
+                    group.active_blocks ? group.active_blocks[index] : index,
+                    &block);
+    // Get coordinates of the current block to handle, in matrix space.
+    GetBlockMatrixCoords(group.block_map, block, &start, &end);
+    // Wait for the RHS columns to be computed, if this is a chained TrMul.
+    if (group.rhs_producer &&
+        !local_packed[*group_id][Side::kRhs][block[Side::kRhs]]) {
+      WaitForProducer(*group.rhs_producer, start[Side::kRhs], end[Side::kRhs],
+                      block_id, tuning);
+    }
+    // Maybe pack the current LHS/RHS block, if not already packed.
+    EnsurePacked(*group_id, block, start, end, tuning);
+    // Actually do matrix multiplication work
+    group.params->RunKernel(tuning, start, end);
+    // Let the next TrMul of a chain know that these columns progressed.
+    if (group.complete_blocks_per_col_block) {
+      group.complete_blocks_per_col_block[block[Side::kRhs]].fetch_add(
+          1, std::memory_order_release);
+    }
+    // Reduce the destination block while it is still in cache.
+    if (group.params->has_dst_reductions()) {
+      group.params->ReduceDstBlock(
+          start, end,
+          group.dst_reduction_partials +
+              thread_id * group.params->dst_reduction_partials_bytes);
+    }
+  }
+
   // Tries to pack a block, without blocking.
   // If the block was already packed, returns true.
   // If the block was not started packing, packs it and returns true.
   // If the block was being packed by another thread, returns false.
-  bool TryPack(Side side, int block, int start, int end, Tuning tuning) {
+  bool TryPack(int group_id, Side side, int block, int start, int end,
+               Tuning tuning) {
+    TrMulParams* params = groups[group_id].params;
     if (params->is_prepacked[side]) {
       return true;
     }
-    if (!local_packed[side][block]) {
+    bool* local_packed_side = local_packed[group_id][side];
+    if (!local_packed_side[block]) {
       if (need_atomics) {
         // Explanation of this compare_exchange_strong operation:
         // This atomically performs all of the following:
@@ -147,14 +447,15 @@ struct TrMulTask final : Task {
         // such a problem. But we don't really know for sure, that would be
         // interesting to experiment more with.
         PackingStatus exchanged_status = PackingStatus::kNotStarted;
-        std::atomic<PackingStatus>& status = packing_status[side][block];
+        std::atomic<PackingStatus>& status =
+            groups[group_id].packing_status[side][block];
         if (status.compare_exchange_strong(
                 exchanged_status, PackingStatus::kInProgress,
                 std::memory_order_acq_rel, std::memory_order_acquire)) {
           // In this branch, the status was kNotStarted and we just atomically
           // changed it to kInProgress as we are about to handle the packing
           // ourselves.
-          params->RunPack(side, tuning, start, end);
+          PackColumns(params, side, tuning, start, end, local_allocator);
           status.store(PackingStatus::kFinished, std::memory_order_release);
         } else if (exchanged_status == PackingStatus::kInProgress) {
           // Another thread is currently packing this block.
@@ -165,9 +466,9 @@ struct TrMulTask final : Task {
       } else {
         // Single-threaded case: no need for expensive atomics, local_packed
         // is the truth already.
-        params->RunPack(side, tuning, start, end);
+        PackColumns(params, side, tuning, start, end, local_allocator);
       }
-      local_packed[side][block] = true;
+      local_packed_side[block] = true;
     }
     return true;
   }
@@ -176,8 +477,10 @@ struct TrMulTask final : Task {
   // are packed. In the event that they are already being packed on another
   // threads, this function may perform the packing of some other block while
   // waiting for that other thread to finish packing the requested block.
-  void EnsurePacked(const SidePair<int>& block, const SidePair<int>& start,
-                    const SidePair<int>& end, Tuning tuning) {
+  void EnsurePacked(int group_id, const SidePair<int>& block,
+                    const SidePair<int>& start, const SidePair<int>& end,
+                    Tuning tuning) {
+    const TrMulGroup& group = groups[group_id];
 #if RUY_OPT(PACK_AHEAD)
     SidePair<int> next_runahead_block{block[Side::kLhs] + 1,
                                       block[Side::kRhs] + 1};
@@ -186,8 +489,8 @@ struct TrMulTask final : Task {
     while (true) {
       bool both_sides_packed = true;
       for (Side side : {Side::kLhs, Side::kRhs}) {
-        both_sides_packed &=
-            TryPack(side, block[side], start[side], end[side], tuning);
+        both_sides_packed &= TryPack(group_id, side, block[side], start[side],
+                                     end[side], tuning);
       }
       if (both_sides_packed) {
         break;
@@ -197,35 +500,101 @@ struct TrMulTask final : Task {
       const int runahead_block = next_runahead_block[runahead_side];
       next_runahead_side =
           next_runahead_side == Side::kLhs ? Side::kRhs : Side::kLhs;
-      if (runahead_block >= NumBlocksPerSide(runahead_side, block_map)) {
+      if (runahead_block >= NumBlocksPerSide(runahead_side, group.block_map)) {
+        continue;
+      }
+      if (runahead_side == Side::kRhs && group.rhs_producer) {
+        // The RHS panel may not have been computed yet, see ChainedTrMul.
+        continue;
+      }
+      if (group.needed_panels[runahead_side] &&
+          !group.needed_panels[runahead_side][runahead_block]) {
+        // This panel is only used by skipped blocks, see DstMask.
+        next_runahead_block[runahead_side] = runahead_block + 1;
         continue;
       }
       int runahead_block_start, runahead_block_end;
-      GetBlockMatrixCoords(runahead_side, block_map, runahead_block,
+      GetBlockMatrixCoords(runahead_side, group.block_map, runahead_block,
                            &runahead_block_start, &runahead_block_end);
-      TryPack(runahead_side, runahead_block, runahead_block_start,
+      TryPack(group_id, runahead_side, runahead_block, runahead_block_start,
               runahead_block_end, tuning);
       next_runahead_block[runahead_side] = runahead_block + 1;
 #endif
     }
   }
 
-  TrMulParams* params;
-  const BlockMap& block_map;
+  const TrMulGroup* groups;
+  int num_groups;
+  // The blocks of group g have ids in
+  // [group_block_offsets[g], group_block_offsets[g + 1]).
+  const int* group_block_offsets;
   std::atomic<int>* atomic_block_id;
+  // For each thread, whether its initial block has been claimed, see Run.
+  std::atomic<bool>* initial_block_claimed;
+  // Set when a straggler's initial block is taken, see Run.
+  std::atomic<bool>* straggled;
+  TimePoint start_time;
+  // Null unless there is something to prefetch, see Ctx::PrefetchPacked.
+  PrefetchRegion* prefetch_region;
   int thread_id;
+  int thread_count;
   bool need_atomics;
-  SidePair<std::atomic<PackingStatus>*> packing_status;
   TuningResolver* tuning_resolver;
   Allocator* local_allocator;
 
-  // Local indicators of packedness to avoid the overhead of atomic ops.
-  SidePair<bool*> local_packed;
+  // Local indicators of packedness to avoid the overhead of atomic ops, for
+  // each group.
+  SidePair<bool*>* local_packed;
 };
 
-void AllocatePMatrix(Allocator* allocator, PEMat* packed) {
-  packed->data = allocator->AllocateBytes(DataBytes(*packed));
-  packed->sums = allocator->AllocateBytes(SumsBytes(*packed));
+// Returns whether the destination block [start, end) contains any value that
+// is needed according to the DstMask. Blocks may extend into the padding of
+// the packed matrices, so they are clamped to the destination dimensions.
+bool IsDstBlockNeeded(const DstMask& mask, const SidePair<int>& start,
+                      const SidePair<int>& end, int rows, int cols) {
+  const int start_row = start[Side::kLhs];
+  const int start_col = start[Side::kRhs];
+  const int end_row = std::min(end[Side::kLhs], rows);
+  const int end_col = std::min(end[Side::kRhs], cols);
+  if (start_row >= end_row || start_col >= end_col) {
+    return false;
+  }
+  switch (mask.type) {
+    case DstMaskType::kLowerTriangular:
+      return start_col <= end_row - 1 + mask.diagonal_offset;
+    case DstMaskType::kUpperTriangular:
+      return end_col - 1 >= start_row + mask.diagonal_offset;
+    case DstMaskType::kCustom:
+      return mask.block_predicate(start_row, start_col, end_row, end_col,
+                                  mask.user_data);
+    default:
+      return true;
+  }
+}
+
+// Replaces the packed matrix on the given side by a compact one made of the
+// selected columns only, see TrMulParams::selected_indices, so that the rest of
+// TrMul proceeds as if the source matrix only had these columns. The compact
+// matrix is not prepacked: PackColumns fills it like any other packed matrix,
+// from the full source matrix or its full prepacked matrix, e.g. cached.
+void SelectPackedColumns(Side side, TrMulParams* params) {
+  const int* indices = params->selected_indices[side];
+  const int count = side == Side::kLhs ? params->dst.layout.rows
+                                       : params->dst.layout.cols;
+  EMat& src = params->src[side];
+  PEMat& packed = params->packed[side];
+  for (int i = 0; i < count; i++) {
+    RUY_DCHECK_GE(indices[i], 0);
+    RUY_DCHECK_LT(indices[i], src.layout.cols);
+  }
+  params->selection_src[side] = src;
+  params->selection_packed[side] = packed;
+  if (!params->is_prepacked[side]) {
+    params->selection_packed[side].data = nullptr;
+  }
+  packed.layout.cols = round_up_pot(count, packed.layout.kernel.cols);
+  params->is_prepacked[side] = false;
+  src.layout.cols = count;
 }
 
 int GetThreadCount(Ctx* ctx, int rows, int cols, int depth) {
@@ -239,7 +608,16 @@ int GetThreadCount(Ctx* ctx, int rows, int cols, int depth) {
   static constexpr int kDivisorLog2 = 15;
   const int guess_log2 = std::max(
       0, ceil_log2(rows) + ceil_log2(cols) + ceil_log2(depth) - kDivisorLog2);
-  return std::min(1 << guess_log2, ctx->max_num_threads());
+  int max_num_threads = ctx->max_num_threads();
+  // When recent TrMuls have had threads starting late, typically because of
+  // other processes competing for the CPUs, fewer threads are used, so that
+  // the remaining ones are more likely to be scheduled promptly.
+  const float straggler_rate = ctx->straggler_rate();
+  if (straggler_rate > 0) {
+    max_num_threads = std::max(
+        1, static_cast<int>(std::ceil(max_num_threads * (1 - straggler_rate))));
+  }
+  return std::min(1 << guess_log2, max_num_threads);
 }
 
 LoopStructure GetLoopStructure(int tentative_thread_count, int rows, int cols,
@@ -259,29 +637,16 @@ LoopStructure GetLoopStructure(int tentative_thread_count, int rows, int cols,
   return LoopStructure::kGeneral;
 }
 
-}  // namespace
-
-void TrMul(TrMulParams* params, Ctx* ctx) {
-  profiler::ScopeLabel label(
-      "TrMul (Path=0x%x, max_num_threads=%d, is_prepacked=(%d,%d))",
-      static_cast<int>(params->path), ctx->max_num_threads(),
-      params->is_prepacked[Side::kLhs], params->is_prepacked[Side::kRhs]);
-
-  PEMat& packed_lhs = params->packed[Side::kLhs];
-  PEMat& packed_rhs = params->packed[Side::kRhs];
-  EMat& lhs = params->src[Side::kLhs];
-  EMat& rhs = params->src[Side::kRhs];
-
-  const int rows = lhs.layout.cols;
-  const int cols = rhs.layout.cols;
-  const int depth = lhs.layout.rows;
-
-  const int tentative_thread_count = GetThreadCount(ctx, rows, cols, depth);
-  const auto loop_structure = GetLoopStructure(
-      tentative_thread_count, rows, cols, depth, lhs.data_type.size,
-      rhs.data_type.size, params->local_data_cache_size,
-      params->shared_data_cache_size);
-  Allocator* allocator = ctx->GetMainAllocator();
+// Prepares the packed matrices of a TrMul: reduces them to the selected
+// columns, if any, and allocates those that are not prepacked.
+void PreparePackedMatrices(TrMulParams* params, Allocator* allocator) {
+  // Reduce the packed matrices to the selected rows of the LHS and columns of
+  // the RHS, if any.
+  for (Side side : {Side::kLhs, Side::kRhs}) {
+    if (params->selected_indices[side]) {
+      SelectPackedColumns(side, params);
+    }
+  }
 
   // Allocate packed matrices
   for (Side side : {Side::kLhs, Side::kRhs}) {
@@ -289,61 +654,135 @@ void TrMul(TrMulParams* params, Ctx* ctx) {
       AllocatePMatrix(allocator, &params->packed[side]);
     }
   }
-
-  // Case of running this TrMul as a simple loop.
-  // This is a good place to start reading this function: all the rest
-  // of this function is just an optimized, but functionally equivalent,
-  // version of that.
-  if (loop_structure == LoopStructure::kSimple) {
-    profiler::ScopeLabel label_simple("TrMulImpl, simple loop");
-    Tuning tuning = ctx->GetMainThreadTuning();
-
-    const SidePair<int> origin{0, 0};
-    const SidePair<int> rounded_dims{packed_lhs.layout.cols,
-                                     packed_rhs.layout.cols};
-    for (Side side : {Side::kLhs, Side::kRhs}) {
-      if (!params->is_prepacked[side]) {
-        params->RunPack(side, tuning, origin[side], rounded_dims[side]);
-      }
-    }
-    params->RunKernel(tuning, origin, rounded_dims);
-
-    allocator->FreeAll();
-    return;
+  if (params->is_gated()) {
+    AllocatePMatrix(allocator, &params->packed_gate);
   }
+  // Track zero slices of the packed RHS, unless it is prepacked.
+  PEMat& packed_rhs = params->packed[Side::kRhs];
+  if (params->run_zero_rhs_kernel && !params->is_prepacked[Side::kRhs]) {
+    allocator->Allocate(ZeroSlicesBytes(packed_rhs), &packed_rhs.zero_slices);
+  }
+}
 
-  profiler::ScopeLabel label_general("TrMulImpl, general case");
-
-  // Initialize block map.
-  BlockMap block_map;
+// Initializes the block map of a group, and with a DstMask, lists the blocks
+// that contain needed values, so that the threads only share these among
+// themselves, and records which panels these blocks use, so that the other
+// panels are not packed ahead.
+void InitTrMulGroup(TrMulParams* params, int tentative_thread_count,
+                    Allocator* allocator, TrMulGroup* group) {
+  group->params = params;
+  const PEMat& packed_lhs = params->packed[Side::kLhs];
+  const PEMat& packed_rhs = params->packed[Side::kRhs];
+  const int rows = params->src[Side::kLhs].layout.cols;
+  const int cols = params->src[Side::kRhs].layout.cols;
+  const int depth = params->src[Side::kLhs].layout.rows;
+  BlockMap& block_map = group->block_map;
   MakeBlockMap(packed_lhs.layout.cols, packed_rhs.layout.cols, depth,
                packed_lhs.layout.kernel.cols, packed_rhs.layout.kernel.cols,
                packed_lhs.data_type.size, packed_rhs.data_type.size,
                tentative_thread_count, params->local_data_cache_size,
                params->shared_data_cache_size, &block_map);
 
+  group->num_blocks = NumBlocks(block_map);
+  if (params->dst_mask.type == DstMaskType::kNone) {
+    return;
+  }
+  int* active_blocks;
+  allocator->Allocate(group->num_blocks, &active_blocks);
+  for (Side side : {Side::kLhs, Side::kRhs}) {
+    const int size = NumBlocksPerSide(side, block_map);
+    allocator->Allocate(size, &group->needed_panels[side]);
+    memset(group->needed_panels[side], 0, size * sizeof(bool));
+  }
+  int num_active_blocks = 0;
+  SidePair<int> block;
+  SidePair<int> start;
+  SidePair<int> end;
+  for (int i = 0; i < group->num_blocks; i++) {
+    GetBlockByIndex(block_map, i, &block);
+    GetBlockMatrixCoords(block_map, block, &start, &end);
+    if (IsDstBlockNeeded(params->dst_mask, start, end, rows, cols)) {
+      active_blocks[num_active_blocks++] = i;
+      for (Side side : {Side::kLhs, Side::kRhs}) {
+        group->needed_panels[side][block[side]] = true;
+      }
+    }
+  }
+  group->active_blocks = active_blocks;
+  group->num_blocks = num_active_blocks;
+}
+
+// The general loop, computing the given TrMuls in a single dispatch to the
+// thread pool. Their packed matrices must have been prepared.
+// With `chained`, the RHS of each group is the destination of the previous
+// group, see ChainedTrMul.
+void RunGeneralLoop(TrMulParams* params, int num_groups,
+                    int tentative_thread_count, Ctx* ctx,
+                    Allocator* allocator, bool chained = false) {
+  // Initialize the groups, with consecutive block ids.
+  TrMulGroup* groups;
+  allocator->Allocate(num_groups, &groups);
+  int* group_block_offsets;
+  allocator->Allocate(num_groups + 1, &group_block_offsets);
+  group_block_offsets[0] = 0;
+  int max_thread_count = 1;
+  for (int g = 0; g < num_groups; g++) {
+    new (groups + g) TrMulGroup;
+    InitTrMulGroup(params + g, tentative_thread_count, allocator, groups + g);
+    group_block_offsets[g + 1] = group_block_offsets[g] + groups[g].num_blocks;
+    max_thread_count =
+        std::max(max_thread_count, groups[g].block_map.thread_count);
+  }
+  const int num_blocks = group_block_offsets[num_groups];
+
   // Initialize per-thread state.
-  const int thread_count = block_map.thread_count;
+  const int thread_count =
+      std::max(1, std::min(max_thread_count, num_blocks));
   const bool need_atomics = thread_count > 1;
   ctx->EnsureThreadSpecificResources(thread_count);
   for (int i = 0; i < thread_count; i++) {
     ctx->GetThreadSpecificTuningResolver(i)->SetTuning(ctx->explicit_tuning());
   }
 
-  // In the need_atomics case, allocate and initialize atomic values tracking
-  // the packing status of blocks.
-  SidePair<std::atomic<PackingStatus>*> packing_status{nullptr, nullptr};
-  if (need_atomics) {
-    for (Side side : {Side::kLhs, Side::kRhs}) {
-      if (!params->is_prepacked[side]) {
-        const int size = NumBlocksPerSide(side, block_map);
-        allocator->Allocate(size, &packing_status[side]);
-        for (int i = 0; i < size; i++) {
-          packing_status[side][i].store(PackingStatus::kNotStarted,
-                                        std::memory_order_relaxed);
+  for (int g = 0; g < num_groups; g++) {
+    TrMulGroup& group = groups[g];
+    // In a chain, track the progress of the columns of each group but the
+    // last, on which the next group depends.
+    if (chained && g + 1 < num_groups) {
+      const int size = NumBlocksPerSide(Side::kRhs, group.block_map);
+      allocator->Allocate(size, &group.complete_blocks_per_col_block);
+      for (int i = 0; i < size; i++) {
+        new (group.complete_blocks_per_col_block + i) std::atomic<int>(0);
+      }
+      groups[g + 1].rhs_producer = &group;
+    }
+    // In the need_atomics case, allocate and initialize atomic values
+    // tracking the packing status of blocks.
+    if (need_atomics) {
+      for (Side side : {Side::kLhs, Side::kRhs}) {
+        if (!group.params->is_prepacked[side]) {
+          const int size = NumBlocksPerSide(side, group.block_map);
+          allocator->Allocate(size, &group.packing_status[side]);
+          for (int i = 0; i < size; i++) {
+            group.packing_status[side][i].store(PackingStatus::kNotStarted,
+                                                std::memory_order_relaxed);
+          }
         }
       }
     }
+    // Allocate and initialize the per-thread buffers of partial reductions of
+    // the destination, if any.
+    if (group.params->has_dst_reductions()) {
+      const int partials_bytes = group.params->dst_reduction_partials_bytes;
+      const EMat& dst = group.params->dst;
+      allocator->Allocate(thread_count * partials_bytes,
+                          &group.dst_reduction_partials);
+      for (int i = 0; i < thread_count; i++) {
+        group.params->init_dst_reduction_partials(
+            dst.layout.rows, dst.layout.cols,
+            group.dst_reduction_partials + i * partials_bytes);
+      }
+    }
   }
 
   // Create the atomic block id, allocate it using Allocator so that
@@ -351,29 +790,202 @@ void TrMul(TrMulParams* params, Ctx* ctx) {
   // reservation granule.
   std::atomic<int>* atomic_block_id;
   allocator->Allocate(1, &atomic_block_id);
+  std::atomic<bool>* initial_block_claimed;
+  allocator->Allocate(thread_count, &initial_block_claimed);
+  std::atomic<bool>* straggled;
+  allocator->Allocate(1, &straggled);
 
   // Create task objects.
   TrMulTask* tasks;
   allocator->Allocate(thread_count, &tasks);
 
   atomic_block_id->store(thread_count);
+  for (int i = 0; i < thread_count; i++) {
+    new (initial_block_claimed + i) std::atomic<bool>(false);
+  }
+  new (straggled) std::atomic<bool>(false);
+  const TimePoint start_time = thread_count > 1 ? Now() : TimePoint();
+
+  // Threads done with their blocks prefetch the start of the packed matrix
+  // requested by Ctx::PrefetchPacked, up to half of the shared cache so as to
+  // leave the rest to the blocks still running.
+  PrefetchRegion* prefetch_region = nullptr;
+  const PEMat* packed_to_prefetch = ctx->TakePackedToPrefetch();
+  if (thread_count > 1 && packed_to_prefetch) {
+    allocator->Allocate(1, &prefetch_region);
+    new (prefetch_region) PrefetchRegion;
+    const int bytes = std::min(DataBytes(*packed_to_prefetch),
+                               params[0].shared_data_cache_size / 2);
+    prefetch_region->data = static_cast<const char*>(packed_to_prefetch->data);
+    // Only whole chunks, so as not to read past the end of the buffer.
+    prefetch_region->num_chunks = bytes / PrefetchRegion::kChunkBytes;
+  }
 
   for (int i = 0; i < thread_count; i++) {
     auto* allocator = ctx->GetThreadSpecificAllocator(i);
     auto* tuning_resolver = ctx->GetThreadSpecificTuningResolver(i);
-    new (tasks + i)
-        TrMulTask(params, block_map, atomic_block_id, i, need_atomics,
-                  packing_status, tuning_resolver, allocator);
+    new (tasks + i) TrMulTask(
+        groups, num_groups, group_block_offsets, atomic_block_id,
+        initial_block_claimed, straggled, start_time, prefetch_region, i,
+        thread_count, need_atomics, tuning_resolver, allocator);
   }
 
   // Do the computation.
   ctx->mutable_thread_pool()->Execute(thread_count, tasks);
+  if (thread_count > 1) {
+    ctx->UpdateStragglerRate(straggled->load(std::memory_order_relaxed),
+                             kStragglerRateWeight);
+  }
+
+  // Merge the partial reductions of all threads.
+  for (int g = 0; g < num_groups; g++) {
+    const TrMulParams& group_params = *groups[g].params;
+    if (group_params.has_dst_reductions()) {
+      group_params.merge_dst_reduction_partials(
+          group_params.mul_params, group_params.dst.layout.rows,
+          group_params.dst.layout.cols, thread_count,
+          groups[g].dst_reduction_partials);
+    }
+  }
 
   // Finish up.
   for (int i = 0; i < thread_count; i++) {
     tasks[i].~TrMulTask();
   }
+  for (int g = 0; g < num_groups; g++) {
+    groups[g].~TrMulGroup();
+  }
+}
+
+}  // namespace
+
+void TrMul(TrMulParams* params, Ctx* ctx) {
+  profiler::ScopeLabel label(
+      "TrMul (Path=0x%x, max_num_threads=%d, is_prepacked=(%d,%d))",
+      static_cast<int>(params->path), ctx->max_num_threads(),
+      params->is_prepacked[Side::kLhs], params->is_prepacked[Side::kRhs]);
+
+  ctx->set_last_trmul_path(params->path);
+  Allocator* allocator = ctx->GetMainAllocator();
+  PreparePackedMatrices(params, allocator);
+
+  PEMat& packed_lhs = params->packed[Side::kLhs];
+  PEMat& packed_rhs = params->packed[Side::kRhs];
+  EMat& lhs = params->src[Side::kLhs];
+  EMat& rhs = params->src[Side::kRhs];
+
+  const int rows = lhs.layout.cols;
+  const int cols = rhs.layout.cols;
+  const int depth = lhs.layout.rows;
+
+  const int tentative_thread_count = GetThreadCount(ctx, rows, cols, depth);
+  const bool has_dst_mask = params->dst_mask.type != DstMaskType::kNone;
+  // Skipping masked blocks requires a block map, hence the general loop.
+  const auto loop_structure =
+      has_dst_mask ? LoopStructure::kGeneral
+                   : GetLoopStructure(tentative_thread_count, rows, cols, depth,
+                                      lhs.data_type.size, rhs.data_type.size,
+                                      params->local_data_cache_size,
+                                      params->shared_data_cache_size);
+
+  // Case of running this TrMul as a simple loop.
+  // This is a good place to start reading this function: all the rest
+  // of this function is just an optimized, but functionally equivalent,
+  // version of that.
+  if (loop_structure == LoopStructure::kSimple) {
+    profiler::ScopeLabel label_simple("TrMulImpl, simple loop");
+    // There are no idle threads to prefetch anything.
+    ctx->TakePackedToPrefetch();
+    Tuning tuning = ctx->GetMainThreadTuning();
+
+    const SidePair<int> origin{0, 0};
+    const SidePair<int> rounded_dims{packed_lhs.layout.cols,
+                                     packed_rhs.layout.cols};
+    for (Side side : {Side::kLhs, Side::kRhs}) {
+      if (!params->is_prepacked[side]) {
+        PackColumns(params, side, tuning, origin[side], rounded_dims[side],
+                    allocator);
+      }
+    }
+    params->RunKernel(tuning, origin, rounded_dims);
+    if (params->has_dst_reductions()) {
+      void* partials =
+          allocator->AllocateBytes(params->dst_reduction_partials_bytes);
+      params->init_dst_reduction_partials(rows, cols, partials);
+      params->ReduceDstBlock(origin, rounded_dims, partials);
+      params->merge_dst_reduction_partials(params->mul_params, rows, cols, 1,
+                                           partials);
+    }
+
+    allocator->FreeAll();
+    return;
+  }
+
+  profiler::ScopeLabel label_general("TrMulImpl, general case");
+  RunGeneralLoop(params, 1, tentative_thread_count, ctx, allocator);
+  allocator->FreeAll();
+}
+
+void GroupedTrMul(TrMulParams* params, int num_groups, Ctx* ctx) {
+  profiler::ScopeLabel label("GroupedTrMul (num_groups=%d, max_num_threads=%d)",
+                             num_groups, ctx->max_num_threads());
+
+  Allocator* allocator = ctx->GetMainAllocator();
+
+  // Pack the shared RHS in full, once, before each group selects its columns.
+  PEMat packed_rhs = params[0].packed[Side::kRhs];
+  if (!params[0].is_prepacked[Side::kRhs]) {
+    AllocatePMatrix(allocator, &packed_rhs);
+    params[0].run_pack[Side::kRhs](ctx->GetMainThreadTuning(),
+                                   params[0].src[Side::kRhs], &packed_rhs, 0,
+                                   packed_rhs.layout.cols);
+  }
+  for (int g = 0; g < num_groups; g++) {
+    RUY_DCHECK(params[g].selected_indices[Side::kRhs]);
+    params[g].packed[Side::kRhs] = packed_rhs;
+    params[g].is_prepacked[Side::kRhs] = true;
+  }
+
+  // The thread count is guessed from the overall work, as groups typically
+  // share their rows and depth but each have few columns.
+  int rows = 0;
+  int cols = 0;
+  int depth = 0;
+  for (int g = 0; g < num_groups; g++) {
+    PreparePackedMatrices(params + g, allocator);
+    rows = std::max(rows, params[g].src[Side::kLhs].layout.cols);
+    cols += params[g].src[Side::kRhs].layout.cols;
+    depth = std::max(depth, params[g].src[Side::kLhs].layout.rows);
+  }
+  const int tentative_thread_count = GetThreadCount(ctx, rows, cols, depth);
+  RunGeneralLoop(params, num_groups, tentative_thread_count, ctx, allocator);
+  allocator->FreeAll();
+}
+
+void ChainedTrMul(TrMulParams* params, int num_trmuls, Ctx* ctx) {
+  profiler::ScopeLabel label("ChainedTrMul (num_trmuls=%d, max_num_threads=%d)",
+                             num_trmuls, ctx->max_num_threads());
 
+  Allocator* allocator = ctx->GetMainAllocator();
+
+  // The thread count is that of the largest TrMul: with more threads than
+  // that, the threads done with one TrMul would mostly be waiting for the
+  // next one.
+  int tentative_thread_count = 1;
+  for (int g = 0; g < num_trmuls; g++) {
+    RUY_DCHECK(params[g].dst_mask.type == DstMaskType::kNone);
+    RUY_DCHECK(!params[g].selected_indices[Side::kLhs]);
+    RUY_DCHECK(!params[g].selected_indices[Side::kRhs]);
+    RUY_DCHECK(g == 0 || !params[g].is_prepacked[Side::kRhs]);
+    PreparePackedMatrices(params + g, allocator);
+    const int rows = params[g].src[Side::kLhs].layout.cols;
+    const int cols = params[g].src[Side::kRhs].layout.cols;
+    const int depth = params[g].src[Side::kLhs].layout.rows;
+    tentative_thread_count = std::max(tentative_thread_count,
+                                      GetThreadCount(ctx, rows, cols, depth));
+  }
+  RunGeneralLoop(params, num_trmuls, tentative_thread_count, ctx, allocator,
+                 /*chained=*/true);
   allocator->FreeAll();
 }
 
@@ -34,6 +34,20 @@ namespace ruy {
 struct ContextInternal;
 void TrMul(TrMulParams* params, Ctx* ctx);
 
+// Computes the num_groups TrMuls described by params[0..num_groups-1] in a
+// single dispatch to the thread pool, sharing the threads among all of their
+// blocks. Always uses the general loop, even for small groups. All TrMuls must
+// have the same RHS source matrix, which is packed only once, and select some
+// of its columns, see TrMulParams::selected_indices.
+void GroupedTrMul(TrMulParams* params, int num_groups, Ctx* ctx);
+
+// Computes the num_trmuls TrMuls described by params[0..num_trmuls-1], where
+// the RHS of each TrMul but the first is the destination of the previous one,
+// in a single dispatch to the thread pool. Blocks of each TrMul start as soon
+// as the RHS columns that they use are computed, instead of after the whole
+// previous TrMul. Always uses the general loop.
+void ChainedTrMul(TrMulParams* params, int num_trmuls, Ctx* ctx);
+
 }  // namespace ruy
 
 #endif  // RUY_RUY_TRMUL_H_
@@ -17,6 +17,7 @@ limitations under the License.
 #define RUY_RUY_TRMUL_PARAMS_H_
 
 #include "ruy/mat.h"
+#include "ruy/mul_params.h"
 #include "ruy/side_pair.h"
 #include "ruy/tune.h"
 
@@ -27,17 +28,79 @@ using RunKernelFn = void(Tuning, const SidePair<PEMat>&, void*,
 
 using RunPackFn = void(Tuning, const EMat&, PEMat*, int, int);
 
+using InitDstReductionPartialsFn = void(int, int, void*);
+
+using ReduceDstBlockFn = void(const EMat&, void*, const SidePair<int>&,
+                              const SidePair<int>&, void*);
+
+using MergeDstReductionPartialsFn = void(void*, int, int, int, const void*);
+
+using RunZeroRhsKernelFn = void(void*, const SidePair<int>&,
+                                const SidePair<int>&, EMat*);
+
+using RunGatedKernelFn = void(Tuning, const SidePair<PEMat>&, const PEMat&,
+                              void*, const SidePair<int>&,
+                              const SidePair<int>&, EMat*);
+
 // Type-erased data needed for implementing TrMul.
 struct TrMulParams {
   TrMulParams() : run_pack{nullptr, nullptr}, is_prepacked{false, false} {}
   // Helper functions for invoking the function pointers.
   void RunPack(Side side, Tuning tuning, int start, int end) {
     run_pack[side](tuning, src[side], &packed[side], start, end);
+    if (side == Side::kLhs && is_gated()) {
+      // The gate is packed along with the LHS, sharing its blocks.
+      run_pack[side](tuning, gate, &packed_gate, start, end);
+    }
+    if (packed[side].zero_slices) {
+      FindZeroSlices(&packed[side], start, end);
+    }
   }
   void RunKernel(Tuning tuning, const SidePair<int>& start,
                  const SidePair<int>& end) {
+    if (is_gated()) {
+      run_gated_kernel(tuning, packed, packed_gate, mul_params, start, end,
+                       &dst);
+      return;
+    }
+    if (packed[Side::kRhs].zero_slices) {
+      RunKernelSkippingZeroRhsPanels(tuning, start, end);
+      return;
+    }
     run_kernel(tuning, packed, mul_params, start, end, &dst);
   }
+  // Splits the columns of the block into runs of RHS panels that are either
+  // all zero, which run_zero_rhs_kernel handles, or not, which the kernel
+  // handles.
+  void RunKernelSkippingZeroRhsPanels(Tuning tuning, const SidePair<int>& start,
+                                      const SidePair<int>& end) {
+    const PEMat& packed_rhs = packed[Side::kRhs];
+    const int panel_cols = packed_rhs.layout.kernel.cols;
+    int run_start = start[Side::kRhs];
+    while (run_start < end[Side::kRhs]) {
+      const bool is_zero = IsZeroPanel(packed_rhs, run_start);
+      int run_end = run_start + panel_cols;
+      while (run_end < end[Side::kRhs] &&
+             IsZeroPanel(packed_rhs, run_end) == is_zero) {
+        run_end += panel_cols;
+      }
+      const SidePair<int> run_start_pair{start[Side::kLhs], run_start};
+      const SidePair<int> run_end_pair{end[Side::kLhs], run_end};
+      if (is_zero) {
+        run_zero_rhs_kernel(mul_params, run_start_pair, run_end_pair, &dst);
+      } else {
+        run_kernel(tuning, packed, mul_params, run_start_pair, run_end_pair,
+                   &dst);
+      }
+      run_start = run_end;
+    }
+  }
+  bool is_gated() const { return gate.data != nullptr; }
+  void ReduceDstBlock(const SidePair<int>& start, const SidePair<int>& end,
+                      void* partials) {
+    reduce_dst_block(dst, mul_params, start, end, partials);
+  }
+  bool has_dst_reductions() const { return reduce_dst_block != nullptr; }
 
   // path id, can be useful info for some fine-tuning, e.g. to guess reasonable
   // cache sizes when not runtime-detectable.
@@ -60,6 +123,39 @@ struct TrMulParams {
 
   // Type-erased MulParamsType.
   void* mul_params = nullptr;
+
+  // Only for GatedMul: the gate matrix, which has the same shape as the LHS,
+  // its packed form, and the kernel computing the gated product.
+  EMat gate;
+  PEMat packed_gate;
+  RunGatedKernelFn* run_gated_kernel = nullptr;
+
+  // Only when MulParams requests reductions of the destination values: each
+  // thread reduces the blocks that it computed into its own buffer of
+  // dst_reduction_partials_bytes, and these buffers are merged at the end.
+  int dst_reduction_partials_bytes = 0;
+  InitDstReductionPartialsFn* init_dst_reduction_partials = nullptr;
+  ReduceDstBlockFn* reduce_dst_block = nullptr;
+  MergeDstReductionPartialsFn* merge_dst_reduction_partials = nullptr;
+
+  // Only when MulParams selects rows of the LHS or columns of the RHS: for each
+  // side, the selected columns of the (transposed) source matrix, as many as
+  // the destination has rows or columns respectively. TrMul then replaces the
+  // packed matrix by a compact one made of the selected columns only, which the
+  // threads fill block by block from the full source matrix selection_src, or
+  // from its full packed matrix selection_packed if it is prepacked (otherwise,
+  // selection_packed.data is null).
+  SidePair<const int*> selected_indices{nullptr, nullptr};
+  SidePair<EMat> selection_src;
+  SidePair<PEMat> selection_packed;
+
+  // Only with MulParams::skip_zero_rhs_slices: computes blocks whose packed
+  // RHS is zero. TrMul then tracks zero slices of the packed RHS.
+  RunZeroRhsKernelFn* run_zero_rhs_kernel = nullptr;
+
+  // Which destination values are needed. TrMul skips the blocks that contain
+  // none of them.
+  DstMask dst_mask;
 };
 
 }  // namespace ruy